@@ -2,16 +2,33 @@
 
 #include <opencv2/core/core.hpp>
 
+#include <functional>
+#include <future>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "yolo26_image.h"
+#include "yolo26_input.h"
 #include "yolo26_types.h"
+#include "yolo26_workspace.h"
 
 namespace ncnn {
 class Net;
 }
 
+namespace yolo26 {
+class LetterBoxPlan;
+class LetterBoxPlanCache;
+class ShapeBuckets;
+class ThreadPool;
+class AllocatorPool;
+class AsyncQueue;
+class MappedFile;
+struct LoadedModel;
+class ModelSlot;
+}
+
 struct Yolo26Object {
     float x1 = 0.f;
     float y1 = 0.f;
@@ -21,6 +38,18 @@ struct Yolo26Object {
     float prob = 0.f;
 };
 
+// Caller-owned structure-of-arrays output for Yolo26::detect_into(): each array holds `capacity`
+// entries, and detection i is (x1[i], y1[i], x2[i], y2[i], score[i], label[i]).
+struct Yolo26Detections {
+    float* x1 = nullptr;
+    float* y1 = nullptr;
+    float* x2 = nullptr;
+    float* y2 = nullptr;
+    float* score = nullptr;
+    int* label = nullptr;
+    int capacity = 0;
+};
+
 struct Yolo26Config {
     int input_width = 640;
     int input_height = 640;
@@ -31,26 +60,218 @@ struct Yolo26Config {
     int padding_value = 114;
     bool scaleup = true;
     bool center = true;
+    // Minimal padding ("rect", Ultralytics auto=True): pad each side only up to a multiple of
+    // rect_stride instead of to input_width x input_height. Needs a dynamic-shape export.
+    bool rect = false;
+    int rect_stride = 32;
+    int rect_max_shapes = 8;  // distinct rect shapes kept (warmed by warmup() / reload()), others run at the full input size
+    // Model exported with --fold-preprocess (1/255 and RGB -> BGR folded into the first conv):
+    // feed raw BGR 0..255 and skip the per-frame normalization and channel swap.
+    bool raw_bgr_input = false;
+    // Tiled (sliced) inference for images much larger than the input: overlapping
+    // input_width x input_height tiles at native resolution run on a worker pool and are merged with
+    // cross-tile NMS in original coordinates. Images that fit in one tile take the normal path.
+    bool tiled = false;
+    float tile_overlap = 0.2f;   // fraction of a tile shared with its neighbour
+    bool tile_full_pass = true;  // also run the letterboxed full image, for objects larger than a tile
+    int tile_workers = 0;        // concurrent tiles, 0 = one per big CPU core
+    // detect_mosaic() grid: the input is split into mosaic_cols x mosaic_rows cells, one frame each.
+    int mosaic_cols = 2;
+    int mosaic_rows = 2;
     Yolo26BoxFormat box_format = Yolo26BoxFormat::CXCYWH;
     Yolo26PostprocessType postprocess = Yolo26PostprocessType::Auto;
+    // Auto = inferred by load() from a dry run; any other value must match the model's output shape,
+    // or load() fails.
+    Yolo26OutputLayout output_layout = Yolo26OutputLayout::Auto;
     bool topk_dedup = false;
     bool agnostic_nms = false;
     bool use_gpu = false;
+    int num_threads = 0;  // ncnn threads per extraction, 0 = one per big CPU core
+    // ncnn::Option profile written by yolo26_autotune for this model and machine; load() applies it
+    // (fp16, packing, winograd / sgemm, light mode, and the thread count when num_threads is 0).
+    std::string option_profile;
+    // load() mmaps the .bin and builds the net from memory: weights ncnn does not repack are used in
+    // place, and every instance and process loading the same file shares those pages.
+    bool mmap_model = false;
+    // The model was quantized by yolo26_calibrate: run its int8 layers with ncnn's int8 kernels
+    // (CPU only; use_gpu is ignored).
+    bool int8 = false;
+    // Back the per-call blob / workspace allocators with 2 MB huge pages (Linux; hugetlbfs pages when
+    // vm.nr_hugepages reserves them, transparent huge pages otherwise). Fewer TLB misses on the
+    // multi-megabyte feature maps of large inputs.
+    bool huge_pages = false;
+    // detect_async() workers (0 = async disabled) and how many requests may wait for one before
+    // detect_async() starts rejecting.
+    int async_workers = 0;
+    int async_queue_depth = 16;
+    int batch_workers = 0;  // detect_batch() images in flight, 0 = one per big CPU core
+    std::vector<std::string> class_names;  // filled from bundle metadata, empty otherwise
     std::string input_name = "in0";
     std::string output_name = "out0";
 };
 
+struct Yolo26AsyncResult {
+    bool ok = false;
+    std::vector<Yolo26Object> objects;
+    double queue_ms = 0.0;    // submitted -> picked up by a worker
+    double compute_ms = 0.0;  // detection itself
+};
+
+typedef std::function<void(Yolo26AsyncResult&)> Yolo26AsyncCallback;
+
+// Thread safety: load() must complete before any other call and must not run concurrently with
+// anything. After that every const member may be called from any number of threads at once: the
+// ncnn::Net is only read, and each call leases its own letterbox buffers and pooled blob / workspace
+// allocators, so concurrent callers never share mutable state. Each call still uses
+// config.num_threads ncnn threads; lower it when many callers run in parallel. reload() may run
+// alongside all of them.
 class Yolo26 {
 public:
     explicit Yolo26(const Yolo26Config& config = Yolo26Config());
     ~Yolo26();
 
     bool load(const std::string& param_path, const std::string& bin_path);
+    // Loads from a NUL-terminated .param text and the .bin bytes already in memory. The weights are
+    // referenced, not copied: bin_mem must be 4-byte aligned and stay valid and unchanged until this
+    // object is destroyed, which lets several instances share one copy.
+    bool load_memory(const char* param_mem, const unsigned char* bin_mem);
+    // Single-file bundle from the export script (param + bin + metadata), mapped like mmap_model.
+    // The metadata replaces the model-describing config fields (input size, num_classes, box
+    // format, postprocess, raw BGR input, output layout, blob names, class_names), so nothing has to
+    // be set by hand or probed per frame; thresholds and runtime switches are kept. False when the
+    // bundle is malformed, truncated (its weights must fill bin_size exactly) or holds a segmentation
+    // model; the config is then left as it was.
+    bool load_bundle(const std::string& path);
+    // Zero-downtime model update on a loaded detector, safe while other threads detect: the new
+    // model is loaded (honouring mmap_model) and warmed on the calling thread - at the input size
+    // and every rect shape seen so far - then swapped in atomically. Calls already running finish
+    // on the previous model, which is freed when the last of them returns; later calls use the new
+    // one. The config stays as it is, so the model must keep its input size, classes and blob names.
+    // False, with the previous model still serving, when loading or warming fails. Concurrent
+    // reloads are serialized.
+    bool reload(const std::string& param_path, const std::string& bin_path);
+    Yolo26ReloadStats reload_stats() const;
     bool detect(const cv::Mat& bgr, std::vector<Yolo26Object>& objects) const;
+    bool detect(const Yolo26Image& image, std::vector<Yolo26Object>& objects) const;
+    // With the caller's workspace instead of the calling thread's. Reusing `objects` as well keeps
+    // steady-state postprocessing free of heap allocation.
+    bool detect(const cv::Mat& bgr, std::vector<Yolo26Object>& objects, Yolo26Workspace& workspace) const;
+    bool detect(const Yolo26Image& image, std::vector<Yolo26Object>& objects, Yolo26Workspace& workspace) const;
+    // Writes the first min(capacity, max_det) detections, in detect()'s order, into the caller's
+    // arrays and returns how many; -1 on failure. Nothing is allocated once the workspace is warm.
+    // Always a single letterboxed pass: config.tiled does not apply.
+    int detect_into(const cv::Mat& bgr, Yolo26Detections& out, Yolo26Workspace& workspace) const;
+    int detect_into(const Yolo26Image& image, Yolo26Detections& out, Yolo26Workspace& workspace) const;
+
+    // Preprocess once, run several models: prepare() letterboxes the frame for this model's input, and
+    // detect(prepared) on this or any other Yolo26 / Yolo26Seg consumes it without touching the frame.
+    bool prepare(const Yolo26Image& image, Yolo26PreparedInput& prepared) const;
+    bool detect(const Yolo26PreparedInput& prepared, std::vector<Yolo26Object>& objects) const;
+
+    // Many images at once: up to batch_workers of them are letterboxed, extracted and postprocessed
+    // concurrently, each on its share of the cores (config.num_threads when set), with letterbox
+    // buffers, allocators and the workers' workspaces reused from item to item and from batch to
+    // batch (the workers are started by load()). objects[i] belongs to images[i]; false if any
+    // image failed (its entry is left empty).
+    bool detect_batch(const std::vector<cv::Mat>& images, std::vector<std::vector<Yolo26Object>>& objects) const;
+    bool detect_batch(const std::vector<Yolo26Image>& images, std::vector<std::vector<Yolo26Object>>& objects) const;
+
+    // Builds the letterbox plan for a stream of this resolution and runs one dry extraction at its
+    // input shape, so the first real frame does not pay for it. detect() never runs dry extractions
+    // itself; in rect mode, a shape first seen by detect() pays its first extraction in that frame.
+    bool warmup(int src_w, int src_h) const;
+
+    // Mosaic packing for many low-resolution streams: up to mosaic_cols x mosaic_rows frames are
+    // letterboxed into the cells of one input canvas and share a single extraction. objects[i] receives
+    // the detections of images[i] in its own coordinates; boxes crossing a cell border are dropped.
+    bool detect_mosaic(const std::vector<Yolo26Image>& images, std::vector<std::vector<Yolo26Object>>& objects) const;
+
+    // Detects only inside `regions` of `image` (in its pixel coordinates), with one extraction: each
+    // region goes into its own mosaic cell at native resolution, padded and never scaled. Region sizes
+    // are first rounded up to a multiple of 64 within the image, so plans are reused from frame to
+    // frame as regions drift. Boxes of all regions are returned in image coordinates. False when
+    // there are more regions than cells or a rounded region is larger than a cell; run detect() then.
+    bool detect_regions(const Yolo26Image& image, const std::vector<cv::Rect>& regions, std::vector<Yolo26Object>& objects) const;
+
+    // Non-blocking detection on config.async_workers internal threads. The callback runs on a worker
+    // thread once the result is ready. Returns false without queueing when async is disabled or
+    // async_queue_depth requests are already waiting (backpressure: retry later or drop the frame).
+    // A Yolo26Image's pixels must stay valid until the callback; a cv::Mat is kept referenced.
+    // The future variant returns an invalid future (!valid()) when rejected.
+    bool detect_async(const Yolo26Image& image, Yolo26AsyncCallback callback) const;
+    bool detect_async(const cv::Mat& bgr, Yolo26AsyncCallback callback) const;
+    std::future<Yolo26AsyncResult> detect_async(const cv::Mat& bgr) const;
 
     const Yolo26Config& config() const { return config_; }
 
 private:
+    friend class Yolo26Pipeline;
+
+    bool configure_net(ncnn::Net& net) const;
+    // A loaded net with its options applied, or null; plan_model() then resolves its blobs and
+    // output layout with a dry run, and finish_load() makes it current. A nonzero bin_size (mapped
+    // files, bundles) bounds the weight reads and must be consumed exactly.
+    std::unique_ptr<yolo26::LoadedModel> open_model(const std::string& param_path, const std::string& bin_path) const;
+    std::unique_ptr<yolo26::LoadedModel> open_model(const char* param_mem,
+                                                    const unsigned char* bin_mem,
+                                                    const std::shared_ptr<const yolo26::MappedFile>& data,
+                                                    size_t bin_size = 0) const;
+    bool plan_model(yolo26::LoadedModel& model) const;
+    bool finish_load(std::unique_ptr<yolo26::LoadedModel> model);
+    std::shared_ptr<yolo26::LetterBoxPlan> letterbox_plan(int img_w, int img_h) const;
+    // layout: when set, receives the output layout this input produced (Auto if none fits).
+    bool warmup_shape(const yolo26::LoadedModel& model, int input_w, int input_h, Yolo26OutputLayout* layout = 0) const;
+    // One letterboxed inference; num_threads > 0 overrides the net's thread count for this call.
+    bool detect_once(const Yolo26Image& image, int num_threads, std::vector<Yolo26Object>& objects, Yolo26Workspace& workspace) const;
+    // Extraction + postprocess of a letterboxed input; results in img_w x img_h coordinates.
+    bool infer(const ncnn::Mat& in_pad,
+               const yolo26::LetterBoxInfo& lb,
+               int img_w,
+               int img_h,
+               int num_threads,
+               std::vector<Yolo26Object>& objects,
+               Yolo26Workspace& workspace) const;
+    // The two halves of infer(), for Yolo26Pipeline: the raw output copied out of the leased
+    // allocators along with the layout of the model that produced it, and decode + NMS + scaling
+    // back to img_w x img_h.
+    bool extract(const ncnn::Mat& in_pad, ncnn::Mat& out, Yolo26OutputLayout& layout) const;
+    bool postprocess(const ncnn::Mat& out,
+                     Yolo26OutputLayout layout,
+                     const yolo26::LetterBoxInfo& lb,
+                     int img_w,
+                     int img_h,
+                     std::vector<Yolo26Object>& objects,
+                     Yolo26Workspace& workspace) const;
+    // Extraction + decode + NMS of a letterboxed input, and decode + NMS of a raw output: the final
+    // detections in network-input coordinates, left in the workspace.
+    bool infer_proposals(const ncnn::Mat& in_pad, int num_threads, Yolo26Workspace& workspace) const;
+    bool select_proposals(const ncnn::Mat& out, Yolo26OutputLayout layout, Yolo26Workspace& workspace) const;
+    // The workspace's detections scaled to img_w x img_h, into `objects`.
+    void emit_proposals(const Yolo26Workspace& workspace,
+                        const yolo26::LetterBoxInfo& lb,
+                        int img_w,
+                        int img_h,
+                        std::vector<Yolo26Object>& objects) const;
+    bool detect_tiled(const Yolo26Image& src, std::vector<Yolo26Object>& objects) const;
+    // native: each image is padded into its cell without scaling and must fit it (detect_regions).
+    bool detect_canvas(const Yolo26Image* images, int count, std::vector<Yolo26Object>* objects, bool native = false) const;
+    Yolo26PostprocessType postprocess_type() const;
+    // Candidates from the raw output in network-input coordinates, before NMS / de-dup.
+    bool decode(const ncnn::Mat& out,
+                Yolo26OutputLayout layout,
+                std::vector<Yolo26Object>& objects,
+                bool& end2end,
+                Yolo26Workspace& workspace) const;
+    void suppress(std::vector<Yolo26Object>& objects, bool end2end, Yolo26Workspace& workspace) const;
+
     Yolo26Config config_;
-    std::shared_ptr<ncnn::Net> net_;
+    // Net, mapped weights and blob plan, swapped as one by reload().
+    std::shared_ptr<yolo26::ModelSlot> model_;
+    std::shared_ptr<yolo26::LetterBoxPlanCache> letterbox_plans_;
+    std::shared_ptr<yolo26::ShapeBuckets> rect_shapes_;
+    std::shared_ptr<yolo26::ThreadPool> tile_pool_;
+    std::shared_ptr<yolo26::ThreadPool> batch_pool_;  // batch_workers - 1 threads, the caller is the last
+    std::shared_ptr<yolo26::AllocatorPool> allocators_;
+    // Last, so its workers stop while everything they use still exists.
+    std::shared_ptr<yolo26::AsyncQueue> async_;
 };
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <opencv2/core/core.hpp>
+
+#include "yolo26_types.h"
+
+// Non-owning view of a frame in caller memory; nothing is copied or converted up front.
+// Strides are in bytes, 0 means tightly packed. For YUV formats `data` is the Y plane and the
+// chroma planes default to following it contiguously (the usual V4L2 / decoder layout).
+struct Yolo26Image {
+    const unsigned char* data = 0;
+    int width = 0;
+    int height = 0;
+    int stride = 0;
+    Yolo26PixelFormat format = Yolo26PixelFormat::BGR;
+
+    const unsigned char* data_uv = 0;  // NV12/NV21: interleaved chroma plane, I420: U plane
+    int stride_uv = 0;
+    const unsigned char* data_v = 0;   // I420: V plane
+    int stride_v = 0;
+
+    // Size of the original image when this view is a reduced decode of it (see yolo26_imread);
+    // results are then reported in original coordinates. 0 means width / height.
+    int orig_width = 0;
+    int orig_height = 0;
+};
+
+// Wraps a CV_8UC3 (BGR), CV_8UC4 (BGRA) or CV_8UC1 (GRAY) cv::Mat, ROIs included, without copying.
+// Returns an empty view (data == 0) for other types.
+inline Yolo26Image yolo26_image_from_mat(const cv::Mat& mat)
+{
+    Yolo26Image image;
+    if (mat.empty() || mat.dims != 2)
+        return image;
+
+    if (mat.type() == CV_8UC3)
+        image.format = Yolo26PixelFormat::BGR;
+    else if (mat.type() == CV_8UC4)
+        image.format = Yolo26PixelFormat::BGRA;
+    else if (mat.type() == CV_8UC1)
+        image.format = Yolo26PixelFormat::GRAY;
+    else
+        return image;
+
+    image.data = mat.data;
+    image.width = mat.cols;
+    image.height = mat.rows;
+    image.stride = (int)mat.step[0];
+    return image;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "mat.h"
+
+namespace yolo26 {
+
+struct LetterBoxInfo {
+    float gain = 1.f;  // resize ratio r
+    int pad_x = 0;     // left padding in pixels
+    int pad_y = 0;     // top padding in pixels
+    int resized_w = 0;
+    int resized_h = 0;
+    int input_w = 0;
+    int input_h = 0;
+    // Original pixels per source pixel when the source is a reduced decode of a larger image.
+    float src_scale_x = 1.f;
+    float src_scale_y = 1.f;
+};
+
+}  // namespace yolo26
+
+// A frame letterboxed and normalized once (Yolo26::prepare / Yolo26Seg::prepare) and then consumed by
+// any number of models via detect(const Yolo26PreparedInput&, ...). Read-only during detection, so
+// several instances may use the same object concurrently. A model whose input geometry differs derives
+// its own input from this one; prepare with the model that has the largest input.
+struct Yolo26PreparedInput {
+    ncnn::Mat input;              // input_w x input_h x 3 network input
+    yolo26::LetterBoxInfo info;   // geometry of `input` relative to the source view
+    int src_w = 0;                // source view size that was letterboxed
+    int src_h = 0;
+    int img_w = 0;                // original image size, results are reported in these coordinates
+    int img_h = 0;
+    int padding_value = 114;
+    bool raw_bgr = false;         // BGR 0..255 (--fold-preprocess models) instead of RGB 0..1
+};
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <opencv2/core/core.hpp>
+
+#include <string>
+
+// Reads `path` as BGR for a network with an input_w x input_h input. JPEGs whose letterboxed size is
+// at most 1/2, 1/4 or 1/8 of the original are decoded at that scale in the DCT domain
+// (cv::IMREAD_REDUCED_COLOR_*), which skips most of the decode work for 12-24 MP photos.
+// orig_w / orig_h receive the true image size; set them as Yolo26Image::orig_width / orig_height so
+// detections come back in original coordinates. Returns an empty Mat on failure.
+cv::Mat yolo26_imread(const std::string& path, int input_w, int input_h, int* orig_w = 0, int* orig_h = 0);
+
+// Image size from the JPEG header (SOFn marker) without decoding. False for other formats.
+bool yolo26_read_jpeg_size(const std::string& path, int& width, int& height);
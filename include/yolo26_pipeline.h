@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "yolo26.h"
+
+namespace yolo26 {
+template <typename T>
+class SpscQueue;
+}
+
+// Streams frames through three stages on threads of their own -- letterbox, ncnn extraction, and
+// decode / NMS / scaling -- connected by bounded lock-free queues, so frame N+1 is preprocessed and
+// frame N-1 postprocessed while frame N is inside ncnn. Results come out in push order.
+// Frames take the whole-image letterbox path (rect mode applies, tiling does not).
+// push() and pop() may each be called from one thread, the same or two different ones. At most
+// depth() frames are in flight and push() waits while that many are pending, so a single thread must
+// pop() before pushing again once pending() == depth(). `detector` must outlive the pipeline.
+class Yolo26Pipeline {
+public:
+    explicit Yolo26Pipeline(const Yolo26& detector, int depth = 4);
+    ~Yolo26Pipeline();
+
+    Yolo26Pipeline(const Yolo26Pipeline&) = delete;
+    Yolo26Pipeline& operator=(const Yolo26Pipeline&) = delete;
+
+    // The pixels of `frame` must stay valid until its result is popped; a cv::Mat is kept referenced.
+    bool push(const Yolo26Image& frame);
+    bool push(const cv::Mat& bgr);
+    // Detections of the oldest pushed frame, waiting for them if needed. False when nothing is
+    // pending or that frame failed.
+    bool pop(std::vector<Yolo26Object>& objects);
+
+    int depth() const { return (int)frames_.size(); }
+    int pending() const { return pending_; }
+
+private:
+    struct Frame;
+    typedef yolo26::SpscQueue<Frame*> Queue;
+
+    bool push_frame(const Yolo26Image& frame, const cv::Mat& hold);
+    void preprocess_loop();
+    void infer_loop();
+    void postprocess_loop();
+
+    const Yolo26& detector_;
+    std::vector<std::unique_ptr<Frame>> frames_;
+    // free -> preprocess -> infer -> postprocess -> done -> free
+    std::unique_ptr<Queue> free_;
+    std::unique_ptr<Queue> to_preprocess_;
+    std::unique_ptr<Queue> to_infer_;
+    std::unique_ptr<Queue> to_postprocess_;
+    std::unique_ptr<Queue> done_;
+    std::atomic<int> pending_{0};
+    std::atomic<bool> stop_{false};
+    std::vector<std::thread> threads_;
+};
@@ -2,16 +2,35 @@
 
 #include <opencv2/core/core.hpp>
 
+#include <functional>
+#include <future>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "yolo26_image.h"
+#include "yolo26_input.h"
 #include "yolo26_types.h"
+#include "yolo26_workspace.h"
 
 namespace ncnn {
 class Net;
 }
 
+namespace yolo26 {
+class LetterBoxPlan;
+class LetterBoxPlanCache;
+class ShapeBuckets;
+class ThreadPool;
+class AllocatorPool;
+class AsyncQueue;
+class MappedFile;
+struct LoadedModel;
+class ModelSlot;
+class MemoryBudget;
+class MemoryStatsRecorder;
+}
+
 struct Yolo26SegObject {
     float x1 = 0.f;
     float y1 = 0.f;
@@ -19,7 +38,11 @@ struct Yolo26SegObject {
     float y2 = 0.f;
     int label = -1;
     float prob = 0.f;
+    // Binary mask at original resolution. Tiled inference returns it cropped to the object, with its
+    // top-left pixel at mask_offset in the image; everywhere else it covers the image and the offset
+    // is (0, 0).
     cv::Mat mask;
+    cv::Point mask_offset;
 };
 
 struct Yolo26SegConfig {
@@ -32,29 +55,189 @@ struct Yolo26SegConfig {
     int padding_value = 114;
     bool scaleup = true;
     bool center = true;
+    // Minimal padding ("rect", Ultralytics auto=True): pad each side only up to a multiple of
+    // rect_stride instead of to input_width x input_height. Needs a dynamic-shape export.
+    bool rect = false;
+    int rect_stride = 32;
+    int rect_max_shapes = 8;  // distinct rect shapes kept (warmed by warmup() / reload()), others run at the full input size
+    // Model exported with --fold-preprocess (1/255 and RGB -> BGR folded into the first conv):
+    // feed raw BGR 0..255 and skip the per-frame normalization and channel swap.
+    bool raw_bgr_input = false;
+    // Tiled (sliced) inference for images much larger than the input: overlapping
+    // input_width x input_height tiles at native resolution run on a worker pool and are merged with
+    // cross-tile NMS in original coordinates. Images that fit in one tile take the normal path. Masks
+    // come back cropped to their objects (Yolo26SegObject::mask_offset).
+    bool tiled = false;
+    float tile_overlap = 0.2f;   // fraction of a tile shared with its neighbour
+    bool tile_full_pass = true;  // also run the letterboxed full image, for objects larger than a tile
+    int tile_workers = 0;        // concurrent tiles, 0 = one per big CPU core
     Yolo26BoxFormat box_format = Yolo26BoxFormat::CXCYWH;
     Yolo26PostprocessType postprocess = Yolo26PostprocessType::Auto;
+    // Auto = inferred by load() from a dry run; any other value must match the model's output shape,
+    // or load() fails.
+    Yolo26OutputLayout output_layout = Yolo26OutputLayout::Auto;
     bool topk_dedup = false;
     bool agnostic_nms = false;
     bool retina_masks = false;
     bool use_gpu = false;
+    int num_threads = 0;  // ncnn threads per extraction, 0 = one per big CPU core
+    // ncnn::Option profile written by yolo26_autotune for this model and machine; load() applies it
+    // (fp16, packing, winograd / sgemm, light mode, and the thread count when num_threads is 0).
+    std::string option_profile;
+    // load() mmaps the .bin and builds the net from memory: weights ncnn does not repack are used in
+    // place, and every instance and process loading the same file shares those pages.
+    bool mmap_model = false;
+    // The model was quantized by yolo26_calibrate: run its int8 layers with ncnn's int8 kernels
+    // (CPU only; use_gpu is ignored).
+    bool int8 = false;
+    // Back the per-call blob / workspace allocators with 2 MB huge pages (Linux; hugetlbfs pages when
+    // vm.nr_hugepages reserves them, transparent huge pages otherwise). Fewer TLB misses on the
+    // multi-megabyte feature maps of large inputs.
+    bool huge_pages = false;
+    // Ceiling in bytes on what one call holds at once (0 = none): input tensor, ncnn blobs and
+    // workspace, postprocess scratch and the masks returned. Turns on ncnn light mode and fp16
+    // storage, runs on the CPU (use_gpu is ignored) and keeps at most 10 x max_det candidates for NMS.
+    // A call that would go over fails instead (false, counted in memory_stats()); detect_stream() needs
+    // room for one mask instead of all of them. ncnn's share is the extraction peak measured per input
+    // shape by the dry runs of load() and warmup(), checked before the extraction starts; rect shapes
+    // not yet warmed run at the full input size.
+    size_t memory_budget_bytes = 0;
+    // detect_async() workers (0 = async disabled) and how many requests may wait for one before
+    // detect_async() starts rejecting.
+    int async_workers = 0;
+    int async_queue_depth = 16;
+    int batch_workers = 0;  // detect_batch() images in flight, 0 = one per big CPU core
+    std::vector<std::string> class_names;  // filled from bundle metadata, empty otherwise
     std::string input_name = "in0";
     std::string output_name = "out0";
     std::string proto_name = "out1";
     int mask_dim = 32;
 };
 
+struct Yolo26SegAsyncResult {
+    bool ok = false;
+    std::vector<Yolo26SegObject> objects;
+    double queue_ms = 0.0;    // submitted -> picked up by a worker
+    double compute_ms = 0.0;  // detection itself
+};
+
+typedef std::function<void(Yolo26SegAsyncResult&)> Yolo26SegAsyncCallback;
+// One detect_stream() object; its mask is only valid during the call. Return false to stop.
+typedef std::function<bool(const Yolo26SegObject&)> Yolo26SegObjectCallback;
+
+// Thread safety: load() must complete before any other call and must not run concurrently with
+// anything. After that every const member may be called from any number of threads at once: the
+// ncnn::Net is only read, and each call leases its own letterbox buffers and pooled blob / workspace
+// allocators, so concurrent callers never share mutable state. Each call still uses
+// config.num_threads ncnn threads; lower it when many callers run in parallel. reload() may run
+// alongside all of them.
 class Yolo26Seg {
 public:
     explicit Yolo26Seg(const Yolo26SegConfig& config = Yolo26SegConfig());
     ~Yolo26Seg();
 
     bool load(const std::string& param_path, const std::string& bin_path);
+    // As Yolo26::load_memory: bin_mem is referenced, not copied, and must outlive this object.
+    bool load_memory(const char* param_mem, const unsigned char* bin_mem);
+    // Single-file bundle from the export script (param + bin + metadata), mapped like mmap_model.
+    // The metadata replaces the model-describing config fields (input size, num_classes, mask_dim, box
+    // format, postprocess, raw BGR input, output layout, blob names, class_names), so nothing has to
+    // be set by hand or probed per frame; thresholds and runtime switches are kept. False when the
+    // bundle is malformed, truncated (its weights must fill bin_size exactly) or holds a detection
+    // model; the config is then left as it was.
+    bool load_bundle(const std::string& path);
+    // Zero-downtime model update, as Yolo26::reload; the new model must keep mask_dim and the proto blob.
+    bool reload(const std::string& param_path, const std::string& bin_path);
+    Yolo26ReloadStats reload_stats() const;
+    // Peak bytes per call under memory_budget_bytes (all zero without a budget).
+    Yolo26MemoryStats memory_stats() const;
     bool detect(const cv::Mat& bgr, std::vector<Yolo26SegObject>& objects) const;
+    bool detect(const Yolo26Image& image, std::vector<Yolo26SegObject>& objects) const;
+    // With the caller's workspace instead of the calling thread's. Passing the previous frame's
+    // `objects` back also reuses their masks' storage (unless something else still references a mask).
+    bool detect(const cv::Mat& bgr, std::vector<Yolo26SegObject>& objects, Yolo26Workspace& workspace) const;
+    bool detect(const Yolo26Image& image, std::vector<Yolo26SegObject>& objects, Yolo26Workspace& workspace) const;
+    // Objects handed to `callback` one at a time, in detect()'s order, each mask built in the
+    // workspace and overwritten by the next: only one full-resolution mask exists at any time.
+    // Always a single letterboxed pass: config.tiled does not apply.
+    bool detect_stream(const cv::Mat& bgr, const Yolo26SegObjectCallback& callback, Yolo26Workspace& workspace) const;
+    bool detect_stream(const Yolo26Image& image, const Yolo26SegObjectCallback& callback, Yolo26Workspace& workspace) const;
+
+    // Preprocess once, run several models: prepare() letterboxes the frame for this model's input, and
+    // detect(prepared) on this or any other Yolo26 / Yolo26Seg consumes it without touching the frame.
+    bool prepare(const Yolo26Image& image, Yolo26PreparedInput& prepared) const;
+    bool detect(const Yolo26PreparedInput& prepared, std::vector<Yolo26SegObject>& objects) const;
+
+    // Many images at once: up to batch_workers of them are letterboxed, extracted and postprocessed
+    // concurrently, each on its share of the cores (config.num_threads when set), with letterbox
+    // buffers, allocators and the workers' workspaces reused from item to item and from batch to
+    // batch (the workers are started by load()). objects[i] belongs to images[i]; false if any
+    // image failed (its entry is left empty).
+    bool detect_batch(const std::vector<cv::Mat>& images, std::vector<std::vector<Yolo26SegObject>>& objects) const;
+    bool detect_batch(const std::vector<Yolo26Image>& images, std::vector<std::vector<Yolo26SegObject>>& objects) const;
+
+    // Builds the letterbox plan for a stream of this resolution and runs one dry extraction at its
+    // input shape, so the first real frame does not pay for it. detect() never runs dry extractions
+    // itself; in rect mode, a shape first seen by detect() pays its first extraction in that frame.
+    bool warmup(int src_w, int src_h) const;
+
+    // Non-blocking detection on config.async_workers internal threads, as Yolo26::detect_async.
+    bool detect_async(const Yolo26Image& image, Yolo26SegAsyncCallback callback) const;
+    bool detect_async(const cv::Mat& bgr, Yolo26SegAsyncCallback callback) const;
+    std::future<Yolo26SegAsyncResult> detect_async(const cv::Mat& bgr) const;
 
     const Yolo26SegConfig& config() const { return config_; }
 
 private:
+    bool configure_net(ncnn::Net& net) const;
+    // As in Yolo26: open_model() loads, plan_model() resolves blobs and layout, finish_load() publishes.
+    std::unique_ptr<yolo26::LoadedModel> open_model(const std::string& param_path, const std::string& bin_path) const;
+    std::unique_ptr<yolo26::LoadedModel> open_model(const char* param_mem,
+                                                    const unsigned char* bin_mem,
+                                                    const std::shared_ptr<const yolo26::MappedFile>& data,
+                                                    size_t bin_size = 0) const;
+    bool plan_model(yolo26::LoadedModel& model) const;
+    bool finish_load(std::unique_ptr<yolo26::LoadedModel> model);
+    std::shared_ptr<yolo26::LetterBoxPlan> letterbox_plan(int img_w, int img_h) const;
+    // layout: when set, receives the output layout this input produced (Auto if none fits).
+    bool warmup_shape(const yolo26::LoadedModel& model, int input_w, int input_h, Yolo26OutputLayout* layout = 0) const;
+    // One letterboxed inference; num_threads > 0 overrides the net's thread count for this call.
+    // With `stream`, objects go to it one by one and `objects` is left alone.
+    bool detect_once(const Yolo26Image& image,
+                     int num_threads,
+                     std::vector<Yolo26SegObject>& objects,
+                     Yolo26Workspace& workspace,
+                     const Yolo26SegObjectCallback* stream = 0) const;
+    // Extraction + postprocess of a letterboxed input; results in img_w x img_h coordinates.
+    bool infer(const ncnn::Mat& in_pad,
+               const yolo26::LetterBoxInfo& lb,
+               int img_w,
+               int img_h,
+               int num_threads,
+               std::vector<Yolo26SegObject>& objects,
+               Yolo26Workspace& workspace,
+               const Yolo26SegObjectCallback* stream = 0) const;
+    // infer() charging everything it holds to `budget` (null = no budget).
+    bool infer_within(const ncnn::Mat& in_pad,
+                      const yolo26::LetterBoxInfo& lb,
+                      int img_w,
+                      int img_h,
+                      int num_threads,
+                      std::vector<Yolo26SegObject>& objects,
+                      Yolo26Workspace& workspace,
+                      const Yolo26SegObjectCallback* stream,
+                      yolo26::MemoryBudget* budget) const;
+    bool detect_tiled(const Yolo26Image& src, std::vector<Yolo26SegObject>& objects) const;
+
     Yolo26SegConfig config_;
-    std::shared_ptr<ncnn::Net> net_;
+    // Net, mapped weights and blob plan, swapped as one by reload().
+    std::shared_ptr<yolo26::ModelSlot> model_;
+    std::shared_ptr<yolo26::LetterBoxPlanCache> letterbox_plans_;
+    std::shared_ptr<yolo26::ShapeBuckets> rect_shapes_;
+    std::shared_ptr<yolo26::ThreadPool> tile_pool_;
+    std::shared_ptr<yolo26::ThreadPool> batch_pool_;  // batch_workers - 1 threads, the caller is the last
+    std::shared_ptr<yolo26::AllocatorPool> allocators_;
+    std::shared_ptr<yolo26::MemoryStatsRecorder> memory_;
+    // Last, so its workers stop while everything they use still exists.
+    std::shared_ptr<yolo26::AsyncQueue> async_;
 };
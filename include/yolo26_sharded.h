@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "yolo26.h"
+
+namespace yolo26 {
+class MappedFile;
+}
+
+struct Yolo26ShardedConfig {
+    Yolo26Config detector;       // per shard; num_threads is replaced by threads_per_shard
+    int shards = 0;              // model instances, 0 = choose at load() by measuring throughput
+    int threads_per_shard = 0;   // ncnn threads per instance, 0 = big CPU cores / shards
+    int max_shards = 16;         // upper bound while tuning; each shard holds its own packed weights
+    bool pin_threads = true;     // bind each shard's threads to its own cores
+    float tune_seconds = 0.5f;   // measuring time per candidate layout
+};
+
+struct Yolo26ShardLayout {
+    int shards = 0;
+    int threads_per_shard = 0;
+    double fps = 0.0;  // throughput measured by load(), 0 when the layout was given explicitly
+};
+
+// N independent Yolo26 instances ("shards") of one model, each running k ncnn threads pinned to its
+// own k cores. One wide net scales poorly across many cores; several narrow ones sharing the machine
+// keep every core busy. The .bin is mapped once and every shard references the same pages
+// (Yolo26::load_memory); only the layer-packed copies are per shard.
+// Each shard owns one dispatch thread, so the ncnn / OpenMP threads it starts keep their affinity;
+// detect() hands the call to the shard with the fewest calls in flight and blocks until it is done.
+// With shards == 0, load() tries every N x k that uses all big cores (k dividing the core count,
+// N <= max_shards) on a blank input_width x input_height frame and keeps the fastest.
+// Thread safety as for Yolo26: load() alone, then detect() from any number of threads.
+class Yolo26Sharded {
+public:
+    explicit Yolo26Sharded(const Yolo26ShardedConfig& config = Yolo26ShardedConfig());
+    ~Yolo26Sharded();
+
+    bool load(const std::string& param_path, const std::string& bin_path);
+    bool detect(const cv::Mat& bgr, std::vector<Yolo26Object>& objects) const;
+    bool detect(const Yolo26Image& image, std::vector<Yolo26Object>& objects) const;
+
+    const Yolo26ShardLayout& layout() const { return layout_; }
+    // Every layout measured by load(), in the order tried; empty when the layout was given.
+    const std::vector<Yolo26ShardLayout>& tuning() const { return tuning_; }
+
+private:
+    struct Shard;
+
+    bool start(int shards, int threads_per_shard);
+    double measure(double seconds) const;
+
+    Yolo26ShardedConfig config_;
+    // Shared by all shards; declared before them so it outlives their nets.
+    std::string param_;
+    std::shared_ptr<const yolo26::MappedFile> bin_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    Yolo26ShardLayout layout_;
+    std::vector<Yolo26ShardLayout> tuning_;
+    mutable std::atomic<unsigned> next_shard_{0};
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+
 enum class Yolo26BoxFormat
 {
     CXCYWH = 0,
@@ -12,3 +14,51 @@ enum class Yolo26PostprocessType
     NMS = 1,
     TopK = 2,
 };
+
+enum class Yolo26PixelFormat
+{
+    BGR = 0,
+    RGB = 1,
+    BGRA = 2,
+    RGBA = 3,
+    GRAY = 4,
+    NV12 = 5,  // Y plane + interleaved UV plane at half resolution
+    NV21 = 6,  // Y plane + interleaved VU plane at half resolution
+    I420 = 7,  // Y plane + U plane + V plane at half resolution
+};
+
+// Shape of the main output (as a 2-D matrix), i.e. which decoder it feeds.
+enum class Yolo26OutputLayout
+{
+    Auto = 0,         // inferred from the shape
+    ChannelMajor = 1, // [4+nc(+nm), num_anchors], e.g. (84, 8400)
+    AnchorMajor = 2,  // [num_anchors, 4+nc(+nm)], e.g. (8400, 84)
+    End2EndRows = 3,  // [num_dets, 6(+nm)]: xyxy, score, class (, mask coefficients)
+    End2EndCols = 4,  // [6(+nm), num_dets]
+};
+
+// Yolo26::reload() / Yolo26Seg::reload() counters. Times are of the last reload unless noted.
+struct Yolo26ReloadStats {
+    int reloads = 0;            // models swapped in
+    int failures = 0;           // reloads that kept serving the previous model
+    double load_ms = 0.0;       // reading the param / bin and building the net
+    double warmup_ms = 0.0;     // dry runs on the new net before it serves any call
+    double swap_us = 0.0;       // publishing it: the only step concurrent calls could observe
+    double total_ms = 0.0;      // from the reload() call until new calls run on the new model
+    double max_total_ms = 0.0;  // over all reloads
+    // Swap until the last call still running on the replaced model finished and the model was freed;
+    // -1 while it drains.
+    double drain_ms = -1.0;
+    double max_drain_ms = 0.0;  // over all reloads
+    int retired_alive = 0;      // replaced models still held by in-flight calls
+};
+
+// Yolo26Seg memory-budget counters (Yolo26SegConfig::memory_budget_bytes). Peaks are the bytes a call
+// held at once: input tensor, ncnn blobs and workspace, postprocess scratch and the masks returned.
+struct Yolo26MemoryStats {
+    size_t budget_bytes = 0;     // 0 = no budget, nothing is tracked
+    size_t last_peak_bytes = 0;  // of the last call
+    size_t max_peak_bytes = 0;   // over all calls
+    int calls = 0;
+    int rejected = 0;  // calls that failed because they would have exceeded the budget
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+
+#include "yolo26.h"
+
+struct Yolo26VideoConfig {
+    int full_frame_interval = 15;  // full-frame detect at least every N frames, to pick up new objects
+    float crop_margin = 0.5f;      // crop = track box grown by this fraction of its size on each side
+    int min_crop_size = 96;        // crops are at least this wide / high, in frame pixels
+    float max_crop_area = 0.5f;    // run the full frame instead once crops cover more of it than this
+    float match_iou = 0.3f;        // track <-> detection association threshold
+};
+
+struct Yolo26Track {
+    int id = -1;
+    Yolo26Object object;  // last matched box, frame coordinates
+    int hits = 0;         // frames this track was matched in
+};
+
+// Tracking-guided inference for static-camera video. Every full_frame_interval frames (or whenever a
+// track is lost) the whole frame goes through Yolo26::detect; in between, the network only sees crops
+// around the previous frame's tracks, each at native resolution in a cell of one mosaic canvas
+// (Yolo26::detect_regions, mosaic_cols x mosaic_rows of the detector's config). That is a single
+// inference at the input size, so the crop path never costs more than a full frame; frames with more
+// crops than cells, or a crop larger than a cell, run in full.
+// One instance per stream; keeps state between calls and is not thread-safe. `detector` must outlive it.
+class Yolo26VideoDetector {
+public:
+    explicit Yolo26VideoDetector(const Yolo26& detector, const Yolo26VideoConfig& config = Yolo26VideoConfig());
+
+    bool detect(const Yolo26Image& frame, std::vector<Yolo26Object>& objects);
+    bool detect(const cv::Mat& bgr, std::vector<Yolo26Object>& objects);
+    void reset();
+
+    const std::vector<Yolo26Track>& tracks() const { return tracks_; }
+    bool last_was_full_frame() const { return last_full_; }
+
+private:
+    bool detect_crops(const Yolo26Image& frame, std::vector<Yolo26Object>& objects) const;
+    // Matches detections to tracks; returns false when a track found no detection.
+    bool associate(const std::vector<Yolo26Object>& objects, bool full_frame);
+
+    const Yolo26& detector_;
+    Yolo26VideoConfig config_;
+    std::vector<Yolo26Track> tracks_;
+    int frames_since_full_ = 0;
+    int next_id_ = 0;
+    bool last_full_ = false;
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+// Scratch memory of one Yolo26::detect() / Yolo26Seg::detect() call: decoded candidates, top-k and
+// NMS buffers, mask coefficients and mask planes. Reset per frame and never shrunk, so once it has
+// served the largest frame of a stream, decoding, NMS and mask assembly allocate nothing (ncnn still
+// allocates its per-extraction bookkeeping). Serves one call at a time, from any detector or model.
+// detect() without a workspace uses one owned by the calling thread.
+class Yolo26Workspace {
+public:
+    Yolo26Workspace();
+    ~Yolo26Workspace();
+
+    Yolo26Workspace(const Yolo26Workspace&) = delete;
+    Yolo26Workspace& operator=(const Yolo26Workspace&) = delete;
+
+    // Bytes reserved by the buffers so far.
+    size_t capacity_bytes() const;
+
+    struct Impl;
+
+private:
+    friend class Yolo26;
+    friend class Yolo26Seg;
+
+    std::unique_ptr<Impl> impl_;
+};
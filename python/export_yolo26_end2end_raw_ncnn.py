@@ -1,4 +1,5 @@
 import argparse
+import struct
 import sys
 from pathlib import Path
 from types import MethodType
@@ -20,12 +21,84 @@ def _patch_postprocess_identity(model) -> int:
     return patched
 
 
+def _fold_preprocess(model) -> str:
+    # Fold x/255 and the RGB -> BGR swap into the first convolution so the runtime can feed raw BGR bytes:
+    # conv(bgr, W[:, ::-1] / 255) == conv(rgb / 255, W). Zero padding inside the conv is zero in both spaces.
+    for name, m in model.named_modules():
+        if isinstance(m, torch.nn.Conv2d) and m.in_channels == 3:
+            if m.groups != 1:
+                raise SystemExit(f"Cannot fold preprocessing into grouped conv: {name}")
+            with torch.no_grad():
+                m.weight.copy_(m.weight[:, [2, 1, 0]] / 255.0)
+            return name
+    raise SystemExit("No 3-channel Conv2d found to fold preprocessing into")
+
+
+def _write_metadata(path: Path, meta: dict) -> None:
+    path.write_text("".join(f"{k}={v}\n" for k, v in meta.items()))
+
+
+def _param_blobs(param_path: Path) -> dict:
+    # ncnn numbers blobs in the order layers produce them: each layer line is
+    # "type name bottom_count top_count bottoms... tops... params...".
+    blobs = {}
+    lines = param_path.read_text().splitlines()
+    for line in lines[2:]:
+        tok = line.split()
+        if len(tok) < 4:
+            continue
+        nb, nt = int(tok[2]), int(tok[3])
+        for top in tok[4 + nb : 4 + nb + nt]:
+            blobs.setdefault(top, len(blobs))
+    return blobs
+
+
+def _output_layout(pred: torch.Tensor, pred_dim: int, end2end_dim: int) -> str:
+    # pnnx drops the batch axis: torch (1, A, C) becomes an ncnn Mat with h=A, w=C.
+    rows, cols = pred.shape[-2], pred.shape[-1]
+    if rows == pred_dim:
+        return "channel_major"
+    if cols == pred_dim:
+        return "anchor_major"
+    if cols == end2end_dim:
+        return "end2end_rows"
+    if rows == end2end_dim:
+        return "end2end_cols"
+    raise SystemExit(f"Unrecognized output shape {tuple(pred.shape)}")
+
+
+def _write_bundle(path: Path, meta: dict, param_path: Path, bin_path: Path) -> None:
+    # Layout read by src/yolo26_bundle.h: magic, u32 meta_size, u32 param_size, u64 bin_offset, u64 bin_size,
+    # metadata, NUL-terminated param, zero padding, bin at a 4096-byte boundary (page aligned when mmapped).
+    meta_bytes = "".join(f"{k}={v}\n" for k, v in meta.items()).encode()
+    param_bytes = param_path.read_bytes() + b"\0"
+    bin_bytes = bin_path.read_bytes()
+    header_size = 8 + 4 + 4 + 8 + 8
+    bin_offset = (header_size + len(meta_bytes) + len(param_bytes) + 4095) // 4096 * 4096
+    with path.open("wb") as f:
+        f.write(struct.pack("<8sIIQQ", b"Y26BNDL1", len(meta_bytes), len(param_bytes), bin_offset, len(bin_bytes)))
+        f.write(meta_bytes)
+        f.write(param_bytes)
+        f.write(b"\0" * (bin_offset - header_size - len(meta_bytes) - len(param_bytes)))
+        f.write(bin_bytes)
+
+
 def main() -> None:
     ap = argparse.ArgumentParser()
     ap.add_argument("--weights", default="yolo26n.pt", help="Path to YOLO26(.pt) weights (detect or seg)")
     ap.add_argument("--imgsz", type=int, default=640, help="Export image size")
     ap.add_argument("--max-det", type=int, default=300, help="Max detections (only affects model attrs)")
     ap.add_argument("--half", action="store_true", help="Export FP16")
+    ap.add_argument(
+        "--dynamic",
+        action="store_true",
+        help="Export with dynamic input H/W (anchors computed in-graph), required for C++ rect mode (--rect)",
+    )
+    ap.add_argument(
+        "--fold-preprocess",
+        action="store_true",
+        help="Fold /255 and RGB->BGR into the first conv; run C++ with raw BGR input (--raw-bgr)",
+    )
     ap.add_argument(
         "--out-dir",
         default=None,
@@ -60,7 +133,7 @@ def main() -> None:
 
     for m in model.modules():
         if isinstance(m, (Detect, Segment)):
-            m.dynamic = False
+            m.dynamic = args.dynamic
             m.export = True
             m.format = "ncnn"
             m.max_det = args.max_det
@@ -71,7 +144,20 @@ def main() -> None:
     if patched <= 0:
         raise SystemExit("No Detect/Segment modules patched; is this a YOLO26 end2end model?")
 
+    folded_conv = _fold_preprocess(model) if args.fold_preprocess else ""
+
+    head = next(m for m in model.modules() if isinstance(m, (Detect, Segment)))
+    is_seg = isinstance(head, Segment)
+    nc = int(head.nc)
+    nm = int(getattr(head, "nm", 0)) if is_seg else 0
+
     im = torch.zeros(1, 3, args.imgsz, args.imgsz)
+    with torch.no_grad():
+        y_out = model(im)
+    pred = y_out[0] if isinstance(y_out, (list, tuple)) else y_out
+    layout = _output_layout(pred, 4 + nc + nm, 6 + nm)
+    # pnnx marks H/W dynamic when a second trace with a different (stride-32) shape is given.
+    dynamic_args = dict(inputs2=torch.zeros(1, 3, args.imgsz // 2, args.imgsz)) if args.dynamic else {}
 
     import pnnx  # noqa: E402
 
@@ -90,11 +176,46 @@ def main() -> None:
 
     # Some Ultralytics models can fail torch.jit trace check (graphs differ across invocations) even though the trace is
     # valid. Disable check_trace to make export robust.
-    pnnx.export(model, inputs=im, **ncnn_args, **pnnx_args, fp16=args.half, device="cpu", check_trace=False)
+    pnnx.export(
+        model, inputs=im, **dynamic_args, **ncnn_args, **pnnx_args, fp16=args.half, device="cpu", check_trace=False
+    )
 
-    print(f"Saved: {out_dir}")
+    param_path = out_dir / "model.ncnn.param"
+    blobs = _param_blobs(param_path)
+    meta = {
+        "format": 1,
+        "task": "segment" if is_seg else "detect",
+        "weights": weights.name,
+        "imgsz": args.imgsz,
+        "dynamic": int(args.dynamic),
+        "half": int(args.half),
+        "nc": nc,
+        "nm": nm,
+        "layout": layout,
+        "box": "xyxy",
+        "post": "topk",
+        "input": "bgr_raw" if args.fold_preprocess else "rgb_01",
+        "folded_conv": folded_conv,
+        "input_blob": "in0",
+        "input_index": blobs.get("in0", -1),
+        "output_blob": "out0",
+        "output_index": blobs.get("out0", -1),
+    }
+    if is_seg:
+        meta.update({"proto_blob": "out1", "proto_index": blobs.get("out1", -1)})
+    names = y.names if isinstance(y.names, dict) else dict(enumerate(y.names))
+    meta.update({f"name.{i}": str(names.get(i, i)).replace("\n", " ") for i in range(nc)})
+
+    # Recorded next to the model so deployments can tell which input the graph expects.
+    _write_metadata(out_dir / "yolo26_export.txt", meta)
+    # Everything in one file for Yolo26::load_bundle / Yolo26Seg::load_bundle.
+    _write_bundle(out_dir / "model.yolo26", meta, param_path, out_dir / "model.ncnn.bin")
+
+    print(f"Saved: {out_dir} (bundle: model.yolo26)")
     print("Note: output is end2end one2one RAW (boxes are XYXY, no TopK in graph).")
     print("Use C++ with: --post=topk --box=xyxy (no NMS).")
+    if args.fold_preprocess:
+        print(f"Preprocessing folded into {folded_conv}: add --raw-bgr (Yolo26Config::raw_bgr_input).")
 
 
 if __name__ == "__main__":
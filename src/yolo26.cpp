@@ -1,85 +1,670 @@
 #include "yolo26.h"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <cstring>
+#include <mutex>
 
 #include <opencv2/imgproc/imgproc.hpp>
 
 #include "net.h"
 #include "cpu.h"
 
+#include "yolo26_allocator.h"
+#include "yolo26_async.h"
+#include "yolo26_bounded_reader.h"
+#include "yolo26_bundle.h"
+#include "yolo26_mapped_file.h"
+#include "yolo26_model.h"
 #include "yolo26_preprocess.h"
 #include "yolo26_ops.h"
+#include "yolo26_option_profile.h"
 #include "yolo26_ncnn_io.h"
 #include "yolo26_ncnn_mat.h"
+#include "yolo26_scratch.h"
 #include "yolo26_topk.h"
 #include "yolo26_nms.h"
+#include "yolo26_thread_pool.h"
+#include "yolo26_tile.h"
+
+Yolo26Workspace::Yolo26Workspace()
+    : impl_(new Impl)
+{
+}
+
+Yolo26Workspace::~Yolo26Workspace() = default;
+
+size_t Yolo26Workspace::capacity_bytes() const
+{
+    return impl_->capacity_bytes();
+}
+
+Yolo26Workspace& yolo26::thread_workspace()
+{
+    static thread_local Yolo26Workspace workspace;
+    return workspace;
+}
+
+// detect_regions() rounds region sizes up to this, so a drifting region keeps its plan.
+static const int kRegionBucket = 64;
+
+// A mosaic uses a plan per cell and the canvas plan in one call; keep room for the detect() plan and
+// for every region size bucket that fits a cell.
+static size_t mosaic_plan_count(const Yolo26Config& config)
+{
+    const int cols = std::max(config.mosaic_cols, 1);
+    const int rows = std::max(config.mosaic_rows, 1);
+    const int buckets = std::max(1, config.input_width / cols / kRegionBucket) * std::max(1, config.input_height / rows / kRegionBucket);
+    return std::max((size_t)(cols * rows + 2 + buckets), (size_t)4);
+}
 
 Yolo26::Yolo26(const Yolo26Config& config)
-    : config_(config), net_(std::make_shared<ncnn::Net>())
+    : config_(config),
+      model_(std::make_shared<yolo26::ModelSlot>()),
+      letterbox_plans_(std::make_shared<yolo26::LetterBoxPlanCache>(mosaic_plan_count(config))),
+      rect_shapes_(std::make_shared<yolo26::ShapeBuckets>(config.rect_max_shapes)),
+      allocators_(std::make_shared<yolo26::AllocatorPool>(config.huge_pages))
 {
 }
 
-Yolo26::~Yolo26() = default;
+Yolo26::~Yolo26()
+{
+    // Copies share the queue; none of the jobs may outlive the instance they call into.
+    if (async_)
+        async_->wait_idle();
+}
 
-bool Yolo26::load(const std::string& param_path, const std::string& bin_path)
+bool Yolo26::configure_net(ncnn::Net& net) const
 {
-    if (!net_)
-        net_ = std::make_shared<ncnn::Net>();
+#if NCNN_VULKAN
+    net.opt.use_vulkan_compute = config_.use_gpu;
+#endif
+    net.opt.num_threads = config_.num_threads > 0 ? config_.num_threads : ncnn::get_big_cpu_count();
 
+    // Options must be final before load_param: layers pick their kernels when they are created.
+    if (!config_.option_profile.empty() && !yolo26::load_option_profile(config_.option_profile, config_.num_threads, net.opt))
+        return false;
+    if (config_.int8)
+    {
+        // ncnn's Vulkan backend has no int8 convolutions.
+        net.opt.use_int8_inference = true;
 #if NCNN_VULKAN
-    net_->opt.use_vulkan_compute = config_.use_gpu;
+        net.opt.use_vulkan_compute = false;
 #endif
-    net_->opt.num_threads = ncnn::get_big_cpu_count();
+    }
+    return true;
+}
+
+std::unique_ptr<yolo26::LoadedModel> Yolo26::open_model(const std::string& param_path, const std::string& bin_path) const
+{
+    if (config_.mmap_model)
+    {
+        std::string param;
+        const std::shared_ptr<const yolo26::MappedFile> bin = yolo26::MappedFile::open(bin_path);
+        if (!bin || !yolo26::read_text_file(param_path, param))
+            return std::unique_ptr<yolo26::LoadedModel>();
+        return open_model(param.c_str(), bin->data(), bin, bin->size());
+    }
+
+    std::unique_ptr<yolo26::LoadedModel> model(new yolo26::LoadedModel);
+    if (!configure_net(model->net))
+        return std::unique_ptr<yolo26::LoadedModel>();
+    if (model->net.load_param(param_path.c_str()) != 0)
+        return std::unique_ptr<yolo26::LoadedModel>();
+    if (model->net.load_model(bin_path.c_str()) != 0)
+        return std::unique_ptr<yolo26::LoadedModel>();
+    return model;
+}
+
+std::unique_ptr<yolo26::LoadedModel> Yolo26::open_model(const char* param_mem,
+                                                        const unsigned char* bin_mem,
+                                                        const std::shared_ptr<const yolo26::MappedFile>& data,
+                                                        size_t bin_size) const
+{
+    if (!param_mem || !bin_mem)
+        return std::unique_ptr<yolo26::LoadedModel>();
+
+    std::unique_ptr<yolo26::LoadedModel> model(new yolo26::LoadedModel);
+    model->data = data;
+    if (!configure_net(model->net))
+        return std::unique_ptr<yolo26::LoadedModel>();
+    if (model->net.load_param_mem(param_mem) != 0)
+        return std::unique_ptr<yolo26::LoadedModel>();
+    if (bin_size == 0)
+    {
+        if (model->net.load_model(bin_mem) == 0)
+            return std::unique_ptr<yolo26::LoadedModel>();
+        return model;
+    }
+
+    // A known size bounds every weight read, and the model must use all of it: a truncated or
+    // mismatched .bin fails here instead of feeding ncnn bytes past the mapping.
+    const yolo26::BoundedDataReader reader(bin_mem, bin_size);
+    if (model->net.load_model(reader) != 0 || reader.remaining() != 0)
+        return std::unique_ptr<yolo26::LoadedModel>();
+    return model;
+}
+
+bool Yolo26::plan_model(yolo26::LoadedModel& model) const
+{
+    // Blob indices and the output layout are fixed by the graph: resolve them once with a blank
+    // input_width x input_height run, so per-frame calls skip name lookups and shape guessing.
+    model.io.resolve(model.net, config_.input_name, config_.output_name);
+    Yolo26OutputLayout layout = Yolo26OutputLayout::Auto;
+    if (!warmup_shape(model, config_.input_width, config_.input_height, &layout) || layout == Yolo26OutputLayout::Auto)
+        return false;
+    model.io.layout = layout;
+    return true;
+}
+
+bool Yolo26::finish_load(std::unique_ptr<yolo26::LoadedModel> model)
+{
+    // Opening the model needs no lock; planning it and publishing it are serialized with reload().
+    std::lock_guard<std::mutex> lock(model_->load_mutex());
+    if (!model || !plan_model(*model))
+        return false;
+    model_->publish(std::move(model), false, yolo26::ModelSlot::Clock::time_point(), 0.0, 0.0);
+
+    if (config_.tiled)
+    {
+        // The calling thread works on tiles too.
+        const int workers = config_.tile_workers > 0 ? config_.tile_workers : ncnn::get_big_cpu_count();
+        tile_pool_ = std::make_shared<yolo26::ThreadPool>(std::max(0, workers - 1));
+    }
+    // detect_batch() workers live as long as the detector, and with them their thread_workspace().
+    const int batch_workers = config_.batch_workers > 0 ? config_.batch_workers : ncnn::get_big_cpu_count();
+    if (batch_workers > 1)
+        batch_pool_ = std::make_shared<yolo26::ThreadPool>(batch_workers - 1);
+    if (config_.async_workers > 0)
+        async_ = std::make_shared<yolo26::AsyncQueue>(config_.async_workers, config_.async_queue_depth);
+
+    return true;
+}
+
+bool Yolo26::load(const std::string& param_path, const std::string& bin_path)
+{
+    return finish_load(open_model(param_path, bin_path));
+}
+
+bool Yolo26::load_bundle(const std::string& path)
+{
+    const std::shared_ptr<const yolo26::MappedFile> file = yolo26::MappedFile::open(path);
+    yolo26::Bundle bundle;
+    Yolo26Config config = config_;
+    if (!file || !yolo26::parse_bundle(*file, bundle) || !yolo26::apply_bundle(bundle, "detect", config))
+        return false;
+
+    // The bundle's config is only kept once its model is current.
+    const Yolo26Config previous = config_;
+    config_ = config;
+    if (finish_load(open_model(bundle.param, bundle.bin, file, bundle.bin_size)))
+        return true;
+    config_ = previous;
+    return false;
+}
+
+bool Yolo26::load_memory(const char* param_mem, const unsigned char* bin_mem)
+{
+    return finish_load(open_model(param_mem, bin_mem, std::shared_ptr<const yolo26::MappedFile>()));
+}
+
+bool Yolo26::reload(const std::string& param_path, const std::string& bin_path)
+{
+    typedef yolo26::ModelSlot::Clock Clock;
+    std::lock_guard<std::mutex> lock(model_->load_mutex());
+    if (!model_->get())
+        return false;
+
+    const Clock::time_point started = Clock::now();
+    std::unique_ptr<yolo26::LoadedModel> model = open_model(param_path, bin_path);
+    const Clock::time_point loaded = Clock::now();
+
+    // Warm every shape calls are being served at, so the first frames on the new net do not stall.
+    bool ok = model && plan_model(*model);
+    if (ok && config_.rect)
+    {
+        const std::vector<std::pair<int, int> > shapes = rect_shapes_->shapes();
+        for (size_t i = 0; ok && i < shapes.size(); i++)
+            ok = warmup_shape(*model, shapes[i].first, shapes[i].second);
+    }
+    if (!ok)
+    {
+        model_->failed();
+        return false;
+    }
+
+    const Clock::time_point warmed = Clock::now();
+    model_->publish(std::move(model),
+                    true,
+                    started,
+                    std::chrono::duration<double, std::milli>(loaded - started).count(),
+                    std::chrono::duration<double, std::milli>(warmed - loaded).count());
+    return true;
+}
+
+Yolo26ReloadStats Yolo26::reload_stats() const
+{
+    return model_->stats();
+}
+
+bool Yolo26::warmup(int src_w, int src_h) const
+{
+    const std::shared_ptr<const yolo26::LoadedModel> model = model_->get();
+    if (!model)
+        return false;
+
+    const std::shared_ptr<yolo26::LetterBoxPlan> plan = letterbox_plan(src_w, src_h);
+    if (!plan)
+        return false;
+    return warmup_shape(*model, plan->info().input_w, plan->info().input_h);
+}
+
+std::shared_ptr<yolo26::LetterBoxPlan> Yolo26::letterbox_plan(int img_w, int img_h) const
+{
+    const bool scaleup = config_.scaleup;
+    if (config_.rect && config_.rect_stride > 0)
+    {
+        std::shared_ptr<yolo26::LetterBoxPlan> plan = letterbox_plans_->get(img_w,
+                                                                           img_h,
+                                                                           config_.input_width,
+                                                                           config_.input_height,
+                                                                           scaleup,
+                                                                           config_.center,
+                                                                           config_.rect_stride);
+        // No dry run here: this is the detect path. warmup() and reload() warm admitted shapes.
+        if (plan && rect_shapes_->admit(plan->info().input_w, plan->info().input_h))
+            return plan;
+    }
+
+    return letterbox_plans_->get(img_w, img_h, config_.input_width, config_.input_height, scaleup, config_.center);
+}
 
-    if (net_->load_param(param_path.c_str()) != 0)
+bool Yolo26::warmup_shape(const yolo26::LoadedModel& model, int input_w, int input_h, Yolo26OutputLayout* layout) const
+{
+    ncnn::Mat in(input_w, input_h, 3);
+    if (in.empty())
         return false;
-    if (net_->load_model(bin_path.c_str()) != 0)
+    in.fill(0.f);
+
+    yolo26::AllocatorPool::Lease allocators(*allocators_);
+    ncnn::Extractor ex = yolo26::create_extractor(model.net, allocators);
+    if (!model.io.input(ex, config_.input_name, in))
         return false;
 
+    ncnn::Mat out;
+    if (!model.io.output(ex, config_.output_name, out))
+        return false;
+    if (layout)
+    {
+        ncnn::Mat out_2d;
+        if (!yolo26::to_mat2d(out, out_2d))
+            return false;
+        *layout = yolo26::resolve_output_layout(out_2d.w, out_2d.h, 4 + config_.num_classes, 6, config_.output_layout);
+    }
     return true;
 }
 
 bool Yolo26::detect(const cv::Mat& bgr, std::vector<Yolo26Object>& objects) const
 {
-    if (!net_ || bgr.empty())
+    return detect(yolo26_image_from_mat(bgr), objects, yolo26::thread_workspace());
+}
+
+bool Yolo26::detect(const Yolo26Image& image, std::vector<Yolo26Object>& objects) const
+{
+    return detect(image, objects, yolo26::thread_workspace());
+}
+
+bool Yolo26::detect(const cv::Mat& bgr, std::vector<Yolo26Object>& objects, Yolo26Workspace& workspace) const
+{
+    return detect(yolo26_image_from_mat(bgr), objects, workspace);
+}
+
+bool Yolo26::detect(const Yolo26Image& image, std::vector<Yolo26Object>& objects, Yolo26Workspace& workspace) const
+{
+    if (config_.tiled && tile_pool_)
+    {
+        Yolo26Image src;
+        if (!yolo26::resolve_image(image, src))
+            return false;
+        // Tiles run on pool threads, each with its own thread's workspace.
+        if (src.width > config_.input_width || src.height > config_.input_height)
+            return detect_tiled(src, objects);
+    }
+    return detect_once(image, 0, objects, workspace);
+}
+
+int Yolo26::detect_into(const cv::Mat& bgr, Yolo26Detections& out, Yolo26Workspace& workspace) const
+{
+    return detect_into(yolo26_image_from_mat(bgr), out, workspace);
+}
+
+int Yolo26::detect_into(const Yolo26Image& image, Yolo26Detections& out, Yolo26Workspace& workspace) const
+{
+    if (out.capacity < 0 || (out.capacity > 0 && (!out.x1 || !out.y1 || !out.x2 || !out.y2 || !out.score || !out.label)))
+        return -1;
+
+    Yolo26Image src;
+    if (!yolo26::resolve_image(image, src))
+        return -1;
+
+    const int img_w = src.orig_width;
+    const int img_h = src.orig_height;
+
+    const std::shared_ptr<yolo26::LetterBoxPlan> plan = letterbox_plan(src.width, src.height);
+    if (!plan)
+        return -1;
+
+    yolo26::LetterBoxPlan::Lease lease(*plan);
+    ncnn::Mat& in_pad = lease.input();
+    plan->run(src, config_.padding_value, in_pad, lease.rows(), config_.raw_bgr_input);
+    yolo26::LetterBoxInfo lb = plan->info();
+    lb.src_scale_x = img_w / (float)src.width;
+    lb.src_scale_y = img_h / (float)src.height;
+
+    if (!infer_proposals(in_pad, 0, workspace))
+        return -1;
+
+    // Transpose into the caller's columns, then unscale each column in one pass.
+    const std::vector<Yolo26Object>& proposals = workspace.impl_->proposals;
+    const int count = std::min((int)proposals.size(), std::min(out.capacity, std::max(config_.max_det, 0)));
+    for (int i = 0; i < count; i++)
+    {
+        const Yolo26Object& obj = proposals[i];
+        out.x1[i] = obj.x1;
+        out.y1[i] = obj.y1;
+        out.x2[i] = obj.x2;
+        out.y2[i] = obj.y2;
+        out.score[i] = obj.prob;
+        out.label[i] = obj.label;
+    }
+    yolo26::scale_xyxy_soa_inplace(out.x1, out.y1, out.x2, out.y2, count, img_w, img_h, lb, true);
+    return count;
+}
+
+bool Yolo26::detect_once(const Yolo26Image& image, int num_threads, std::vector<Yolo26Object>& objects, Yolo26Workspace& workspace) const
+{
+    Yolo26Image src;
+    if (!yolo26::resolve_image(image, src))
+        return false;
+
+    // Results are reported in original coordinates, which differ from src for reduced decodes.
+    const int img_w = src.orig_width;
+    const int img_h = src.orig_height;
+
+    const std::shared_ptr<yolo26::LetterBoxPlan> plan = letterbox_plan(src.width, src.height);
+    if (!plan)
         return false;
 
-    const int img_w = bgr.cols;
-    const int img_h = bgr.rows;
+    // The lease must outlive the extractor below, which references the input tensor.
+    yolo26::LetterBoxPlan::Lease lease(*plan);
+    ncnn::Mat& in_pad = lease.input();
+    plan->run(src, config_.padding_value, in_pad, lease.rows(), config_.raw_bgr_input);
+    yolo26::LetterBoxInfo lb = plan->info();
+    lb.src_scale_x = img_w / (float)src.width;
+    lb.src_scale_y = img_h / (float)src.height;
+
+    return infer(in_pad, lb, img_w, img_h, num_threads, objects, workspace);
+}
+
+bool Yolo26::detect_batch(const std::vector<cv::Mat>& images, std::vector<std::vector<Yolo26Object>>& objects) const
+{
+    std::vector<Yolo26Image> views(images.size());
+    for (size_t i = 0; i < images.size(); i++)
+        views[i] = yolo26_image_from_mat(images[i]);
+    return detect_batch(views, objects);
+}
+
+bool Yolo26::detect_batch(const std::vector<Yolo26Image>& images, std::vector<std::vector<Yolo26Object>>& objects) const
+{
+    // resize, not assign: entries keep their capacity across batches.
+    objects.resize(images.size());
+    if (images.empty())
+        return true;
 
-    yolo26::LetterBoxInfo lb;
-    ncnn::Mat in_pad;
-    if (!yolo26::letterbox(bgr,
-                           config_.input_width,
-                           config_.input_height,
-                           config_.padding_value,
-                           config_.scaleup,
-                           config_.center,
-                           in_pad,
-                           lb))
+    const int n = (int)images.size();
+    const int cores = std::max(1, ncnn::get_big_cpu_count());
+    const int workers = std::min(n, config_.batch_workers > 0 ? config_.batch_workers : cores);
+    // Split the cores between the images in flight unless the caller fixed the ncnn thread count.
+    const int threads = config_.num_threads > 0 ? config_.num_threads : std::max(1, cores / workers);
+
+    std::atomic<bool> ok(true);
+    auto run = [&](int i) {
+        // Tiled images go through detect() and spread over the tile pool instead.
+        const bool done = config_.tiled ? detect(images[i], objects[i]) : detect_once(images[i], threads, objects[i], yolo26::thread_workspace());
+        if (!done)
+        {
+            objects[i].clear();
+            ok = false;
+        }
+    };
+
+    if (workers <= 1 || !batch_pool_)
+    {
+        for (int i = 0; i < n; i++)
+            run(i);
+    }
+    else
+    {
+        batch_pool_->parallel_for(n, workers, run);
+    }
+    return ok;
+}
+
+bool Yolo26::detect_async(const Yolo26Image& image, Yolo26AsyncCallback callback) const
+{
+    return yolo26::submit_detect<Yolo26AsyncResult>(
+        async_.get(), image, cv::Mat(), callback, [this](const Yolo26Image& img, std::vector<Yolo26Object>& objects) {
+            return detect(img, objects);
+        });
+}
+
+bool Yolo26::detect_async(const cv::Mat& bgr, Yolo26AsyncCallback callback) const
+{
+    return yolo26::submit_detect<Yolo26AsyncResult>(
+        async_.get(), yolo26_image_from_mat(bgr), bgr, callback, [this](const Yolo26Image& img, std::vector<Yolo26Object>& objects) {
+            return detect(img, objects);
+        });
+}
+
+std::future<Yolo26AsyncResult> Yolo26::detect_async(const cv::Mat& bgr) const
+{
+    std::shared_ptr<std::promise<Yolo26AsyncResult>> promise = std::make_shared<std::promise<Yolo26AsyncResult>>();
+    std::future<Yolo26AsyncResult> future = promise->get_future();
+    if (!detect_async(bgr, [promise](Yolo26AsyncResult& result) { promise->set_value(std::move(result)); }))
+        return std::future<Yolo26AsyncResult>();
+    return future;
+}
+
+bool Yolo26::prepare(const Yolo26Image& image, Yolo26PreparedInput& prepared) const
+{
+    Yolo26Image src;
+    if (!yolo26::resolve_image(image, src))
         return false;
-    yolo26::normalize_01_inplace(in_pad);
 
-    ncnn::Extractor ex = net_->create_extractor();
-    if (!yolo26::ncnn_input_image(ex, config_.input_name, in_pad))
+    const std::shared_ptr<yolo26::LetterBoxPlan> plan = letterbox_plan(src.width, src.height);
+    if (!plan)
+        return false;
+
+    const yolo26::LetterBoxInfo& info = plan->info();
+    prepared.input.create(info.input_w, info.input_h, 3);
+    if (prepared.input.empty())
+        return false;
+
+    // Only the row scratch of the lease is used; the tensor is owned by `prepared`.
+    yolo26::LetterBoxPlan::Lease lease(*plan);
+    plan->run(src, config_.padding_value, prepared.input, lease.rows(), config_.raw_bgr_input);
+    prepared.info = info;
+    prepared.info.src_scale_x = src.orig_width / (float)src.width;
+    prepared.info.src_scale_y = src.orig_height / (float)src.height;
+    prepared.src_w = src.width;
+    prepared.src_h = src.height;
+    prepared.img_w = src.orig_width;
+    prepared.img_h = src.orig_height;
+    prepared.padding_value = config_.padding_value;
+    prepared.raw_bgr = config_.raw_bgr_input;
+    return true;
+}
+
+bool Yolo26::detect(const Yolo26PreparedInput& prepared, std::vector<Yolo26Object>& objects) const
+{
+    if (prepared.input.empty() || prepared.src_w <= 0 || prepared.src_h <= 0)
+        return false;
+
+    const std::shared_ptr<yolo26::LetterBoxPlan> plan = letterbox_plan(prepared.src_w, prepared.src_h);
+    if (!plan)
+        return false;
+
+    yolo26::LetterBoxInfo lb = plan->info();
+    lb.src_scale_x = prepared.info.src_scale_x;
+    lb.src_scale_y = prepared.info.src_scale_y;
+    if (yolo26::prepared_matches(prepared, lb, config_.padding_value, config_.raw_bgr_input))
+        return infer(prepared.input, lb, prepared.img_w, prepared.img_h, 0, objects, yolo26::thread_workspace());
+
+    // Another model prepared the frame for a different input: resample its letterboxed content
+    // instead of reading the source again.
+    yolo26::LetterBoxPlan::Lease lease(*plan);
+    if (!yolo26::resample_input(prepared, *plan, config_.padding_value, config_.raw_bgr_input, lease.input()))
+        return false;
+    return infer(lease.input(), lb, prepared.img_w, prepared.img_h, 0, objects, yolo26::thread_workspace());
+}
+
+bool Yolo26::infer(const ncnn::Mat& in_pad,
+                   const yolo26::LetterBoxInfo& lb,
+                   int img_w,
+                   int img_h,
+                   int num_threads,
+                   std::vector<Yolo26Object>& objects,
+                   Yolo26Workspace& workspace) const
+{
+    if (!infer_proposals(in_pad, num_threads, workspace))
+        return false;
+    emit_proposals(workspace, lb, img_w, img_h, objects);
+    return true;
+}
+
+bool Yolo26::infer_proposals(const ncnn::Mat& in_pad, int num_threads, Yolo26Workspace& workspace) const
+{
+    // The call runs on this snapshot to the end, even if reload() swaps the model meanwhile.
+    const std::shared_ptr<const yolo26::LoadedModel> model = model_->get();
+    if (!model)
+        return false;
+
+    // Declared before the extractor: every blob it allocates, outputs included, must be freed first.
+    yolo26::AllocatorPool::Lease allocators(*allocators_);
+    ncnn::Extractor ex = yolo26::create_extractor(model->net, allocators, num_threads);
+    if (!model->io.input(ex, config_.input_name, in_pad))
         return false;
 
     ncnn::Mat out;
-    if (!yolo26::ncnn_extract_out0(ex, config_.output_name, out))
+    if (!model->io.output(ex, config_.output_name, out))
+        return false;
+
+    return select_proposals(out, model->io.layout, workspace);
+}
+
+bool Yolo26::extract(const ncnn::Mat& in_pad, ncnn::Mat& out, Yolo26OutputLayout& layout) const
+{
+    const std::shared_ptr<const yolo26::LoadedModel> model = model_->get();
+    if (!model)
+        return false;
+
+    yolo26::AllocatorPool::Lease allocators(*allocators_);
+    ncnn::Extractor ex = yolo26::create_extractor(model->net, allocators, 0);
+    if (!model->io.input(ex, config_.input_name, in_pad))
+        return false;
+
+    ncnn::Mat raw;
+    if (!model->io.output(ex, config_.output_name, raw) || raw.empty())
+        return false;
+    layout = model->io.layout;
+
+    // The leased pool goes back with this call; copy into `out`, whose storage is reused while the
+    // output shape stays the same.
+    out.create_like(raw);
+    if (out.empty())
+        return false;
+    std::memcpy(out.data, raw.data, raw.total() * raw.elemsize);
+    return true;
+}
+
+bool Yolo26::postprocess(const ncnn::Mat& out,
+                         Yolo26OutputLayout layout,
+                         const yolo26::LetterBoxInfo& lb,
+                         int img_w,
+                         int img_h,
+                         std::vector<Yolo26Object>& objects,
+                         Yolo26Workspace& workspace) const
+{
+    if (!select_proposals(out, layout, workspace))
+        return false;
+    emit_proposals(workspace, lb, img_w, img_h, objects);
+    return true;
+}
+
+bool Yolo26::select_proposals(const ncnn::Mat& out, Yolo26OutputLayout layout, Yolo26Workspace& workspace) const
+{
+    // Candidates stay in the workspace; callers only ever see the final detections.
+    std::vector<Yolo26Object>& proposals = workspace.impl_->proposals;
+    bool end2end = false;
+    if (!decode(out, layout, proposals, end2end, workspace))
         return false;
+    suppress(proposals, end2end, workspace);
+    return true;
+}
+
+void Yolo26::emit_proposals(const Yolo26Workspace& workspace,
+                            const yolo26::LetterBoxInfo& lb,
+                            int img_w,
+                            int img_h,
+                            std::vector<Yolo26Object>& objects) const
+{
+    const std::vector<Yolo26Object>& proposals = workspace.impl_->proposals;
+    objects.assign(proposals.begin(), proposals.end());
+
+    for (auto& obj : objects)
+    {
+        float x1 = obj.x1;
+        float y1 = obj.y1;
+        float x2 = obj.x2;
+        float y2 = obj.y2;
+        yolo26::scale_xyxy_inplace(x1, y1, x2, y2, img_w, img_h, lb, true);
+
+        obj.x1 = x1;
+        obj.y1 = y1;
+        obj.x2 = x2;
+        obj.y2 = y2;
+    }
+}
+
+Yolo26PostprocessType Yolo26::postprocess_type() const
+{
+    if (config_.postprocess != Yolo26PostprocessType::Auto)
+        return config_.postprocess;
+    return config_.box_format == Yolo26BoxFormat::XYXY ? Yolo26PostprocessType::TopK : Yolo26PostprocessType::NMS;
+}
+
+bool Yolo26::decode(const ncnn::Mat& out,
+                    Yolo26OutputLayout hint,
+                    std::vector<Yolo26Object>& objects,
+                    bool& end2end,
+                    Yolo26Workspace& workspace) const
+{
+    Yolo26Workspace::Impl& ws = *workspace.impl_;
+    objects.clear();
 
     ncnn::Mat out_2d;
     if (!yolo26::to_mat2d(out, out_2d))
         return false;
 
     const int det_dim = 4 + config_.num_classes;
-    const bool is_end2end_out = (out_2d.w == 6 && out_2d.h > 0) || (out_2d.h == 6 && out_2d.w > 0);
-    Yolo26PostprocessType postprocess = config_.postprocess;
-    if (postprocess == Yolo26PostprocessType::Auto)
-        postprocess = (config_.box_format == Yolo26BoxFormat::XYXY) ? Yolo26PostprocessType::TopK : Yolo26PostprocessType::NMS;
+    // The layout found at load() is checked against this output's shape and taken as is.
+    const Yolo26OutputLayout layout = yolo26::resolve_output_layout(out_2d.w, out_2d.h, det_dim, 6, hint);
+    end2end = layout == Yolo26OutputLayout::End2EndRows || layout == Yolo26OutputLayout::End2EndCols;
+    const Yolo26PostprocessType postprocess = postprocess_type();
 
-    if (out_2d.h == det_dim && out_2d.w > 0)
+    if (layout == Yolo26OutputLayout::ChannelMajor)
     {
         const int num_anchors = out_2d.w;
         const float* box_p0 = out_2d.row(0);
@@ -87,20 +672,21 @@ bool Yolo26::detect(const cv::Mat& bgr, std::vector<Yolo26Object>& objects) cons
         const float* box_p2 = out_2d.row(2);
         const float* box_p3 = out_2d.row(3);
 
-        std::vector<const float*> score_rows(config_.num_classes);
+        std::vector<const float*>& score_rows = ws.score_rows;
+        score_rows.resize(config_.num_classes);
         for (int c = 0; c < config_.num_classes; c++)
         {
             score_rows[c] = out_2d.row(4 + c);
         }
 
-        std::vector<Yolo26Object> proposals;
         if (postprocess == Yolo26PostprocessType::TopK)
         {
-            const auto topk = yolo26::get_topk_index(
+            const std::vector<yolo26::TopKResult>& topk = yolo26::get_topk_index(
                 num_anchors, config_.num_classes, config_.max_det,
-                [&](int anchor, int cls) { return score_rows[cls][anchor]; });
+                [&](int anchor, int cls) { return score_rows[cls][anchor]; },
+                ws.topk);
 
-            proposals.reserve(topk.size());
+            objects.reserve(topk.size());
             for (const auto& cand : topk)
             {
                 if (cand.score < config_.conf_threshold)
@@ -129,12 +715,12 @@ bool Yolo26::detect(const cv::Mat& bgr, std::vector<Yolo26Object>& objects) cons
                 }
                 obj.prob = cand.score;
                 obj.label = cand.cls;
-                proposals.push_back(obj);
+                objects.push_back(obj);
             }
         }
         else
         {
-            proposals.reserve((size_t)num_anchors);
+            objects.reserve((size_t)num_anchors);
             for (int i = 0; i < num_anchors; i++)
             {
                 float best = score_rows[0][i];
@@ -173,25 +759,24 @@ bool Yolo26::detect(const cv::Mat& bgr, std::vector<Yolo26Object>& objects) cons
                 }
                 obj.prob = best;
                 obj.label = best_cls;
-                proposals.push_back(obj);
+                objects.push_back(obj);
             }
         }
 
-        objects.swap(proposals);
     }
     // Some converters may output [num_anchors, 4+nc] i.e. (8400, 84).
-    else if (out_2d.w == det_dim && out_2d.h > 0)
+    else if (layout == Yolo26OutputLayout::AnchorMajor)
     {
         const int num_anchors = out_2d.h;
 
-        std::vector<Yolo26Object> proposals;
         if (postprocess == Yolo26PostprocessType::TopK)
         {
-            const auto topk = yolo26::get_topk_index(
+            const std::vector<yolo26::TopKResult>& topk = yolo26::get_topk_index(
                 num_anchors, config_.num_classes, config_.max_det,
-                [&](int anchor, int cls) { return out_2d.row(anchor)[4 + cls]; });
+                [&](int anchor, int cls) { return out_2d.row(anchor)[4 + cls]; },
+                ws.topk);
 
-            proposals.reserve(topk.size());
+            objects.reserve(topk.size());
             for (const auto& cand : topk)
             {
                 if (cand.score < config_.conf_threshold)
@@ -220,12 +805,12 @@ bool Yolo26::detect(const cv::Mat& bgr, std::vector<Yolo26Object>& objects) cons
                 }
                 obj.prob = cand.score;
                 obj.label = cand.cls;
-                proposals.push_back(obj);
+                objects.push_back(obj);
             }
         }
         else
         {
-            proposals.reserve((size_t)num_anchors);
+            objects.reserve((size_t)num_anchors);
             for (int i = 0; i < num_anchors; i++)
             {
                 const float* p = out_2d.row(i);
@@ -266,18 +851,16 @@ bool Yolo26::detect(const cv::Mat& bgr, std::vector<Yolo26Object>& objects) cons
                 }
                 obj.prob = best;
                 obj.label = best_cls;
-                proposals.push_back(obj);
+                objects.push_back(obj);
             }
         }
 
-        objects.swap(proposals);
     }
     // End-to-end export outputs (already top-k): [num_dets, 6] i.e. (300, 6) with xyxy + score + cls.
-    else if (out_2d.w == 6 && out_2d.h > 0)
+    else if (layout == Yolo26OutputLayout::End2EndRows)
     {
-        std::vector<Yolo26Object> proposals;
         const int num_dets = out_2d.h;
-        proposals.reserve(std::min(num_dets, config_.max_det));
+        objects.reserve(std::min(num_dets, config_.max_det));
         for (int i = 0; i < num_dets; i++)
         {
             const float* p = out_2d.row(i);
@@ -292,15 +875,14 @@ bool Yolo26::detect(const cv::Mat& bgr, std::vector<Yolo26Object>& objects) cons
             obj.y2 = p[3];
             obj.prob = score;
             obj.label = (int)p[5];
-            proposals.push_back(obj);
-            if ((int)proposals.size() >= config_.max_det)
+            objects.push_back(obj);
+            if ((int)objects.size() >= config_.max_det)
                 break;
         }
 
-        objects.swap(proposals);
     }
     // Some converters may output [6, num_dets] i.e. (6, 300).
-    else if (out_2d.h == 6 && out_2d.w > 0)
+    else if (layout == Yolo26OutputLayout::End2EndCols)
     {
         const int num_dets = out_2d.w;
         const float* x1_row = out_2d.row(0);
@@ -310,8 +892,7 @@ bool Yolo26::detect(const cv::Mat& bgr, std::vector<Yolo26Object>& objects) cons
         const float* score_row = out_2d.row(4);
         const float* cls_row = out_2d.row(5);
 
-        std::vector<Yolo26Object> proposals;
-        proposals.reserve(std::min(num_dets, config_.max_det));
+        objects.reserve(std::min(num_dets, config_.max_det));
         for (int i = 0; i < num_dets; i++)
         {
             const float score = score_row[i];
@@ -325,45 +906,298 @@ bool Yolo26::detect(const cv::Mat& bgr, std::vector<Yolo26Object>& objects) cons
             obj.y2 = y2_row[i];
             obj.prob = score;
             obj.label = (int)cls_row[i];
-            proposals.push_back(obj);
-            if ((int)proposals.size() >= config_.max_det)
+            objects.push_back(obj);
+            if ((int)objects.size() >= config_.max_det)
                 break;
         }
 
-        objects.swap(proposals);
     }
     else
     {
         return false;
     }
 
-    if (!is_end2end_out && postprocess == Yolo26PostprocessType::NMS)
+    return true;
+}
+
+void Yolo26::suppress(std::vector<Yolo26Object>& objects, bool end2end, Yolo26Workspace& workspace) const
+{
+    const Yolo26PostprocessType postprocess = postprocess_type();
+    if (!end2end && postprocess == Yolo26PostprocessType::NMS)
     {
-        objects = yolo26::nms(objects, config_.iou_threshold, config_.agnostic_nms);
+        yolo26::nms_inplace(objects, config_.iou_threshold, config_.agnostic_nms, workspace.impl_->nms);
         if ((int)objects.size() > config_.max_det)
             objects.resize((size_t)config_.max_det);
     }
 
     if (postprocess == Yolo26PostprocessType::TopK && config_.topk_dedup)
     {
-        objects = yolo26::nms(objects, config_.iou_threshold, config_.agnostic_nms);
+        yolo26::nms_inplace(objects, config_.iou_threshold, config_.agnostic_nms, workspace.impl_->nms);
         if ((int)objects.size() > config_.max_det)
             objects.resize((size_t)config_.max_det);
     }
+}
 
-    for (auto& obj : objects)
+bool Yolo26::detect_tiled(const Yolo26Image& src, std::vector<Yolo26Object>& objects) const
+{
+    const bool is_yuv = src.format == Yolo26PixelFormat::NV12 || src.format == Yolo26PixelFormat::NV21
+                        || src.format == Yolo26PixelFormat::I420;
+    const std::vector<yolo26::TileRect> tiles = yolo26::tile_grid(
+        src.width, src.height, config_.input_width, config_.input_height, config_.tile_overlap, is_yuv ? 2 : 1);
+    const int num_tiles = (int)tiles.size();
+    const int num_jobs = num_tiles + (config_.tile_full_pass ? 1 : 0);
+
+    // Split the ncnn threads between tiles in flight instead of oversubscribing the cores.
+    const int workers = std::min(num_jobs, tile_pool_->size() + 1);
+    const std::shared_ptr<const yolo26::LoadedModel> model = model_->get();
+    if (!model)
+        return false;
+    const int threads = std::max(1, model->net.opt.num_threads / workers);
+
+    // Each job keeps only its final boxes, so memory stays at one input tensor per worker.
+    std::vector<std::vector<Yolo26Object>> results((size_t)num_jobs);
+    std::vector<char> ok((size_t)num_jobs, 0);
+    tile_pool_->parallel_for(num_jobs, workers, [&](int k) {
+        if (k == num_tiles)
+        {
+            ok[k] = detect_once(src, threads, results[k], yolo26::thread_workspace());
+            return;
+        }
+        Yolo26Image roi;
+        const yolo26::TileRect& t = tiles[k];
+        if (yolo26::crop_image(src, t.x, t.y, t.w, t.h, roi))
+            ok[k] = detect_once(roi, threads, results[k], yolo26::thread_workspace());
+    });
+
+    // Tile results are in tile pixels of src; map them to original image coordinates.
+    const float sx = src.orig_width / (float)src.width;
+    const float sy = src.orig_height / (float)src.height;
+    std::vector<Yolo26Object> merged;
+    std::vector<yolo26::TileOrigin> origins;
+    for (int k = 0; k < num_jobs; k++)
     {
-        float x1 = obj.x1;
-        float y1 = obj.y1;
-        float x2 = obj.x2;
-        float y2 = obj.y2;
-        yolo26::scale_xyxy_inplace(x1, y1, x2, y2, img_w, img_h, lb, true);
+        if (!ok[k])
+            return false;
+        for (const auto& det : results[k])
+        {
+            Yolo26Object obj = det;
+            yolo26::TileOrigin origin;
+            if (k < num_tiles)
+            {
+                const yolo26::TileRect& t = tiles[k];
+                obj.x1 = (obj.x1 + t.x) * sx;
+                obj.y1 = (obj.y1 + t.y) * sy;
+                obj.x2 = (obj.x2 + t.x) * sx;
+                obj.y2 = (obj.y2 + t.y) * sy;
+                origin.tile = k;
+                origin.cut = yolo26::tile_box_is_cut(
+                    t, src.width, src.height, det.x1 + t.x, det.y1 + t.y, det.x2 + t.x, det.y2 + t.y);
+            }
+            merged.push_back(obj);
+            origins.push_back(origin);
+        }
+    }
 
-        obj.x1 = x1;
-        obj.y1 = y1;
-        obj.x2 = x2;
-        obj.y2 = y2;
+    // A cut box counts as the same object when 60% of it lies inside a box from another window.
+    std::vector<int> absorbed_by;
+    const std::vector<int> keep = yolo26::merge_tiles(
+        merged, origins, config_.iou_threshold, 0.6f, config_.agnostic_nms, absorbed_by);
+
+    objects.clear();
+    objects.reserve(std::min((int)keep.size(), config_.max_det));
+    for (int i : keep)
+    {
+        if ((int)objects.size() >= config_.max_det)
+            break;
+        objects.push_back(merged[i]);
     }
+    return true;
+}
+
+bool Yolo26::detect_mosaic(const std::vector<Yolo26Image>& images,
+                           std::vector<std::vector<Yolo26Object>>& objects) const
+{
+    const int cells = std::max(1, config_.mosaic_cols) * std::max(1, config_.mosaic_rows);
+    objects.assign(images.size(), std::vector<Yolo26Object>());
+    for (size_t first = 0; first < images.size(); first += (size_t)cells)
+    {
+        const int count = (int)std::min(images.size() - first, (size_t)cells);
+        if (!detect_canvas(&images[first], count, &objects[first]))
+            return false;
+    }
+    return true;
+}
 
+bool Yolo26::detect_canvas(const Yolo26Image* images, int count, std::vector<Yolo26Object>* objects, bool native) const
+{
+    const int cols = std::max(1, config_.mosaic_cols);
+    const int rows = std::max(1, config_.mosaic_rows);
+    const int input_w = config_.input_width;
+    const int input_h = config_.input_height;
+    const int cell_w = input_w / cols;
+    const int cell_h = input_h / rows;
+    const std::shared_ptr<const yolo26::LoadedModel> model = model_->get();
+    if (!model || cell_w <= 0 || cell_h <= 0)
+        return false;
+
+    // The canvas comes from the buffer pool of the identity plan at the input size; its row scratch
+    // (6 * input_w floats) is large enough for any cell.
+    const std::shared_ptr<yolo26::LetterBoxPlan> canvas_plan = letterbox_plans_->get(
+        input_w, input_h, input_w, input_h, config_.scaleup, config_.center);
+    if (!canvas_plan || !canvas_plan->valid())
+        return false;
+    yolo26::LetterBoxPlan::Lease lease(*canvas_plan);
+    ncnn::Mat& canvas = lease.input();
+
+    const float pad = config_.padding_value * (config_.raw_bgr_input ? 1.f : 1 / 255.f);
+    auto fill = [&](int x, int y, int w, int h) {
+        for (int c = 0; c < 3; c++)
+        {
+            for (int yy = y; yy < y + h; yy++)
+            {
+                float* p = (float*)canvas.data + canvas.cstep * c + (size_t)yy * input_w + x;
+                std::fill(p, p + w, pad);
+            }
+        }
+    };
+    if (cols * cell_w != input_w || rows * cell_h != input_h)
+        fill(0, 0, input_w, input_h);
+
+    std::vector<yolo26::LetterBoxInfo> cell_lb((size_t)count);
+    std::vector<Yolo26Image> srcs((size_t)count);
+    for (int i = 0; i < cols * rows; i++)
+    {
+        const int cx = (i % cols) * cell_w;
+        const int cy = (i / cols) * cell_h;
+        if (i >= count)
+        {
+            fill(cx, cy, cell_w, cell_h);
+            continue;
+        }
+
+        Yolo26Image& src = srcs[i];
+        if (!yolo26::resolve_image(images[i], src))
+            return false;
+        if (native && (src.width > cell_w || src.height > cell_h))
+            return false;
+        const std::shared_ptr<yolo26::LetterBoxPlan> plan = letterbox_plans_->get(
+            src.width, src.height, cell_w, cell_h, config_.scaleup && !native, config_.center);
+        if (!plan || !plan->valid())
+            return false;
+        plan->run(src, config_.padding_value, canvas, lease.rows(), config_.raw_bgr_input, cx, cy);
+        cell_lb[i] = plan->info();
+        cell_lb[i].src_scale_x = src.orig_width / (float)src.width;
+        cell_lb[i].src_scale_y = src.orig_height / (float)src.height;
+    }
+
+    yolo26::AllocatorPool::Lease allocators(*allocators_);
+    ncnn::Extractor ex = yolo26::create_extractor(model->net, allocators);
+    if (!model->io.input(ex, config_.input_name, canvas))
+        return false;
+
+    ncnn::Mat out;
+    if (!model->io.output(ex, config_.output_name, out))
+        return false;
+
+    std::vector<Yolo26Object> proposals;
+    bool end2end = false;
+    if (!decode(out, model->io.layout, proposals, end2end, yolo26::thread_workspace()))
+        return false;
+
+    // Assign each box to the cell holding its center; drop it if it reaches into a neighbouring cell.
+    const float tolerance = 2.f;
+    for (const auto& det : proposals)
+    {
+        const int col = (int)std::floor((det.x1 + det.x2) * 0.5f / cell_w);
+        const int row = (int)std::floor((det.y1 + det.y2) * 0.5f / cell_h);
+        if (col < 0 || col >= cols || row < 0 || row >= rows || row * cols + col >= count)
+            continue;
+        const float cx = (float)(col * cell_w);
+        const float cy = (float)(row * cell_h);
+        if (det.x1 < cx - tolerance || det.y1 < cy - tolerance || det.x2 > cx + cell_w + tolerance
+            || det.y2 > cy + cell_h + tolerance)
+            continue;
+
+        Yolo26Object obj = det;
+        obj.x1 -= cx;
+        obj.y1 -= cy;
+        obj.x2 -= cx;
+        obj.y2 -= cy;
+        objects[row * cols + col].push_back(obj);
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        suppress(objects[i], end2end, yolo26::thread_workspace());
+        for (auto& obj : objects[i])
+        {
+            float x1 = obj.x1;
+            float y1 = obj.y1;
+            float x2 = obj.x2;
+            float y2 = obj.y2;
+            yolo26::scale_xyxy_inplace(x1, y1, x2, y2, srcs[i].orig_width, srcs[i].orig_height, cell_lb[i], true);
+
+            obj.x1 = x1;
+            obj.y1 = y1;
+            obj.x2 = x2;
+            obj.y2 = y2;
+        }
+    }
+
+    return true;
+}
+
+bool Yolo26::detect_regions(const Yolo26Image& image,
+                            const std::vector<cv::Rect>& regions,
+                            std::vector<Yolo26Object>& objects) const
+{
+    objects.clear();
+    const int cells = std::max(1, config_.mosaic_cols) * std::max(1, config_.mosaic_rows);
+    Yolo26Image src;
+    if (regions.empty() || (int)regions.size() > cells || !yolo26::resolve_image(image, src))
+        return false;
+
+    const int align = (src.format == Yolo26PixelFormat::NV12 || src.format == Yolo26PixelFormat::NV21
+                       || src.format == Yolo26PixelFormat::I420)
+                          ? 2
+                          : 1;
+    const float sx = src.orig_width / (float)src.width;
+    const float sy = src.orig_height / (float)src.height;
+
+    // Each region grows to its size bucket (shifted back inside the image when it would run past
+    // it); its view reports in its own original-resolution coordinates.
+    std::vector<cv::Rect> rects(regions.size());
+    std::vector<Yolo26Image> views(regions.size());
+    for (size_t i = 0; i < regions.size(); i++)
+    {
+        const cv::Rect r = regions[i] & cv::Rect(0, 0, src.width, src.height);
+        if (r.empty())
+            return false;
+        cv::Rect& b = rects[i];
+        b.width = std::min(src.width, (r.width + kRegionBucket - 1) / kRegionBucket * kRegionBucket);
+        b.height = std::min(src.height, (r.height + kRegionBucket - 1) / kRegionBucket * kRegionBucket);
+        b.x = std::max(0, std::min(r.x, src.width - b.width)) / align * align;
+        b.y = std::max(0, std::min(r.y, src.height - b.height)) / align * align;
+        if (!yolo26::crop_image(src, b.x, b.y, b.width, b.height, views[i]))
+            return false;
+        views[i].orig_width = (int)std::round(b.width * sx);
+        views[i].orig_height = (int)std::round(b.height * sy);
+    }
+
+    std::vector<std::vector<Yolo26Object>> found(regions.size());
+    if (!detect_canvas(views.data(), (int)views.size(), found.data(), true))
+        return false;
+
+    for (size_t i = 0; i < found.size(); i++)
+    {
+        for (Yolo26Object obj : found[i])
+        {
+            obj.x1 += rects[i].x * sx;
+            obj.y1 += rects[i].y * sy;
+            obj.x2 += rects[i].x * sx;
+            obj.y2 += rects[i].y * sy;
+            objects.push_back(obj);
+        }
+    }
     return true;
 }
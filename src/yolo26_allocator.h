@@ -0,0 +1,238 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include "allocator.h"
+#include "net.h"
+
+namespace yolo26 {
+
+// Serves requests of at least min_size bytes from 2 MB pages: MAP_HUGETLB while the kernel has huge
+// pages reserved, otherwise a 2 MB aligned anonymous mapping advised MADV_HUGEPAGE (transparent huge
+// pages). Freed blocks are kept on a free list and handed to later requests they fit, so steady-state
+// inference maps nothing. Smaller requests go to an UnlockedPoolAllocator. Not locked, like the
+// allocators AllocatorPool leases out. Outside Linux everything goes to the pool allocator.
+class HugePageAllocator : public ncnn::Allocator {
+    struct Block {
+        void* ptr;
+        size_t size;  // mapped bytes, a multiple of kHugePage
+    };
+
+public:
+    static const size_t kHugePage = (size_t)2 << 20;
+
+    explicit HugePageAllocator(size_t min_size = (size_t)256 << 10)
+        : min_size_(min_size)
+    {
+    }
+
+    HugePageAllocator(const HugePageAllocator&) = delete;
+    HugePageAllocator& operator=(const HugePageAllocator&) = delete;
+
+    virtual ~HugePageAllocator()
+    {
+        for (const Block& b : used_)
+            unmap(b);
+        for (const Block& b : free_)
+            unmap(b);
+    }
+
+    virtual void* fastMalloc(size_t size)
+    {
+        if (size < min_size_)
+            return small_.fastMalloc(size);
+
+        // Room for the bytes ncnn kernels may read past the end of a Mat.
+        const size_t need = (size + NCNN_MALLOC_OVERREAD + kHugePage - 1) / kHugePage * kHugePage;
+        size_t best = free_.size();
+        for (size_t i = 0; i < free_.size(); i++)
+        {
+            if (free_[i].size >= need && free_[i].size <= need * 2 && (best == free_.size() || free_[i].size < free_[best].size))
+                best = i;
+        }
+        if (best != free_.size())
+        {
+            used_.push_back(free_[best]);
+            free_.erase(free_.begin() + best);
+            return used_.back().ptr;
+        }
+
+        Block b;
+        b.size = need;
+        b.ptr = map(need);
+        if (!b.ptr)
+            return small_.fastMalloc(size);
+        used_.push_back(b);
+        return b.ptr;
+    }
+
+    virtual void fastFree(void* ptr)
+    {
+        for (size_t i = 0; i < used_.size(); i++)
+        {
+            if (used_[i].ptr == ptr)
+            {
+                free_.push_back(used_[i]);
+                used_.erase(used_.begin() + i);
+                // Shapes that stopped occurring should not pin their pages forever.
+                if (free_.size() > kMaxFree)
+                {
+                    unmap(free_.front());
+                    free_.erase(free_.begin());
+                }
+                return;
+            }
+        }
+        small_.fastFree(ptr);
+    }
+
+private:
+    static const size_t kMaxFree = 16;
+
+    void* map(size_t size)
+    {
+#if defined(__linux__)
+#if defined(MAP_HUGETLB)
+        if (hugetlb_)
+        {
+            void* p = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED)
+                return p;
+            hugetlb_ = false;  // none reserved (vm.nr_hugepages) or used up; THP from here on
+        }
+#endif
+        // Over-map by a huge page and trim, so the block starts on the 2 MB boundary THP needs.
+        void* raw = mmap(0, size + kHugePage, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED)
+            return 0;
+        const uintptr_t begin = (uintptr_t)raw;
+        const uintptr_t aligned = (begin + kHugePage - 1) & ~(uintptr_t)(kHugePage - 1);
+        if (aligned > begin)
+            munmap(raw, aligned - begin);
+        if (begin + kHugePage > aligned)
+            munmap((void*)(aligned + size), begin + kHugePage - aligned);
+#if defined(MADV_HUGEPAGE)
+        madvise((void*)aligned, size, MADV_HUGEPAGE);
+#endif
+        return (void*)aligned;
+#else
+        return 0;
+#endif
+    }
+
+    static void unmap(const Block& b)
+    {
+#if defined(__linux__)
+        munmap(b.ptr, b.size);
+#endif
+    }
+
+    size_t min_size_;
+    bool hugetlb_ = true;
+    std::vector<Block> used_;
+    std::vector<Block> free_;
+    ncnn::UnlockedPoolAllocator small_;
+};
+
+// Pooled blob + workspace allocators, one pair per extraction in flight. UnlockedPoolAllocator takes
+// no lock, so a pair must never serve two extractors at once; the pool leases them out per call and
+// grows to the peak number of concurrent callers. Slots are reused LIFO, so a thread calling in a
+// loop keeps getting the pair whose free lists it has already warmed.
+// huge_pages backs the pairs with HugePageAllocator instead.
+class AllocatorPool {
+    struct Slot {
+        std::unique_ptr<ncnn::Allocator> blob;
+        std::unique_ptr<ncnn::Allocator> workspace;
+    };
+
+public:
+    explicit AllocatorPool(bool huge_pages = false)
+        : huge_pages_(huge_pages)
+    {
+    }
+    AllocatorPool(const AllocatorPool&) = delete;
+    AllocatorPool& operator=(const AllocatorPool&) = delete;
+
+    // Keep the lease alive until every ncnn::Mat produced by the extractor (outputs included) is gone.
+    class Lease {
+    public:
+        explicit Lease(AllocatorPool& pool)
+            : pool_(pool), slot_(pool.acquire())
+        {
+        }
+        ~Lease() { pool_.release(slot_); }
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        ncnn::Allocator* blob() { return slot_->blob.get(); }
+        ncnn::Allocator* workspace() { return slot_->workspace.get(); }
+
+    private:
+        AllocatorPool& pool_;
+        Slot* slot_;
+    };
+
+    // Number of allocator pairs created so far (peak concurrency).
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return slots_.size();
+    }
+
+private:
+    Slot* acquire()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.empty())
+        {
+            std::unique_ptr<Slot> slot(new Slot);
+            if (huge_pages_)
+            {
+                slot->blob.reset(new HugePageAllocator);
+                slot->workspace.reset(new HugePageAllocator);
+            }
+            else
+            {
+                slot->blob.reset(new ncnn::UnlockedPoolAllocator);
+                slot->workspace.reset(new ncnn::UnlockedPoolAllocator);
+            }
+            slots_.push_back(std::move(slot));
+            return slots_.back().get();
+        }
+        Slot* slot = free_.back();
+        free_.pop_back();
+        return slot;
+    }
+
+    void release(Slot* slot)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.push_back(slot);
+    }
+
+    const bool huge_pages_;
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Slot>> slots_;
+    std::vector<Slot*> free_;
+};
+
+// Extractor wired to a leased allocator pair; num_threads > 0 overrides the net's thread count.
+inline ncnn::Extractor create_extractor(const ncnn::Net& net, AllocatorPool::Lease& allocators, int num_threads = 0)
+{
+    ncnn::Extractor ex = net.create_extractor();
+    ex.set_blob_allocator(allocators.blob());
+    ex.set_workspace_allocator(allocators.workspace());
+    if (num_threads > 0)
+        ex.set_num_threads(num_threads);
+    return ex;
+}
+
+}  // namespace yolo26
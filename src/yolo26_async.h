@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "yolo26_image.h"
+
+namespace yolo26 {
+
+// Worker threads behind detect_async(): a bounded FIFO that rejects instead of blocking when full,
+// so an event loop is never stalled and sees backpressure as a failed submit.
+class AsyncQueue {
+public:
+    typedef std::chrono::steady_clock Clock;
+    // Receives the time the job spent waiting for a worker, in milliseconds.
+    typedef std::function<void(double)> Job;
+
+    AsyncQueue(int num_workers, int depth)
+        : depth_(std::max(1, depth))
+    {
+        for (int i = 0; i < std::max(1, num_workers); i++)
+            threads_.emplace_back([this] { worker(); });
+    }
+
+    // Runs every job already accepted, then joins.
+    ~AsyncQueue()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cond_.notify_all();
+        for (auto& t : threads_)
+            t.join();
+    }
+
+    AsyncQueue(const AsyncQueue&) = delete;
+    AsyncQueue& operator=(const AsyncQueue&) = delete;
+
+    // False when `depth` jobs are already waiting.
+    bool try_submit(Job job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stop_ || (int)jobs_.size() >= depth_)
+                return false;
+            jobs_.push_back(Entry{std::move(job), Clock::now()});
+        }
+        cond_.notify_one();
+        return true;
+    }
+
+    // Blocks until no job is queued or running.
+    void wait_idle()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.wait(lock, [this] { return jobs_.empty() && running_ == 0; });
+    }
+
+    int queued() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return (int)jobs_.size();
+    }
+
+private:
+    struct Entry {
+        Job job;
+        Clock::time_point submitted;
+    };
+
+    void worker()
+    {
+        for (;;)
+        {
+            Entry entry;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cond_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+                if (stop_ && jobs_.empty())
+                    return;
+                entry = std::move(jobs_.front());
+                jobs_.pop_front();
+                running_++;
+            }
+
+            entry.job(std::chrono::duration<double, std::milli>(Clock::now() - entry.submitted).count());
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--running_ == 0 && jobs_.empty())
+                idle_.notify_all();
+        }
+    }
+
+    const int depth_;
+    std::vector<std::thread> threads_;
+    mutable std::mutex mutex_;
+    std::condition_variable cond_;
+    std::condition_variable idle_;
+    std::deque<Entry> jobs_;
+    int running_ = 0;
+    bool stop_ = false;
+};
+
+// detect_async() body shared by Yolo26 and Yolo26Seg: times `detect` on a worker and hands the
+// result to `callback` on that worker. `hold` keeps a cv::Mat frame referenced until then.
+template <typename Result, typename Detect>
+bool submit_detect(AsyncQueue* queue,
+                   const Yolo26Image& image,
+                   const cv::Mat& hold,
+                   const std::function<void(Result&)>& callback,
+                   const Detect& detect)
+{
+    if (!queue || !callback)
+        return false;
+
+    return queue->try_submit([image, hold, callback, detect](double queue_ms) {
+        Result result;
+        result.queue_ms = queue_ms;
+        const AsyncQueue::Clock::time_point t0 = AsyncQueue::Clock::now();
+        result.ok = detect(image, result.objects);
+        result.compute_ms = std::chrono::duration<double, std::milli>(AsyncQueue::Clock::now() - t0).count();
+        callback(result);
+    });
+}
+
+}  // namespace yolo26
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstring>
+
+#include "datareader.h"
+
+namespace yolo26 {
+
+// Weights from a buffer of known size, referenced in place like ncnn::DataReaderFromMemory, but a read
+// past the end fails the layer's load instead of running off the mapping. remaining() is 0 once a
+// model consumed exactly the buffer.
+class BoundedDataReader : public ncnn::DataReader {
+public:
+    BoundedDataReader(const unsigned char* mem, size_t size)
+        : mem_(mem), left_(size)
+    {
+    }
+
+    virtual size_t read(void* buf, size_t size) const
+    {
+        if (size > left_)
+            return 0;
+        std::memcpy(buf, mem_, size);
+        mem_ += size;
+        left_ -= size;
+        return size;
+    }
+
+    virtual size_t reference(size_t size, const void** buf) const
+    {
+        if (size > left_)
+            return 0;
+        *buf = mem_;
+        mem_ += size;
+        left_ -= size;
+        return size;
+    }
+
+    size_t remaining() const { return left_; }
+
+private:
+    mutable const unsigned char* mem_;
+    mutable size_t left_;
+};
+
+}  // namespace yolo26
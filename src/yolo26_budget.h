@@ -0,0 +1,210 @@
+#pragma once
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#include "allocator.h"
+
+#include "yolo26_types.h"
+
+namespace yolo26 {
+
+// Bytes one call holds against a ceiling. Everything the call allocates is charged before it is
+// allocated, so a refused charge means the memory was never taken; add() records memory that was
+// accounted for up front and cannot be refused. ncnn may allocate from its worker threads, hence the
+// lock.
+class MemoryBudget {
+public:
+    explicit MemoryBudget(size_t limit)
+        : limit_(limit)
+    {
+    }
+
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    bool charge(size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (bytes > limit_ - used_)
+        {
+            exceeded_ = true;
+            return false;
+        }
+        used_ += bytes;
+        peak_ = std::max(peak_, used_);
+        return true;
+    }
+
+    void add(size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        used_ += bytes;
+        peak_ = std::max(peak_, used_);
+        exceeded_ = exceeded_ || used_ > limit_;
+    }
+
+    void release(size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        used_ -= std::min(bytes, used_);
+    }
+
+    size_t used() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return used_;
+    }
+
+    size_t peak() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return peak_;
+    }
+
+    bool exceeded() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return exceeded_;
+    }
+
+private:
+    const size_t limit_;
+    mutable std::mutex mutex_;
+    size_t used_ = 0;
+    size_t peak_ = 0;
+    bool exceeded_ = false;
+};
+
+// Blob / workspace allocator that measures an extraction. Nothing is pooled, so blobs freed by light
+// mode return their memory right away and the budget's peak is the extraction's real high-water mark.
+// It never refuses: not every ncnn kernel checks its scratch Mats, so the budget is enforced before
+// the extraction starts, against the peak measured for the input shape (ShapePeaks). A null budget
+// is allowed as long as the allocator is never handed to ncnn.
+class BudgetAllocator : public ncnn::Allocator {
+public:
+    explicit BudgetAllocator(MemoryBudget* budget)
+        : budget_(budget)
+    {
+    }
+
+    virtual void* fastMalloc(size_t size)
+    {
+        // The size sits in front of the block, one alignment unit ahead so the block stays aligned.
+        const size_t bytes = size + NCNN_MALLOC_ALIGN;
+        unsigned char* p = (unsigned char*)ncnn::fastMalloc(bytes);
+        if (!p)
+            return 0;
+        budget_->add(bytes);
+        *(size_t*)p = bytes;
+        return p + NCNN_MALLOC_ALIGN;
+    }
+
+    virtual void fastFree(void* ptr)
+    {
+        if (!ptr)
+            return;
+        unsigned char* p = (unsigned char*)ptr - NCNN_MALLOC_ALIGN;
+        budget_->release(*(size_t*)p);
+        ncnn::fastFree(p);
+    }
+
+private:
+    MemoryBudget* budget_;
+};
+
+// v.reserve(n), with the new buffer charged first (null budget: no accounting). The old buffer's
+// charge is returned once the vector let it go.
+template <typename T>
+bool charge_reserve(std::vector<T>& v, size_t n, MemoryBudget* budget)
+{
+    const size_t old_capacity = v.capacity();
+    if (old_capacity >= n)
+        return true;
+    if (budget && !budget->charge(n * sizeof(T)))
+        return false;
+    v.reserve(n);
+    if (budget)
+        budget->release(old_capacity * sizeof(T));
+    return true;
+}
+
+// Extraction high-water marks (blobs + workspace, outputs included) per input shape of one model,
+// measured by its dry runs with a BudgetAllocator. A budgeted call reserves the peak of its shape
+// before extracting; shapes never measured cannot be budgeted.
+class ShapePeaks {
+    struct Entry {
+        int w;
+        int h;
+        size_t bytes;
+    };
+
+public:
+    void record(int w, int h, size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (Entry& e : entries_)
+        {
+            if (e.w == w && e.h == h)
+            {
+                e.bytes = std::max(e.bytes, bytes);
+                return;
+            }
+        }
+        Entry e;
+        e.w = w;
+        e.h = h;
+        e.bytes = bytes;
+        entries_.push_back(e);
+    }
+
+    bool find(int w, int h, size_t& bytes) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const Entry& e : entries_)
+        {
+            if (e.w == w && e.h == h)
+            {
+                bytes = e.bytes;
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<Entry> entries_;
+};
+
+// Running Yolo26MemoryStats of one detector.
+class MemoryStatsRecorder {
+public:
+    explicit MemoryStatsRecorder(size_t budget_bytes)
+    {
+        stats_.budget_bytes = budget_bytes;
+    }
+
+    void record(const MemoryBudget& budget)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.calls++;
+        stats_.last_peak_bytes = budget.peak();
+        stats_.max_peak_bytes = std::max(stats_.max_peak_bytes, stats_.last_peak_bytes);
+        if (budget.exceeded())
+            stats_.rejected++;
+    }
+
+    Yolo26MemoryStats stats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    Yolo26MemoryStats stats_;
+};
+
+}  // namespace yolo26
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include "yolo26_mapped_file.h"
+#include "yolo26_types.h"
+
+namespace yolo26 {
+
+// Single-file model written by python/export_yolo26_end2end_raw_ncnn.py (little endian):
+//   "Y26BNDL1" | u32 meta_size | u32 param_size | u64 bin_offset | u64 bin_size
+//   metadata (key=value lines) | .param text incl. its NUL | zero padding | .bin at bin_offset
+// bin_offset is a multiple of 4096, so a mapped bundle hands ncnn page-aligned weights and both the
+// .param and the .bin are used straight from the mapping.
+struct Bundle {
+    std::map<std::string, std::string> meta;
+    const char* param = 0;
+    const unsigned char* bin = 0;
+    size_t bin_size = 0;
+
+    std::string get(const std::string& key, const std::string& fallback = std::string()) const
+    {
+        std::map<std::string, std::string>::const_iterator it = meta.find(key);
+        return it == meta.end() ? fallback : it->second;
+    }
+
+    int get_int(const std::string& key, int fallback) const
+    {
+        const std::string v = get(key);
+        return v.empty() ? fallback : std::atoi(v.c_str());
+    }
+};
+
+inline bool parse_bundle(const MappedFile& file, Bundle& bundle)
+{
+    const size_t header_size = 8 + 4 + 4 + 8 + 8;
+    const unsigned char* p = file.data();
+    if (!p || file.size() < header_size || std::memcmp(p, "Y26BNDL1", 8) != 0)
+        return false;
+
+    uint32_t meta_size = 0;
+    uint32_t param_size = 0;
+    uint64_t bin_offset = 0;
+    uint64_t bin_size = 0;
+    std::memcpy(&meta_size, p + 8, 4);
+    std::memcpy(&param_size, p + 12, 4);
+    std::memcpy(&bin_offset, p + 16, 8);
+    std::memcpy(&bin_size, p + 24, 8);
+
+    // Every size is checked against the file without adding untrusted 64-bit values together.
+    const uint64_t size = file.size();
+    const uint64_t param_end = (uint64_t)header_size + meta_size + param_size;
+    if (param_size == 0 || param_end > bin_offset || bin_offset % 4096 != 0 || bin_offset > size
+        || bin_size > size - bin_offset)
+        return false;
+
+    const char* param = (const char*)p + header_size + meta_size;
+    if (param[param_size - 1] != '\0')
+        return false;
+
+    bundle = Bundle();
+    std::istringstream lines(std::string((const char*)p + header_size, meta_size));
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        const size_t eq = line.find('=');
+        if (!line.empty() && line[0] != '#' && eq != std::string::npos)
+            bundle.meta[line.substr(0, eq)] = line.substr(eq + 1);
+    }
+
+    bundle.param = param;
+    bundle.bin = p + bin_offset;
+    bundle.bin_size = (size_t)bin_size;
+    return true;
+}
+
+inline Yolo26OutputLayout parse_output_layout(const std::string& s)
+{
+    if (s == "channel_major")
+        return Yolo26OutputLayout::ChannelMajor;
+    if (s == "anchor_major")
+        return Yolo26OutputLayout::AnchorMajor;
+    if (s == "end2end_rows")
+        return Yolo26OutputLayout::End2EndRows;
+    if (s == "end2end_cols")
+        return Yolo26OutputLayout::End2EndCols;
+    return Yolo26OutputLayout::Auto;
+}
+
+// Overwrites the model-describing fields of a Yolo26Config / Yolo26SegConfig with the bundle's;
+// thresholds and runtime switches stay as the caller set them. False for another task's model.
+template <typename Config>
+bool apply_bundle(const Bundle& bundle, const char* task, Config& config)
+{
+    if (bundle.get("task") != task)
+        return false;
+
+    const int imgsz = bundle.get_int("imgsz", 0);
+    config.input_width = bundle.get_int("input_w", imgsz > 0 ? imgsz : config.input_width);
+    config.input_height = bundle.get_int("input_h", imgsz > 0 ? imgsz : config.input_height);
+    config.num_classes = bundle.get_int("nc", config.num_classes);
+    if (config.input_width <= 0 || config.input_height <= 0 || config.num_classes <= 0)
+        return false;
+
+    const std::string box = bundle.get("box");
+    if (box == "xyxy")
+        config.box_format = Yolo26BoxFormat::XYXY;
+    else if (box == "cxcywh")
+        config.box_format = Yolo26BoxFormat::CXCYWH;
+
+    const std::string post = bundle.get("post");
+    if (post == "topk")
+        config.postprocess = Yolo26PostprocessType::TopK;
+    else if (post == "nms")
+        config.postprocess = Yolo26PostprocessType::NMS;
+
+    config.raw_bgr_input = bundle.get("input") == "bgr_raw";
+    config.output_layout = parse_output_layout(bundle.get("layout"));
+    config.input_name = bundle.get("input_blob", config.input_name);
+    config.output_name = bundle.get("output_blob", config.output_name);
+
+    config.class_names.clear();
+    for (int i = 0; i < config.num_classes; i++)
+    {
+        std::ostringstream key;
+        key << "name." << i;
+        config.class_names.push_back(bundle.get(key.str()));
+    }
+    return true;
+}
+
+}  // namespace yolo26
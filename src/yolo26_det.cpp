@@ -1,6 +1,7 @@
 #include "yolo26.h"
 #include "yolo26_draw.h"
 #include "yolo26_cli.h"
+#include "yolo26_io.h"
 
 #include <opencv2/imgcodecs/imgcodecs.hpp>
 
@@ -20,6 +21,10 @@ static void print_usage(const char* prog)
                  "  --box <cxcywh|xyxy>       Box format for raw outputs\n"
                  "  --dedup                  Apply IoU de-dup after TopK\n"
                  "  --agnostic               Class-agnostic NMS\n"
+                 "  --rect                   Minimal padding (stride-32 shapes, dynamic-shape export)\n"
+                 "  --full-decode            Always decode the image at full resolution\n"
+                 "  --raw-bgr                Model exported with --fold-preprocess (raw BGR input)\n"
+                 "  --tile                   Tiled inference with overlapping input-sized tiles\n"
                  "  --gpu                    Enable Vulkan (if available)\n",
                  prog);
 }
@@ -40,31 +45,55 @@ int main(int argc, char** argv)
     if (argi < argc && !yolo26_cli::starts_with(argv[argi], "--"))
         output_path = argv[argi++];
 
-    cv::Mat bgr = cv::imread(image_path, cv::IMREAD_COLOR);
-    if (bgr.empty())
-    {
-        std::fprintf(stderr, "Failed to read image: %s\n", image_path.c_str());
-        return 1;
-    }
-
     Yolo26Config config;
+    bool full_decode = false;
     while (argi < argc)
     {
         const std::string arg = argv[argi++];
-        if (!yolo26_cli::parse_common_arg(arg,
-                                          argc,
-                                          argv,
-                                          argi,
-                                          config.conf_threshold,
-                                          config.iou_threshold,
-                                          config.max_det,
-                                          config.postprocess,
-                                          config.box_format,
-                                          config.topk_dedup,
-                                          config.agnostic_nms,
-                                          config.use_gpu))
+        if (arg == "--rect")
+        {
+            config.rect = true;
+        }
+        else if (arg == "--full-decode")
+        {
+            full_decode = true;
+        }
+        else if (arg == "--raw-bgr")
+        {
+            config.raw_bgr_input = true;
+        }
+        else if (arg == "--tile")
+        {
+            config.tiled = true;
+        }
+        else if (!yolo26_cli::parse_common_arg(arg,
+                                               argc,
+                                               argv,
+                                               argi,
+                                               config.conf_threshold,
+                                               config.iou_threshold,
+                                               config.max_det,
+                                               config.postprocess,
+                                               config.box_format,
+                                               config.topk_dedup,
+                                               config.agnostic_nms,
+                                               config.use_gpu))
             return (print_usage(argv[0]), 1);
     }
+    // Large JPEGs are decoded at 1/2..1/8 scale; results still come back in original coordinates.
+    int orig_w = 0;
+    int orig_h = 0;
+    cv::Mat bgr = full_decode ? cv::imread(image_path, cv::IMREAD_COLOR)
+                              : yolo26_imread(image_path, config.input_width, config.input_height, &orig_w, &orig_h);
+    if (bgr.empty())
+    {
+        std::fprintf(stderr, "Failed to read image: %s\n", image_path.c_str());
+        return 1;
+    }
+    Yolo26Image image = yolo26_image_from_mat(bgr);
+    image.orig_width = orig_w;
+    image.orig_height = orig_h;
+
     Yolo26 detector(config);
     if (!detector.load(param_path, bin_path))
     {
@@ -73,13 +102,27 @@ int main(int argc, char** argv)
     }
 
     std::vector<Yolo26Object> objects;
-    if (!detector.detect(bgr, objects))
+    if (!detector.detect(image, objects))
     {
         std::fprintf(stderr, "Detection failed\n");
         return 1;
     }
 
-    yolo26_draw_objects(bgr, objects);
+    // Draw on the decoded image, which is smaller than the original after a reduced decode.
+    std::vector<Yolo26Object> draw_objects = objects;
+    if (orig_w > 0 && orig_h > 0)
+    {
+        const float sx = bgr.cols / (float)orig_w;
+        const float sy = bgr.rows / (float)orig_h;
+        for (auto& obj : draw_objects)
+        {
+            obj.x1 *= sx;
+            obj.y1 *= sy;
+            obj.x2 *= sx;
+            obj.y2 *= sy;
+        }
+    }
+    yolo26_draw_objects(bgr, draw_objects);
 
     if (!cv::imwrite(output_path, bgr))
     {
@@ -0,0 +1,105 @@
+#include "yolo26_io.h"
+
+#include <opencv2/imgcodecs/imgcodecs.hpp>
+
+#include <algorithm>
+#include <cstdio>
+
+bool yolo26_read_jpeg_size(const std::string& path, int& width, int& height)
+{
+    std::FILE* fp = std::fopen(path.c_str(), "rb");
+    if (!fp)
+        return false;
+
+    bool ok = false;
+    if (std::fgetc(fp) == 0xFF && std::fgetc(fp) == 0xD8)
+    {
+        for (;;)
+        {
+            int c = std::fgetc(fp);
+            if (c != 0xFF)
+                break;
+            int marker = std::fgetc(fp);
+            while (marker == 0xFF)
+                marker = std::fgetc(fp);
+            if (marker == EOF || marker == 0xD9 || marker == 0xDA)
+                break;
+            // Standalone markers carry no length.
+            if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7))
+                continue;
+
+            const int hi = std::fgetc(fp);
+            const int lo = std::fgetc(fp);
+            if (hi == EOF || lo == EOF)
+                break;
+            const int length = (hi << 8) | lo;
+            if (length < 2)
+                break;
+
+            // SOF0..SOF15 except DHT (C4), JPG (C8) and DAC (CC).
+            if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+            {
+                unsigned char sof[5];
+                if (std::fread(sof, 1, 5, fp) != 5)
+                    break;
+                height = (sof[1] << 8) | sof[2];
+                width = (sof[3] << 8) | sof[4];
+                ok = width > 0 && height > 0;
+                break;
+            }
+
+            if (std::fseek(fp, length - 2, SEEK_CUR) != 0)
+                break;
+        }
+    }
+
+    std::fclose(fp);
+    return ok;
+}
+
+cv::Mat yolo26_imread(const std::string& path, int input_w, int input_h, int* orig_w, int* orig_h)
+{
+    int w = 0;
+    int h = 0;
+    int factor = 1;
+    if (input_w > 0 && input_h > 0 && yolo26_read_jpeg_size(path, w, h))
+    {
+        // Largest reduction that still leaves at least the letterboxed resolution to resample from.
+        const float r = std::min(input_w / (float)w, input_h / (float)h);
+        if (r * 8 <= 1.f)
+            factor = 8;
+        else if (r * 4 <= 1.f)
+            factor = 4;
+        else if (r * 2 <= 1.f)
+            factor = 2;
+    }
+
+    int flags = cv::IMREAD_COLOR;
+    if (factor == 8)
+        flags = cv::IMREAD_REDUCED_COLOR_8;
+    else if (factor == 4)
+        flags = cv::IMREAD_REDUCED_COLOR_4;
+    else if (factor == 2)
+        flags = cv::IMREAD_REDUCED_COLOR_2;
+
+    cv::Mat bgr = cv::imread(path, flags);
+    if (bgr.empty())
+        return bgr;
+
+    if (factor == 1)
+    {
+        w = bgr.cols;
+        h = bgr.rows;
+    }
+    else if ((bgr.cols > bgr.rows) != (w > h) && w != h)
+    {
+        // imread applied an EXIF rotation; the header size is pre-rotation.
+        std::swap(w, h);
+    }
+
+    if (orig_w)
+        *orig_w = w;
+    if (orig_h)
+        *orig_h = h;
+    return bgr;
+}
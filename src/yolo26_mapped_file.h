@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace yolo26 {
+
+// Read-only view of a whole file. On POSIX it is an mmap of the page cache: instances in one process
+// get the same mapping from open(), and other processes mapping the file (forked workers included)
+// share its physical pages. Elsewhere the file is read into memory once per process.
+class MappedFile {
+public:
+    // Shared per file identity (device, inode, size, mtime), so a file replaced on disk maps anew
+    // while users of the old one keep it. Null on failure.
+    static std::shared_ptr<const MappedFile> open(const std::string& path)
+    {
+        std::string key;
+        if (!identity(path, key))
+            return std::shared_ptr<const MappedFile>();
+
+        static std::mutex mutex;
+        static std::map<std::string, std::weak_ptr<const MappedFile>> files;
+        std::lock_guard<std::mutex> lock(mutex);
+
+        std::shared_ptr<const MappedFile> file = files[key].lock();
+        if (!file)
+        {
+            std::shared_ptr<MappedFile> mapped(new MappedFile);
+            if (!mapped->map(path))
+            {
+                files.erase(key);
+                return std::shared_ptr<const MappedFile>();
+            }
+            file = mapped;
+            files[key] = file;
+        }
+        return file;
+    }
+
+    ~MappedFile()
+    {
+#if !defined(_WIN32)
+        if (data_)
+            munmap(const_cast<unsigned char*>(data_), size_);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Page aligned on POSIX, which satisfies ncnn's 4-byte alignment for zero-copy weights.
+    const unsigned char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    MappedFile() = default;
+
+#if !defined(_WIN32)
+    static bool identity(const std::string& path, std::string& key)
+    {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0)
+            return false;
+        char buf[128];
+        std::snprintf(buf, sizeof(buf), "%llu:%llu:%lld:%lld",
+                      (unsigned long long)st.st_dev, (unsigned long long)st.st_ino,
+                      (long long)st.st_size, (long long)st.st_mtime);
+        key = buf;
+        return true;
+    }
+
+    bool map(const std::string& path)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+        bool ok = fstat(fd, &st) == 0 && st.st_size > 0;
+        if (ok)
+        {
+            void* p = mmap(0, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            ok = p != MAP_FAILED;
+            if (ok)
+            {
+                data_ = static_cast<const unsigned char*>(p);
+                size_ = (size_t)st.st_size;
+            }
+        }
+        ::close(fd);
+        return ok;
+    }
+#else
+    static bool identity(const std::string& path, std::string& key)
+    {
+        key = path;
+        return true;
+    }
+
+    bool map(const std::string& path)
+    {
+        std::FILE* fp = std::fopen(path.c_str(), "rb");
+        if (!fp)
+            return false;
+        unsigned char buf[1 << 16];
+        size_t n = 0;
+        while ((n = std::fread(buf, 1, sizeof(buf), fp)) > 0)
+            copy_.insert(copy_.end(), buf, buf + n);
+        std::fclose(fp);
+        data_ = copy_.empty() ? 0 : copy_.data();
+        size_ = copy_.size();
+        return data_ != 0;
+    }
+
+    std::vector<unsigned char> copy_;
+#endif
+
+    const unsigned char* data_ = 0;
+    size_t size_ = 0;
+};
+
+// Whole text file, e.g. a .param for Net::load_param_mem (std::string keeps it NUL-terminated).
+inline bool read_text_file(const std::string& path, std::string& text)
+{
+    std::FILE* fp = std::fopen(path.c_str(), "rb");
+    if (!fp)
+        return false;
+    text.clear();
+    char buf[1 << 16];
+    size_t n = 0;
+    while ((n = std::fread(buf, 1, sizeof(buf), fp)) > 0)
+        text.append(buf, n);
+    const bool ok = !std::ferror(fp);
+    std::fclose(fp);
+    return ok;
+}
+
+}  // namespace yolo26
@@ -55,94 +55,9 @@ inline void crop_mask_inplace(float* mask, int h, int w, const BoxXYXY& box)
     }
 }
 
-inline bool process_mask(const ncnn::Mat& protos,
-                         const ncnn::Mat& masks_in,
-                         const std::vector<BoxXYXY>& bboxes_xyxy,
-                         int shape_h,
-                         int shape_w,
-                         bool upsample,
-                         std::vector<cv::Mat>& out_masks)
+// Part of an in_h x in_w letterboxed plane that holds the target_h x target_w image.
+inline bool letterbox_content(int in_h, int in_w, int target_h, int target_w, bool padding, cv::Rect& content)
 {
-    out_masks.clear();
-    if (protos.dims != 3 || masks_in.dims != 2 || shape_h <= 0 || shape_w <= 0)
-        return false;
-
-    const int c = protos.c;
-    const int mh = protos.h;
-    const int mw = protos.w;
-    const int n = masks_in.h;
-    if (c <= 0 || mh <= 0 || mw <= 0 || n <= 0)
-        return false;
-    if (masks_in.w != c)
-        return false;
-    if ((int)bboxes_xyxy.size() != n)
-        return false;
-
-    cv::Mat coeffs(n, c, CV_32FC1);
-    for (int i = 0; i < n; i++)
-    {
-        const float* src = masks_in.row(i);
-        float* dst = coeffs.ptr<float>(i);
-        std::copy(src, src + c, dst);
-    }
-
-    cv::Mat protos_flat(c, mw * mh, CV_32FC1, (void*)protos.data);
-    cv::Mat mask_logits;
-    cv::gemm(coeffs, protos_flat, 1.0, cv::Mat(), 0.0, mask_logits);  // (n, mw*mh)
-
-    const float width_ratio = mw / (float)shape_w;
-    const float height_ratio = mh / (float)shape_h;
-
-    out_masks.reserve(n);
-    for (int i = 0; i < n; i++)
-    {
-        cv::Mat m = mask_logits.row(i).reshape(1, mh);  // (mh, mw) logits
-        BoxXYXY box = bboxes_xyxy[i];
-        box.x1 *= width_ratio;
-        box.x2 *= width_ratio;
-        box.y1 *= height_ratio;
-        box.y2 *= height_ratio;
-
-        crop_mask_inplace((float*)m.data, mh, mw, box);
-
-        cv::Mat mask_src = m;
-        if (upsample && (mh != shape_h || mw != shape_w))
-        {
-            cv::Mat up(shape_h, shape_w, CV_32FC1);
-            resize_bilinear_align_false((const float*)mask_src.data, mh, mw, (float*)up.data, shape_h, shape_w);
-            mask_src = up;
-        }
-
-        cv::Mat bin(mask_src.rows, mask_src.cols, CV_8UC1);
-        const float* mp = (const float*)mask_src.data;
-        unsigned char* bp = bin.data;
-        const int total = mask_src.rows * mask_src.cols;
-        for (int j = 0; j < total; j++)
-            bp[j] = (mp[j] > 0.f) ? 1 : 0;
-        out_masks.push_back(std::move(bin));
-    }
-
-    return true;
-}
-
-inline bool scale_mask(const cv::Mat& in,
-                       int target_h,
-                       int target_w,
-                       cv::Mat& out,
-                       bool padding = true)
-{
-    out.release();
-    if (in.empty() || in.type() != CV_32FC1 || target_h <= 0 || target_w <= 0)
-        return false;
-
-    const int in_h = in.rows;
-    const int in_w = in.cols;
-    if (in_h == target_h && in_w == target_w)
-    {
-        out = in.clone();
-        return true;
-    }
-
     const float gain = std::min(in_h / (float)target_h, in_w / (float)target_w);
     float pad_w = in_w - target_w * gain;
     float pad_h = in_h - target_h * gain;
@@ -157,118 +72,162 @@ inline bool scale_mask(const cv::Mat& in,
     const int bottom = in_h - (int)std::round(pad_h + 0.1f);
     const int right = in_w - (int)std::round(pad_w + 0.1f);
 
-    const int crop_x = std::max(0, std::min(left, in_w));
-    const int crop_y = std::max(0, std::min(top, in_h));
-    const int crop_w = std::max(0, std::min(right, in_w) - crop_x);
-    const int crop_h = std::max(0, std::min(bottom, in_h) - crop_y);
-    if (crop_w <= 0 || crop_h <= 0)
-        return false;
+    content.x = std::max(0, std::min(left, in_w));
+    content.y = std::max(0, std::min(top, in_h));
+    content.width = std::max(0, std::min(right, in_w) - content.x);
+    content.height = std::max(0, std::min(bottom, in_h) - content.y);
+    return content.width > 0 && content.height > 0;
+}
+
+// Buffers of the single-instance functions below; reused across calls they stop allocating.
+struct MaskScratch {
+    std::vector<float> logits;  // mh x mw
+    std::vector<float> plane;   // logits upsampled to the network input
+    std::vector<float> roi;     // image part of a letterboxed plane
+    std::vector<float> scaled;  // plane scaled to the image
+};
 
-    cv::Mat roi = in(cv::Rect(crop_x, crop_y, crop_w, crop_h));
-    std::vector<float> roi_buf((size_t)crop_h * (size_t)crop_w);
-    for (int y = 0; y < crop_h; y++)
+// Logits of one instance: coeffs (c) times protos (c, mh, mw), accumulated channel by channel.
+inline void mask_logits(const ncnn::Mat& protos, const float* coeffs, float* out)
+{
+    const int size = protos.w * protos.h;
+    std::fill(out, out + size, 0.f);
+    for (int q = 0; q < protos.c; q++)
     {
-        const float* src = roi.ptr<float>(y);
-        float* dst = roi_buf.data() + (size_t)y * (size_t)crop_w;
-        std::copy(src, src + crop_w, dst);
+        const float k = coeffs[q];
+        const float* p = protos.channel(q);
+        for (int i = 0; i < size; i++)
+            out[i] += k * p[i];
     }
-
-    out = cv::Mat(target_h, target_w, CV_32FC1);
-    resize_bilinear_align_false(roi_buf.data(), crop_h, crop_w, out.ptr<float>(), target_h, target_w);
-    return true;
 }
 
-inline bool scale_masks(const std::vector<cv::Mat>& in_masks,
+// Ultralytics ops.scale_masks() on one contiguous plane: the letterboxed content is cut out and
+// resized (bilinear, align_corners=False) into `out` (target_h x target_w floats).
+inline bool scale_plane(const float* in,
+                        int in_h,
+                        int in_w,
                         int target_h,
                         int target_w,
-                        std::vector<cv::Mat>& out_masks,
-                        bool padding = true)
+                        bool padding,
+                        std::vector<float>& roi,
+                        float* out)
 {
-    out_masks.clear();
-    out_masks.reserve(in_masks.size());
-    for (const auto& mask : in_masks)
+    if (in_h == target_h && in_w == target_w)
     {
-        if (mask.empty() || mask.type() != CV_8UC1)
-            return false;
-
-        cv::Mat mask_f(mask.rows, mask.cols, CV_32FC1);
-        const unsigned char* src = mask.data;
-        float* dst = (float*)mask_f.data;
-        const int total = mask.rows * mask.cols;
-        for (int i = 0; i < total; i++)
-            dst[i] = (float)src[i];
-
-        cv::Mat scaled;
-        if (!scale_mask(mask_f, target_h, target_w, scaled, padding))
-            return false;
-
-        cv::Mat bin(target_h, target_w, CV_8UC1);
-        const float* sp = (const float*)scaled.data;
-        unsigned char* bp = bin.data;
-        const int out_total = target_h * target_w;
-        for (int i = 0; i < out_total; i++)
-            bp[i] = (sp[i] > 0.5f) ? 1 : 0;
-
-        out_masks.push_back(std::move(bin));
+        std::copy(in, in + (size_t)in_h * (size_t)in_w, out);
+        return true;
     }
 
+    cv::Rect content;
+    if (!letterbox_content(in_h, in_w, target_h, target_w, padding, content))
+        return false;
+    roi.resize((size_t)content.height * (size_t)content.width);
+    for (int y = 0; y < content.height; y++)
+    {
+        const float* src = in + (size_t)(content.y + y) * (size_t)in_w + content.x;
+        std::copy(src, src + content.width, roi.data() + (size_t)y * (size_t)content.width);
+    }
+    resize_bilinear_align_false(roi.data(), content.height, content.width, out, target_h, target_w);
     return true;
 }
 
-inline bool process_mask_native(const ncnn::Mat& protos,
-                                const ncnn::Mat& masks_in,
-                                const std::vector<BoxXYXY>& bboxes_xyxy,
-                                int shape_h,
-                                int shape_w,
-                                std::vector<cv::Mat>& out_masks)
+// `mask` as a contiguous h x w CV_8UC1 buffer, keeping its storage when nothing else references it.
+inline void reuse_mask(cv::Mat& mask, int h, int w)
 {
-    out_masks.clear();
-    if (protos.dims != 3 || masks_in.dims != 2 || shape_h <= 0 || shape_w <= 0)
-        return false;
+    if (!mask.u || mask.u->refcount != 1 || !mask.isContinuous())
+        mask.release();
+    mask.create(h, w, CV_8UC1);
+}
+
+// v > threshold ? 1 : 0 into dst; returns the number of ones.
+inline int binarize(const float* src, int total, float threshold, unsigned char* dst)
+{
+    int ones = 0;
+    for (int i = 0; i < total; i++)
+    {
+        dst[i] = (src[i] > threshold) ? 1 : 0;
+        ones += dst[i];
+    }
+    return ones;
+}
 
-    const int c = protos.c;
+// Ultralytics ops.process_mask(upsample=True) followed by ops.scale_masks() for one instance:
+// `box` is in input_h x input_w network coordinates and `out` receives the target_h x target_w mask.
+// `empty` is set when the mask has no pixel at the network input, like the masks Yolo26Seg drops.
+inline bool instance_mask(const ncnn::Mat& protos,
+                          const float* coeffs,
+                          const BoxXYXY& box,
+                          int input_h,
+                          int input_w,
+                          int target_h,
+                          int target_w,
+                          MaskScratch& scratch,
+                          cv::Mat& out,
+                          bool& empty)
+{
     const int mh = protos.h;
     const int mw = protos.w;
-    const int n = masks_in.h;
-    if (c <= 0 || mh <= 0 || mw <= 0 || n <= 0)
-        return false;
-    if (masks_in.w != c)
-        return false;
-    if ((int)bboxes_xyxy.size() != n)
-        return false;
-
-    cv::Mat coeffs(n, c, CV_32FC1);
-    for (int i = 0; i < n; i++)
+    scratch.logits.resize((size_t)mh * (size_t)mw);
+    mask_logits(protos, coeffs, scratch.logits.data());
+
+    BoxXYXY b = box;
+    b.x1 *= mw / (float)input_w;
+    b.x2 *= mw / (float)input_w;
+    b.y1 *= mh / (float)input_h;
+    b.y2 *= mh / (float)input_h;
+    crop_mask_inplace(scratch.logits.data(), mh, mw, b);
+
+    float* plane = scratch.logits.data();
+    if (mh != input_h || mw != input_w)
     {
-        const float* src = masks_in.row(i);
-        float* dst = coeffs.ptr<float>(i);
-        std::copy(src, src + c, dst);
+        scratch.plane.resize((size_t)input_h * (size_t)input_w);
+        resize_bilinear_align_false(scratch.logits.data(), mh, mw, scratch.plane.data(), input_h, input_w);
+        plane = scratch.plane.data();
     }
 
-    cv::Mat protos_flat(c, mw * mh, CV_32FC1, (void*)protos.data);
-    cv::Mat mask_logits;
-    cv::gemm(coeffs, protos_flat, 1.0, cv::Mat(), 0.0, mask_logits);  // (n, mw*mh)
-
-    out_masks.reserve(n);
-    for (int i = 0; i < n; i++)
+    // The binary input-size mask, kept as 0 / 1 floats for the scaling below.
+    const int total = input_h * input_w;
+    int ones = 0;
+    for (int i = 0; i < total; i++)
     {
-        cv::Mat m = mask_logits.row(i).reshape(1, mh);  // (mh, mw) logits
+        plane[i] = (plane[i] > 0.f) ? 1.f : 0.f;
+        ones += plane[i] > 0.f ? 1 : 0;
+    }
+    empty = ones == 0;
+    if (empty)
+        return true;
 
-        cv::Mat scaled;
-        if (!scale_mask(m, shape_h, shape_w, scaled, true))
-            return false;
+    scratch.scaled.resize((size_t)target_h * (size_t)target_w);
+    if (!scale_plane(plane, input_h, input_w, target_h, target_w, true, scratch.roi, scratch.scaled.data()))
+        return false;
+    reuse_mask(out, target_h, target_w);
+    binarize(scratch.scaled.data(), target_h * target_w, 0.5f, out.data);
+    return true;
+}
 
-        crop_mask_inplace((float*)scaled.data, shape_h, shape_w, bboxes_xyxy[i]);
+// Ultralytics ops.process_mask_native() for one instance: `box` is in target_h x target_w image
+// coordinates.
+inline bool instance_mask_native(const ncnn::Mat& protos,
+                                 const float* coeffs,
+                                 const BoxXYXY& box,
+                                 int target_h,
+                                 int target_w,
+                                 MaskScratch& scratch,
+                                 cv::Mat& out,
+                                 bool& empty)
+{
+    const int mh = protos.h;
+    const int mw = protos.w;
+    scratch.logits.resize((size_t)mh * (size_t)mw);
+    mask_logits(protos, coeffs, scratch.logits.data());
 
-        cv::Mat bin(shape_h, shape_w, CV_8UC1);
-        const float* mp = (const float*)scaled.data;
-        unsigned char* bp = bin.data;
-        const int total = shape_h * shape_w;
-        for (int j = 0; j < total; j++)
-            bp[j] = (mp[j] > 0.f) ? 1 : 0;
-        out_masks.push_back(std::move(bin));
-    }
+    scratch.scaled.resize((size_t)target_h * (size_t)target_w);
+    if (!scale_plane(scratch.logits.data(), mh, mw, target_h, target_w, true, scratch.roi, scratch.scaled.data()))
+        return false;
+    crop_mask_inplace(scratch.scaled.data(), target_h, target_w, box);
 
+    reuse_mask(out, target_h, target_w);
+    empty = binarize(scratch.scaled.data(), target_h * target_w, 0.f, out.data) == 0;
     return true;
 }
 
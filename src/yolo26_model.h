@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+#include "net.h"
+
+#include "yolo26_budget.h"
+#include "yolo26_mapped_file.h"
+#include "yolo26_ncnn_io.h"
+#include "yolo26_types.h"
+
+namespace yolo26 {
+
+// One loaded network with everything resolved against it. Immutable once published, and replaced as
+// a whole so a call never pairs one model's net with another model's blob indices or layout.
+struct LoadedModel {
+    // mmap_model / bundles: the mapping the weights point into; declared first so it outlives net.
+    std::shared_ptr<const MappedFile> data;
+    ncnn::Net net;
+    IoPlan io;
+    // Memory-budget mode: extraction peaks of the shapes this net was dry-run at. Grows as shapes
+    // are warmed, hence mutable on a published model.
+    mutable ShapePeaks peaks;
+};
+
+// The model a detector currently serves. Calls take a snapshot with get() and run on it to the end;
+// publish() swaps in a fully loaded and warmed model without waiting for them, and the model it
+// replaces is freed by whichever call drops the last reference to it.
+class ModelSlot {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    std::shared_ptr<const LoadedModel> get() const { return std::atomic_load(&model_); }
+
+    // Makes `model` current. With `reload` set, the swap is recorded in stats() along with the
+    // phases measured by the caller (started = when the reload was requested).
+    void publish(std::unique_ptr<LoadedModel> model, bool reload, Clock::time_point started, double load_ms, double warmup_ms)
+    {
+        std::shared_ptr<Clock::time_point> retired_at = std::make_shared<Clock::time_point>();
+        const std::shared_ptr<State> state = state_;
+        std::shared_ptr<const LoadedModel> next(model.release(), [state, retired_at](const LoadedModel* m) {
+            delete m;
+            if (*retired_at == Clock::time_point())
+                return;  // still current when its detector went away
+            const double drain_ms = std::chrono::duration<double, std::milli>(Clock::now() - *retired_at).count();
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->stats.drain_ms = drain_ms;
+            state->stats.max_drain_ms = std::max(state->stats.max_drain_ms, drain_ms);
+            state->stats.retired_alive--;
+        });
+
+        const Clock::time_point begin = Clock::now();
+        // Written before the exchange; the deleter reads it after the last reference is dropped,
+        // which orders it after the release of `previous` below. A model replaced by load() keeps
+        // the zero time point and stays out of the stats.
+        if (reload && current_retired_at_)
+            *current_retired_at_ = begin;
+        std::shared_ptr<const LoadedModel> previous = std::atomic_exchange(&model_, next);
+        const Clock::time_point end = Clock::now();
+        current_retired_at_ = retired_at;
+
+        if (reload)
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            Yolo26ReloadStats& s = state_->stats;
+            s.reloads++;
+            s.load_ms = load_ms;
+            s.warmup_ms = warmup_ms;
+            s.swap_us = std::chrono::duration<double, std::micro>(end - begin).count();
+            s.total_ms = std::chrono::duration<double, std::milli>(end - started).count();
+            s.max_total_ms = std::max(s.max_total_ms, s.total_ms);
+            if (previous)
+            {
+                s.drain_ms = -1.0;
+                s.retired_alive++;
+            }
+        }
+        // `previous` goes here unless a call still runs on it.
+    }
+
+    void failed()
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->stats.failures++;
+    }
+
+    Yolo26ReloadStats stats() const
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->stats;
+    }
+
+    // Held by load() (from planning to publishing, in finish_load()) and by reload(); detection never
+    // takes it.
+    std::mutex& load_mutex() { return load_mutex_; }
+
+private:
+    struct State {
+        std::mutex mutex;
+        Yolo26ReloadStats stats;
+    };
+
+    std::shared_ptr<const LoadedModel> model_;
+    std::shared_ptr<Clock::time_point> current_retired_at_;  // the current model's, under load_mutex_
+    std::shared_ptr<State> state_ = std::make_shared<State>();
+    std::mutex load_mutex_;
+};
+
+}  // namespace yolo26
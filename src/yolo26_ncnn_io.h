@@ -1,11 +1,15 @@
 #pragma once
 
+#include <cstring>
 #include <initializer_list>
 #include <string>
+#include <vector>
 
 #include "mat.h"
 #include "net.h"
 
+#include "yolo26_types.h"
+
 namespace yolo26 {
 
 inline bool ncnn_input_with_fallback(ncnn::Extractor& ex,
@@ -61,4 +65,75 @@ inline bool ncnn_extract_out1(ncnn::Extractor& ex, const std::string& preferred,
     return ncnn_extract_with_fallback(ex, preferred, out, {"out1", "seg", "output1"});
 }
 
+// Index of the first of `preferred`, `fallbacks` found among the graph blobs `names` / `indexes`
+// (Net::input_names / input_indexes or the output pair); -1 when none is there.
+inline int find_blob_index(const std::vector<const char*>& names,
+                           const std::vector<int>& indexes,
+                           const std::string& preferred,
+                           std::initializer_list<const char*> fallbacks)
+{
+    auto find = [&](const char* name) {
+        for (size_t i = 0; i < names.size() && i < indexes.size(); i++)
+        {
+            if (names[i] && std::strcmp(names[i], name) == 0)
+                return indexes[i];
+        }
+        return -1;
+    };
+
+    int index = find(preferred.c_str());
+    for (const char* name : fallbacks)
+    {
+        if (index < 0 && name)
+            index = find(name);
+    }
+    return index;
+}
+
+// What load() resolves once so the per-frame path neither retries blob names nor re-derives the
+// output layout. An index of -1 (e.g. a name that is not a graph input / output) keeps the by-name
+// lookup with fallbacks for that blob.
+struct IoPlan {
+    int input_index = -1;
+    int output_index = -1;
+    int proto_index = -1;
+    Yolo26OutputLayout layout = Yolo26OutputLayout::Auto;
+
+    void resolve(const ncnn::Net& net, const std::string& input_name, const std::string& output_name)
+    {
+        const std::vector<int>& inputs = net.input_indexes();
+        const std::vector<int>& outputs = net.output_indexes();
+        input_index = find_blob_index(net.input_names(), inputs, input_name, {"in0", "images", "data"});
+        if (input_index < 0 && inputs.size() == 1)
+            input_index = inputs[0];
+        output_index = find_blob_index(net.output_names(), outputs, output_name, {"out0", "output0", "output"});
+        if (output_index < 0 && outputs.size() == 1)
+            output_index = outputs[0];
+    }
+
+    void resolve_proto(const ncnn::Net& net, const std::string& proto_name)
+    {
+        const std::vector<int>& outputs = net.output_indexes();
+        proto_index = find_blob_index(net.output_names(), outputs, proto_name, {"out1", "seg", "output1"});
+        // Two graph outputs and the other one is known: the proto is the remaining one.
+        if (proto_index < 0 && outputs.size() == 2 && output_index >= 0)
+            proto_index = outputs[0] == output_index ? outputs[1] : outputs[0];
+    }
+
+    bool input(ncnn::Extractor& ex, const std::string& name, const ncnn::Mat& in) const
+    {
+        return input_index >= 0 ? ex.input(input_index, in) == 0 : ncnn_input_image(ex, name, in);
+    }
+
+    bool output(ncnn::Extractor& ex, const std::string& name, ncnn::Mat& out) const
+    {
+        return output_index >= 0 ? ex.extract(output_index, out) == 0 : ncnn_extract_out0(ex, name, out);
+    }
+
+    bool proto(ncnn::Extractor& ex, const std::string& name, ncnn::Mat& out) const
+    {
+        return proto_index >= 0 ? ex.extract(proto_index, out) == 0 : ncnn_extract_out1(ex, name, out);
+    }
+};
+
 }  // namespace yolo26
@@ -2,6 +2,8 @@
 
 #include "mat.h"
 
+#include "yolo26_types.h"
+
 namespace yolo26 {
 
 inline bool to_mat2d(const ncnn::Mat& in, ncnn::Mat& out)
@@ -36,5 +38,43 @@ inline bool to_mat2d(const ncnn::Mat& in, ncnn::Mat& out)
     return false;
 }
 
+// Layout of a w x h output from to_mat2d. pred_dim = 4+nc(+nm) for raw predictions, end2end_dim =
+// 6(+nm) for exports that already picked their detections. A `hint` (config / bundle metadata) is
+// returned when the shape agrees with it and Auto when it does not, so load() fails on a hint that
+// contradicts the model rather than guessing past it. Without a hint the shape decides; Auto when
+// nothing fits.
+inline Yolo26OutputLayout resolve_output_layout(int w, int h, int pred_dim, int end2end_dim, Yolo26OutputLayout hint)
+{
+    auto fits = [&](Yolo26OutputLayout layout) {
+        switch (layout)
+        {
+        case Yolo26OutputLayout::ChannelMajor:
+            return h == pred_dim && w > 0;
+        case Yolo26OutputLayout::AnchorMajor:
+            return w == pred_dim && h > 0;
+        case Yolo26OutputLayout::End2EndRows:
+            return w == end2end_dim && h > 0;
+        case Yolo26OutputLayout::End2EndCols:
+            return h == end2end_dim && w > 0;
+        default:
+            return false;
+        }
+    };
+
+    if (hint != Yolo26OutputLayout::Auto)
+        return fits(hint) ? hint : Yolo26OutputLayout::Auto;
+
+    const Yolo26OutputLayout order[] = {Yolo26OutputLayout::ChannelMajor,
+                                        Yolo26OutputLayout::AnchorMajor,
+                                        Yolo26OutputLayout::End2EndRows,
+                                        Yolo26OutputLayout::End2EndCols};
+    for (Yolo26OutputLayout layout : order)
+    {
+        if (fits(layout))
+            return layout;
+    }
+    return Yolo26OutputLayout::Auto;
+}
+
 }  // namespace yolo26
 
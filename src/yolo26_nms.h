@@ -26,26 +26,47 @@ inline float compute_iou(float x1a, float y1a, float x2a, float y2a,
     return inter_area / union_area;
 }
 
+// Buffers of nms_inplace(); reused across calls they stop allocating once grown.
 template <typename Object>
-inline std::vector<Object> nms(const std::vector<Object>& objects, float iou_threshold, bool agnostic = false)
+struct NmsScratch {
+    std::vector<int> order;
+    std::vector<Object> sorted;
+    std::vector<char> suppressed;
+};
+
+// nms() without the copies: `objects` is replaced by the kept ones, highest prob first.
+template <typename Object>
+inline void nms_inplace(std::vector<Object>& objects, float iou_threshold, bool agnostic, NmsScratch<Object>& scratch)
 {
     if (objects.empty())
-        return objects;
-
-    std::vector<Object> sorted_objs = objects;
-    std::stable_sort(sorted_objs.begin(), sorted_objs.end(),
-                     [](const Object& a, const Object& b) { return a.prob > b.prob; });
-
-    std::vector<bool> suppressed(sorted_objs.size(), false);
-    std::vector<Object> result;
-    result.reserve(sorted_objs.size());
+        return;
+
+    // Index tie-break = the stable order of nms(), without stable_sort's temporary buffer.
+    std::vector<int>& order = scratch.order;
+    order.resize(objects.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = (int)i;
+    std::sort(order.begin(), order.end(), [&objects](int a, int b) {
+        if (objects[a].prob != objects[b].prob)
+            return objects[a].prob > objects[b].prob;
+        return a < b;
+    });
+
+    std::vector<Object>& sorted_objs = scratch.sorted;
+    sorted_objs.clear();
+    for (int i : order)
+        sorted_objs.push_back(objects[i]);
+
+    std::vector<char>& suppressed = scratch.suppressed;
+    suppressed.assign(sorted_objs.size(), 0);
+    objects.clear();
 
     for (size_t i = 0; i < sorted_objs.size(); i++)
     {
         if (suppressed[i])
             continue;
 
-        result.push_back(sorted_objs[i]);
+        objects.push_back(sorted_objs[i]);
         const Object& obj_i = sorted_objs[i];
 
         for (size_t j = i + 1; j < sorted_objs.size(); j++)
@@ -61,10 +82,17 @@ inline std::vector<Object> nms(const std::vector<Object>& objects, float iou_thr
             float iou = compute_iou(obj_i.x1, obj_i.y1, obj_i.x2, obj_i.y2,
                                     obj_j.x1, obj_j.y1, obj_j.x2, obj_j.y2);
             if (iou > iou_threshold)
-                suppressed[j] = true;
+                suppressed[j] = 1;
         }
     }
+}
 
+template <typename Object>
+inline std::vector<Object> nms(const std::vector<Object>& objects, float iou_threshold, bool agnostic = false)
+{
+    std::vector<Object> result = objects;
+    NmsScratch<Object> scratch;
+    nms_inplace(result, iou_threshold, agnostic, scratch);
     return result;
 }
 
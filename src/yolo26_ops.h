@@ -2,6 +2,12 @@
 
 #include <algorithm>
 
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "yolo26_preprocess.h"
 
 namespace yolo26 {
@@ -35,11 +41,74 @@ inline void scale_xyxy_inplace(float& x1,
     y1 /= lb.gain;
     y2 /= lb.gain;
 
+    if (lb.src_scale_x != 1.f || lb.src_scale_y != 1.f)
+    {
+        x1 *= lb.src_scale_x;
+        x2 *= lb.src_scale_x;
+        y1 *= lb.src_scale_y;
+        y2 *= lb.src_scale_y;
+    }
+
     x1 = clampf(x1, 0.f, (float)img0_w);
     y1 = clampf(y1, 0.f, (float)img0_h);
     x2 = clampf(x2, 0.f, (float)img0_w);
     y2 = clampf(y2, 0.f, (float)img0_h);
 }
 
+// One axis of scale_xyxy_inplace over a column of n coordinates: v = clamp((v - pad) / gain * scale,
+// 0, hi), with the same operations in the same order, so results match the per-box version exactly.
+inline void scale_coords_inplace(float* v, int n, float pad, float gain, float scale, float hi)
+{
+    int i = 0;
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    const float32x4_t _pad = vdupq_n_f32(pad);
+    const float32x4_t _gain = vdupq_n_f32(gain);
+    const float32x4_t _scale = vdupq_n_f32(scale);
+    const float32x4_t _lo = vdupq_n_f32(0.f);
+    const float32x4_t _hi = vdupq_n_f32(hi);
+    for (; i + 3 < n; i += 4)
+    {
+        float32x4_t _p = vdivq_f32(vsubq_f32(vld1q_f32(v + i), _pad), _gain);
+        _p = vmulq_f32(_p, _scale);
+        vst1q_f32(v + i, vmaxq_f32(_lo, vminq_f32(_p, _hi)));
+    }
+#elif defined(__SSE2__)
+    const __m128 _pad = _mm_set1_ps(pad);
+    const __m128 _gain = _mm_set1_ps(gain);
+    const __m128 _scale = _mm_set1_ps(scale);
+    const __m128 _lo = _mm_setzero_ps();
+    const __m128 _hi = _mm_set1_ps(hi);
+    for (; i + 3 < n; i += 4)
+    {
+        __m128 _p = _mm_div_ps(_mm_sub_ps(_mm_loadu_ps(v + i), _pad), _gain);
+        _p = _mm_mul_ps(_p, _scale);
+        _mm_storeu_ps(v + i, _mm_max_ps(_mm_min_ps(_hi, _p), _lo));
+    }
+#endif
+    for (; i < n; i++)
+        v[i] = clampf((v[i] - pad) / gain * scale, 0.f, hi);
+}
+
+// scale_xyxy_inplace for n boxes held as separate x1 / y1 / x2 / y2 arrays.
+inline void scale_xyxy_soa_inplace(float* x1,
+                                   float* y1,
+                                   float* x2,
+                                   float* y2,
+                                   int n,
+                                   int img0_w,
+                                   int img0_h,
+                                   const LetterBoxInfo& lb,
+                                   bool padding = true)
+{
+    if (lb.gain <= 0.f)
+        return;
+    const float pad_x = padding ? (float)lb.pad_x : 0.f;
+    const float pad_y = padding ? (float)lb.pad_y : 0.f;
+    scale_coords_inplace(x1, n, pad_x, lb.gain, lb.src_scale_x, (float)img0_w);
+    scale_coords_inplace(x2, n, pad_x, lb.gain, lb.src_scale_x, (float)img0_w);
+    scale_coords_inplace(y1, n, pad_y, lb.gain, lb.src_scale_y, (float)img0_h);
+    scale_coords_inplace(y2, n, pad_y, lb.gain, lb.src_scale_y, (float)img0_h);
+}
+
 }  // namespace yolo26
 
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include "cpu.h"
+#include "option.h"
+
+namespace yolo26 {
+
+// ncnn::Option switches measured fastest for one model on one machine (tools/autotune_options.cpp),
+// stored as key=value lines so later load() calls apply them without tuning again.
+struct OptionProfile {
+    int num_threads = 0;
+    bool use_packing_layout = true;
+    bool use_fp16_packed = true;
+    bool use_fp16_storage = true;
+    bool use_fp16_arithmetic = true;
+    bool use_winograd_convolution = true;
+    bool use_sgemm_convolution = true;
+    bool lightmode = true;
+    int cpu_count = 0;    // ncnn::get_cpu_count() of the machine it was measured on
+    double ms = 0.0;      // mean extraction time
+    double drift = 0.0;   // max |out - fp32 out| / max |fp32 out|
+};
+
+inline OptionProfile option_profile_from(const ncnn::Option& opt)
+{
+    OptionProfile p;
+    p.num_threads = opt.num_threads;
+    p.use_packing_layout = opt.use_packing_layout;
+    p.use_fp16_packed = opt.use_fp16_packed;
+    p.use_fp16_storage = opt.use_fp16_storage;
+    p.use_fp16_arithmetic = opt.use_fp16_arithmetic;
+    p.use_winograd_convolution = opt.use_winograd_convolution;
+    p.use_sgemm_convolution = opt.use_sgemm_convolution;
+    p.lightmode = opt.lightmode;
+    return p;
+}
+
+// Everything but num_threads, which the caller decides on.
+inline void apply_option_profile(const OptionProfile& p, ncnn::Option& opt)
+{
+    opt.use_packing_layout = p.use_packing_layout;
+    opt.use_fp16_packed = p.use_fp16_packed;
+    opt.use_fp16_storage = p.use_fp16_storage;
+    opt.use_fp16_arithmetic = p.use_fp16_arithmetic;
+    opt.use_winograd_convolution = p.use_winograd_convolution;
+    opt.use_sgemm_convolution = p.use_sgemm_convolution;
+    opt.lightmode = p.lightmode;
+}
+
+inline bool write_option_profile(const std::string& path, const OptionProfile& p)
+{
+    std::FILE* fp = std::fopen(path.c_str(), "wb");
+    if (!fp)
+        return false;
+    std::fprintf(fp, "# yolo26 ncnn option profile\n");
+    std::fprintf(fp, "cpu_count=%d\n", p.cpu_count);
+    std::fprintf(fp, "num_threads=%d\n", p.num_threads);
+    std::fprintf(fp, "use_packing_layout=%d\n", p.use_packing_layout ? 1 : 0);
+    std::fprintf(fp, "use_fp16_packed=%d\n", p.use_fp16_packed ? 1 : 0);
+    std::fprintf(fp, "use_fp16_storage=%d\n", p.use_fp16_storage ? 1 : 0);
+    std::fprintf(fp, "use_fp16_arithmetic=%d\n", p.use_fp16_arithmetic ? 1 : 0);
+    std::fprintf(fp, "use_winograd_convolution=%d\n", p.use_winograd_convolution ? 1 : 0);
+    std::fprintf(fp, "use_sgemm_convolution=%d\n", p.use_sgemm_convolution ? 1 : 0);
+    std::fprintf(fp, "lightmode=%d\n", p.lightmode ? 1 : 0);
+    std::fprintf(fp, "ms=%.3f\n", p.ms);
+    std::fprintf(fp, "drift=%.6g\n", p.drift);
+    return std::fclose(fp) == 0;
+}
+
+// Unknown keys are skipped, missing ones keep their defaults.
+inline bool read_option_profile(const std::string& path, OptionProfile& p)
+{
+    std::ifstream in(path.c_str());
+    if (!in)
+        return false;
+
+    p = OptionProfile();
+    std::string line;
+    while (std::getline(in, line))
+    {
+        const size_t eq = line.find('=');
+        if (line.empty() || line[0] == '#' || eq == std::string::npos)
+            continue;
+        const std::string key = line.substr(0, eq);
+        const char* value = line.c_str() + eq + 1;
+        const bool flag = std::atoi(value) != 0;
+
+        if (key == "cpu_count")
+            p.cpu_count = std::atoi(value);
+        else if (key == "num_threads")
+            p.num_threads = std::atoi(value);
+        else if (key == "use_packing_layout")
+            p.use_packing_layout = flag;
+        else if (key == "use_fp16_packed")
+            p.use_fp16_packed = flag;
+        else if (key == "use_fp16_storage")
+            p.use_fp16_storage = flag;
+        else if (key == "use_fp16_arithmetic")
+            p.use_fp16_arithmetic = flag;
+        else if (key == "use_winograd_convolution")
+            p.use_winograd_convolution = flag;
+        else if (key == "use_sgemm_convolution")
+            p.use_sgemm_convolution = flag;
+        else if (key == "lightmode")
+            p.lightmode = flag;
+        else if (key == "ms")
+            p.ms = std::atof(value);
+        else if (key == "drift")
+            p.drift = std::atof(value);
+    }
+    return true;
+}
+
+// load() side: applies the profile at `path` to `opt`. The tuned thread count is used only when the
+// caller left num_threads at 0 and the profile was measured on a machine with the same CPU count.
+inline bool load_option_profile(const std::string& path, int config_num_threads, ncnn::Option& opt)
+{
+    OptionProfile p;
+    if (!read_option_profile(path, p))
+        return false;
+
+    apply_option_profile(p, opt);
+    if (config_num_threads <= 0 && p.num_threads > 0 && p.cpu_count == ncnn::get_cpu_count())
+        opt.num_threads = p.num_threads;
+    return true;
+}
+
+}  // namespace yolo26
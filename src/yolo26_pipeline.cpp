@@ -0,0 +1,136 @@
+#include "yolo26_pipeline.h"
+
+#include <algorithm>
+
+#include "yolo26_scratch.h"
+#include "yolo26_spsc_queue.h"
+
+struct Yolo26Pipeline::Frame {
+    Yolo26Image image;
+    cv::Mat hold;
+    // Reused from frame to frame: letterbox tensor, raw output and result storage.
+    Yolo26PreparedInput prepared;
+    ncnn::Mat out;
+    Yolo26OutputLayout layout = Yolo26OutputLayout::Auto;  // of the model `out` came from
+    std::vector<Yolo26Object> objects;
+    bool ok = false;
+};
+
+namespace {
+
+// One stage: take frames from `in`, run `work`, hand them to `out`. Every queue can hold all frames,
+// so the hand-off never waits.
+template <typename Queue, typename Work>
+void run_stage(Queue& in, Queue& out, const std::atomic<bool>& stop, const Work& work)
+{
+    yolo26::Backoff backoff;
+    while (!stop)
+    {
+        typename Queue::value_type frame = 0;
+        if (!in.try_pop(frame))
+        {
+            backoff.wait();
+            continue;
+        }
+        backoff.reset();
+        work(*frame);
+        out.try_push(frame);
+    }
+}
+
+}  // namespace
+
+Yolo26Pipeline::Yolo26Pipeline(const Yolo26& detector, int depth)
+    : detector_(detector)
+{
+    depth = std::max(1, depth);
+    free_.reset(new Queue(depth));
+    to_preprocess_.reset(new Queue(depth));
+    to_infer_.reset(new Queue(depth));
+    to_postprocess_.reset(new Queue(depth));
+    done_.reset(new Queue(depth));
+    for (int i = 0; i < depth; i++)
+    {
+        frames_.push_back(std::unique_ptr<Frame>(new Frame));
+        free_->try_push(frames_.back().get());
+    }
+
+    threads_.emplace_back([this] { preprocess_loop(); });
+    threads_.emplace_back([this] { infer_loop(); });
+    threads_.emplace_back([this] { postprocess_loop(); });
+}
+
+Yolo26Pipeline::~Yolo26Pipeline()
+{
+    stop_ = true;
+    for (auto& t : threads_)
+        t.join();
+}
+
+bool Yolo26Pipeline::push(const Yolo26Image& frame)
+{
+    return push_frame(frame, cv::Mat());
+}
+
+bool Yolo26Pipeline::push(const cv::Mat& bgr)
+{
+    return push_frame(yolo26_image_from_mat(bgr), bgr);
+}
+
+bool Yolo26Pipeline::push_frame(const Yolo26Image& image, const cv::Mat& hold)
+{
+    Frame* frame = 0;
+    yolo26::Backoff backoff;
+    while (!free_->try_pop(frame))
+        backoff.wait();
+
+    frame->image = image;
+    frame->hold = hold;
+    frame->ok = true;
+    pending_++;
+    to_preprocess_->try_push(frame);
+    return true;
+}
+
+bool Yolo26Pipeline::pop(std::vector<Yolo26Object>& objects)
+{
+    objects.clear();
+    if (pending_ == 0)
+        return false;
+
+    Frame* frame = 0;
+    yolo26::Backoff backoff;
+    while (!done_->try_pop(frame))
+        backoff.wait();
+
+    // Swap so the frame keeps a vector with capacity for the next round.
+    objects.swap(frame->objects);
+    const bool ok = frame->ok;
+    frame->image = Yolo26Image();
+    frame->hold.release();
+    pending_--;
+    free_->try_push(frame);
+    return ok;
+}
+
+void Yolo26Pipeline::preprocess_loop()
+{
+    run_stage(*to_preprocess_, *to_infer_, stop_, [this](Frame& f) { f.ok = detector_.prepare(f.image, f.prepared); });
+}
+
+void Yolo26Pipeline::infer_loop()
+{
+    run_stage(*to_infer_, *to_postprocess_, stop_, [this](Frame& f) {
+        if (f.ok)
+            f.ok = detector_.extract(f.prepared.input, f.out, f.layout);
+    });
+}
+
+void Yolo26Pipeline::postprocess_loop()
+{
+    run_stage(*to_postprocess_, *done_, stop_, [this](Frame& f) {
+        f.objects.clear();
+        if (f.ok)
+            f.ok = detector_.postprocess(f.out, f.layout, f.prepared.info, f.prepared.img_w, f.prepared.img_h, f.objects, yolo26::thread_workspace());
+    });
+}
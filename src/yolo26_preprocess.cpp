@@ -2,9 +2,337 @@
 
 #include <algorithm>
 #include <cmath>
+#include <vector>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace yolo26 {
 
+namespace {
+
+void letterbox_geometry(int img_w,
+                        int img_h,
+                        int input_w,
+                        int input_h,
+                        bool scaleup,
+                        bool center,
+                        int stride,
+                        LetterBoxInfo& info)
+{
+    const float r0 = std::min(input_h / (float)img_h, input_w / (float)img_w);
+    const float r = scaleup ? r0 : std::min(r0, 1.f);
+
+    const int resized_w = std::max(1, (int)std::round(img_w * r));
+    const int resized_h = std::max(1, (int)std::round(img_h * r));
+
+    float dw = (float)input_w - resized_w;
+    float dh = (float)input_h - resized_h;
+    if (stride > 0)
+    {
+        dw = (float)((input_w - resized_w) % stride);
+        dh = (float)((input_h - resized_h) % stride);
+        input_w = resized_w + (int)dw;
+        input_h = resized_h + (int)dh;
+    }
+    if (center)
+    {
+        dw /= 2.f;
+        dh /= 2.f;
+    }
+
+    info.gain = r;
+    info.pad_x = center ? (int)std::round(dw - 0.1f) : 0;
+    info.pad_y = center ? (int)std::round(dh - 0.1f) : 0;
+    info.resized_w = resized_w;
+    info.resized_h = resized_h;
+    info.input_w = input_w;
+    info.input_h = input_h;
+}
+
+// Same sampling positions as ncnn::Mat::from_pixels_resize (bilinear, half-pixel centers, edge clamp).
+void bilinear_table(int src, int dst, std::vector<int>& ofs0, std::vector<int>& ofs1, std::vector<float>& alpha)
+{
+    ofs0.resize(dst);
+    ofs1.resize(dst);
+    alpha.resize(dst);
+
+    const double scale = (double)src / dst;
+    for (int d = 0; d < dst; d++)
+    {
+        float f = (float)((d + 0.5) * scale - 0.5);
+        int s = (int)std::floor(f);
+        f -= s;
+        if (s < 0)
+        {
+            s = 0;
+            f = 0.f;
+        }
+        if (s >= src - 1)
+        {
+            s = std::max(0, src - 2);
+            f = src > 1 ? 1.f : 0.f;
+        }
+        ofs0[d] = s;
+        ofs1[d] = std::min(s + 1, src - 1);
+        alpha[d] = f;
+    }
+}
+
+// Bytes per pixel of the (first) plane.
+int plane_pixel_bytes(Yolo26PixelFormat format)
+{
+    switch (format)
+    {
+    case Yolo26PixelFormat::BGR:
+    case Yolo26PixelFormat::RGB:
+        return 3;
+    case Yolo26PixelFormat::BGRA:
+    case Yolo26PixelFormat::RGBA:
+        return 4;
+    default:
+        return 1;
+    }
+}
+
+inline float clamp255(float v)
+{
+    return std::max(0.f, std::min(v, 255.f));
+}
+
+// ITU-R BT.601 limited range, same coefficients as cv::COLOR_YUV2BGR_NV12 / _I420.
+inline void yuv2rgb(int y, int u, int v, float* rgb)
+{
+    const float yy = std::max(0, y - 16) * 1.164f;
+    const float uu = u - 128.f;
+    const float vv = v - 128.f;
+    rgb[0] = clamp255(yy + 1.596f * vv);
+    rgb[1] = clamp255(yy - 0.813f * vv - 0.391f * uu);
+    rgb[2] = clamp255(yy + 2.018f * uu);
+}
+
+// Pixel sources: row(y) binds one source row, Row::rgb(x, out) reads pixel x as R, G, B.
+// Packed formats, channel indices of R, G, B within a CN-byte pixel (GRAY is CN = 1, all 0).
+template <int CN, int RI, int GI, int BI>
+struct PackedPixels {
+    struct Row {
+        const unsigned char* p;
+        void rgb(int x, float* out) const
+        {
+            const unsigned char* s = p + x * CN;
+            out[0] = s[RI];
+            out[1] = s[GI];
+            out[2] = s[BI];
+        }
+    };
+
+    explicit PackedPixels(const Yolo26Image& image)
+        : data(image.data), stride(image.stride)
+    {
+    }
+
+    Row row(int y) const
+    {
+        Row r;
+        r.p = data + (size_t)y * stride;
+        return r;
+    }
+
+    const unsigned char* data;
+    int stride;
+};
+
+// NV12 (UI = 0, VI = 1) / NV21 (UI = 1, VI = 0).
+template <int UI, int VI>
+struct SemiPlanarPixels {
+    struct Row {
+        const unsigned char* y;
+        const unsigned char* uv;
+        void rgb(int x, float* out) const
+        {
+            const unsigned char* c = uv + (x >> 1) * 2;
+            yuv2rgb(y[x], c[UI], c[VI], out);
+        }
+    };
+
+    explicit SemiPlanarPixels(const Yolo26Image& image)
+        : src(image)
+    {
+    }
+
+    Row row(int y) const
+    {
+        Row r;
+        r.y = src.data + (size_t)y * src.stride;
+        r.uv = src.data_uv + (size_t)(y >> 1) * src.stride_uv;
+        return r;
+    }
+
+    const Yolo26Image& src;
+};
+
+// I420
+struct PlanarPixels {
+    struct Row {
+        const unsigned char* y;
+        const unsigned char* u;
+        const unsigned char* v;
+        void rgb(int x, float* out) const
+        {
+            yuv2rgb(y[x], u[x >> 1], v[x >> 1], out);
+        }
+    };
+
+    explicit PlanarPixels(const Yolo26Image& image)
+        : src(image)
+    {
+    }
+
+    Row row(int y) const
+    {
+        Row r;
+        r.y = src.data + (size_t)y * src.stride;
+        r.u = src.data_uv + (size_t)(y >> 1) * src.stride_uv;
+        r.v = src.data_v + (size_t)(y >> 1) * src.stride_v;
+        return r;
+    }
+
+    const Yolo26Image& src;
+};
+
+struct BilinearTables {
+    const int* xofs0;
+    const int* xofs1;
+    const float* xalpha;
+    const int* yofs0;
+    const int* yofs1;
+    const float* yalpha;
+};
+
+// Horizontal pass of one source row: source pixels -> planar R, G, B floats.
+template <typename Row>
+void hresize_row(const Row& row, const BilinearTables& t, int w, float* dst)
+{
+    float* dst_r = dst;
+    float* dst_g = dst + w;
+    float* dst_b = dst + 2 * w;
+    float p0[3];
+    float p1[3];
+    for (int x = 0; x < w; x++)
+    {
+        row.rgb(t.xofs0[x], p0);
+        row.rgb(t.xofs1[x], p1);
+        const float a1 = t.xalpha[x];
+        const float a0 = 1.f - a1;
+        dst_r[x] = p0[0] * a0 + p1[0] * a1;
+        dst_g[x] = p0[1] * a0 + p1[1] * a1;
+        dst_b[x] = p0[2] * a0 + p1[2] * a1;
+    }
+}
+
+// dst[i] = r0[i] * b0 + r1[i] * b1
+void vblend_row(const float* r0, const float* r1, float b0, float b1, float* dst, int n)
+{
+    int i = 0;
+#if defined(__ARM_NEON)
+    const float32x4_t _b0 = vdupq_n_f32(b0);
+    const float32x4_t _b1 = vdupq_n_f32(b1);
+    for (; i + 3 < n; i += 4)
+    {
+        float32x4_t _p = vmulq_f32(vld1q_f32(r0 + i), _b0);
+        _p = vmlaq_f32(_p, vld1q_f32(r1 + i), _b1);
+        vst1q_f32(dst + i, _p);
+    }
+#elif defined(__SSE2__)
+    const __m128 _b0 = _mm_set1_ps(b0);
+    const __m128 _b1 = _mm_set1_ps(b1);
+    for (; i + 3 < n; i += 4)
+    {
+        __m128 _p = _mm_mul_ps(_mm_loadu_ps(r0 + i), _b0);
+        _p = _mm_add_ps(_p, _mm_mul_ps(_mm_loadu_ps(r1 + i), _b1));
+        _mm_storeu_ps(dst + i, _p);
+    }
+#endif
+    for (; i < n; i++)
+        dst[i] = r0[i] * b0 + r1[i] * b1;
+}
+
+template <typename Pixels>
+void letterbox_rows(const Pixels& px,
+                    const LetterBoxInfo& info,
+                    const BilinearTables& t,
+                    int padding_value,
+                    bool raw_bgr,
+                    ncnn::Mat& out,
+                    int dst_x,
+                    int dst_y,
+                    float* rows)
+{
+    const int input_w = info.input_w;
+    const int input_h = info.input_h;
+    const int rw = info.resized_w;
+    const int rh = info.resized_h;
+    const int left = info.pad_x;
+    const int top = info.pad_y;
+
+    // raw_bgr: the model has 1/255 and RGB -> BGR folded into its first conv, so emit BGR bytes as float.
+    const float norm = raw_bgr ? 1.f : 1 / 255.f;
+    const float pad = padding_value * norm;
+
+    // Two planar RGB rows: horizontally resampled source rows y0 and y1.
+    float* rows0 = rows;
+    float* rows1 = rows + 3 * rw;
+    int prev_y0 = -2;
+    int prev_y1 = -2;
+
+    for (int dy = 0; dy < input_h; dy++)
+    {
+        const int sy = dy - top;
+        if (sy < 0 || sy >= rh)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                float* dst = (float*)out.data + out.cstep * c + (size_t)(dst_y + dy) * out.w + dst_x;
+                std::fill(dst, dst + input_w, pad);
+            }
+            continue;
+        }
+
+        const int y0 = t.yofs0[sy];
+        const int y1 = t.yofs1[sy];
+        if (y0 != prev_y0)
+        {
+            if (y0 == prev_y1)
+                std::swap(rows0, rows1);
+            else
+                hresize_row(px.row(y0), t, rw, rows0);
+            prev_y0 = y0;
+            prev_y1 = -2;
+        }
+        if (y1 != prev_y1)
+        {
+            hresize_row(px.row(y1), t, rw, rows1);
+            prev_y1 = y1;
+        }
+
+        const float b1 = t.yalpha[sy] * norm;
+        const float b0 = norm - b1;
+        for (int c = 0; c < 3; c++)
+        {
+            float* dst = (float*)out.data + out.cstep * c + (size_t)(dst_y + dy) * out.w + dst_x;
+            std::fill(dst, dst + left, pad);
+            const int sc = raw_bgr ? 2 - c : c;
+            vblend_row(rows0 + sc * rw, rows1 + sc * rw, b0, b1, dst + left, rw);
+            std::fill(dst + left + rw, dst + input_w, pad);
+        }
+    }
+}
+
+}  // namespace
+
 bool letterbox(const cv::Mat& bgr,
                int input_w,
                int input_h,
@@ -64,5 +392,352 @@ void normalize_01_inplace(ncnn::Mat& in)
     in.substract_mean_normalize(0, norm_vals);
 }
 
-}  // namespace yolo26
+bool letterbox_normalized(const cv::Mat& bgr,
+                          int input_w,
+                          int input_h,
+                          int padding_value,
+                          bool scaleup,
+                          bool center,
+                          ncnn::Mat& out,
+                          LetterBoxInfo& info)
+{
+    Yolo26Image image;
+    if (!resolve_image(yolo26_image_from_mat(bgr), image) || input_w <= 0 || input_h <= 0)
+        return false;
 
+    const LetterBoxPlan plan(image.width, image.height, input_w, input_h, scaleup, center);
+    if (!plan.valid())
+        return false;
+
+    out.create(input_w, input_h, 3);
+    if (out.empty())
+        return false;
+
+    std::vector<float> rows(plan.rows_size());
+    plan.run(image, padding_value, out, rows.data());
+    info = plan.info();
+    return true;
+}
+
+bool resolve_image(const Yolo26Image& image, Yolo26Image& resolved)
+{
+    resolved = image;
+    if (!image.data || image.width <= 0 || image.height <= 0)
+        return false;
+    if (resolved.orig_width <= 0 || resolved.orig_height <= 0)
+    {
+        resolved.orig_width = image.width;
+        resolved.orig_height = image.height;
+    }
+
+    const int chroma_w = (image.width + 1) / 2;
+    const int chroma_h = (image.height + 1) / 2;
+
+    const int pixel_bytes = plane_pixel_bytes(image.format);
+    if (resolved.stride == 0)
+        resolved.stride = image.width * pixel_bytes;
+    if (resolved.stride < image.width * pixel_bytes)
+        return false;
+
+    if (image.format == Yolo26PixelFormat::NV12 || image.format == Yolo26PixelFormat::NV21)
+    {
+        if (resolved.stride_uv == 0)
+            resolved.stride_uv = std::max(resolved.stride, chroma_w * 2);
+        if (!resolved.data_uv)
+            resolved.data_uv = resolved.data + (size_t)resolved.stride * (size_t)image.height;
+        if (resolved.stride_uv < chroma_w * 2)
+            return false;
+    }
+    else if (image.format == Yolo26PixelFormat::I420)
+    {
+        if (resolved.stride_uv == 0)
+            resolved.stride_uv = std::max((resolved.stride + 1) / 2, chroma_w);
+        if (!resolved.data_uv)
+            resolved.data_uv = resolved.data + (size_t)resolved.stride * (size_t)image.height;
+        if (resolved.stride_v == 0)
+            resolved.stride_v = resolved.stride_uv;
+        if (!resolved.data_v)
+            resolved.data_v = resolved.data_uv + (size_t)resolved.stride_uv * (size_t)chroma_h;
+        if (resolved.stride_uv < chroma_w || resolved.stride_v < chroma_w)
+            return false;
+    }
+
+    return true;
+}
+
+bool prepared_matches(const Yolo26PreparedInput& prepared, const LetterBoxInfo& info, int padding_value, bool raw_bgr)
+{
+    const LetterBoxInfo& p = prepared.info;
+    return p.input_w == info.input_w && p.input_h == info.input_h && p.pad_x == info.pad_x && p.pad_y == info.pad_y
+           && p.resized_w == info.resized_w && p.resized_h == info.resized_h && prepared.raw_bgr == raw_bgr
+           && prepared.padding_value == padding_value;
+}
+
+bool resample_input(const Yolo26PreparedInput& prepared,
+                    LetterBoxPlan& plan,
+                    int padding_value,
+                    bool raw_bgr,
+                    ncnn::Mat& out)
+{
+    const LetterBoxInfo& info = plan.info();
+    const LetterBoxInfo& si = prepared.info;
+    const ncnn::Mat& in = prepared.input;
+    if (in.empty() || in.c != 3 || si.resized_w <= 0 || si.resized_h <= 0 || info.resized_w <= 0 || info.resized_h <= 0)
+        return false;
+
+    out.create(info.input_w, info.input_h, 3);
+    if (out.empty())
+        return false;
+
+    // Content of the prepared input is resampled as if it were the source image.
+    const std::shared_ptr<const LetterBoxPlan::ResampleTables> tables = plan.resample_tables(si.resized_w, si.resized_h);
+    const std::vector<int>& xofs0 = tables->xofs0;
+    const std::vector<int>& xofs1 = tables->xofs1;
+    const std::vector<float>& xalpha = tables->xalpha;
+    const std::vector<int>& yofs0 = tables->yofs0;
+    const std::vector<int>& yofs1 = tables->yofs1;
+    const std::vector<float>& yalpha = tables->yalpha;
+
+    const float src_norm = prepared.raw_bgr ? 1.f : 1 / 255.f;
+    const float dst_norm = raw_bgr ? 1.f : 1 / 255.f;
+    const float scale = dst_norm / src_norm;
+    const bool swap = prepared.raw_bgr != raw_bgr;
+    const float pad = padding_value * dst_norm;
+
+    const int rw = info.resized_w;
+    for (int c = 0; c < 3; c++)
+    {
+        const float* content = (const float*)in.channel(swap ? 2 - c : c) + (size_t)si.pad_y * in.w + si.pad_x;
+        for (int dy = 0; dy < info.input_h; dy++)
+        {
+            float* dst = (float*)out.channel(c) + (size_t)dy * info.input_w;
+            const int sy = dy - info.pad_y;
+            if (sy < 0 || sy >= info.resized_h)
+            {
+                std::fill(dst, dst + info.input_w, pad);
+                continue;
+            }
+
+            const float* r0 = content + (size_t)yofs0[sy] * in.w;
+            const float* r1 = content + (size_t)yofs1[sy] * in.w;
+            const float b1 = yalpha[sy] * scale;
+            const float b0 = scale - b1;
+            std::fill(dst, dst + info.pad_x, pad);
+            float* d = dst + info.pad_x;
+            for (int x = 0; x < rw; x++)
+            {
+                const int x0 = xofs0[x];
+                const int x1 = xofs1[x];
+                const float a = xalpha[x];
+                const float top = r0[x0] + (r0[x1] - r0[x0]) * a;
+                const float bottom = r1[x0] + (r1[x1] - r1[x0]) * a;
+                d[x] = top * b0 + bottom * b1;
+            }
+            std::fill(d + rw, dst + info.input_w, pad);
+        }
+    }
+    return true;
+}
+
+bool crop_image(const Yolo26Image& image, int x, int y, int w, int h, Yolo26Image& roi)
+{
+    if (x < 0 || y < 0 || w <= 0 || h <= 0 || x + w > image.width || y + h > image.height)
+        return false;
+
+    const bool is_yuv = image.format == Yolo26PixelFormat::NV12 || image.format == Yolo26PixelFormat::NV21
+                        || image.format == Yolo26PixelFormat::I420;
+    if (is_yuv && (x % 2 != 0 || y % 2 != 0))
+        return false;
+
+    roi = image;
+    roi.width = w;
+    roi.height = h;
+    roi.orig_width = 0;
+    roi.orig_height = 0;
+    roi.data = image.data + (size_t)y * image.stride + (size_t)x * plane_pixel_bytes(image.format);
+    if (image.format == Yolo26PixelFormat::NV12 || image.format == Yolo26PixelFormat::NV21)
+    {
+        roi.data_uv = image.data_uv + (size_t)(y / 2) * image.stride_uv + (size_t)x;
+    }
+    else if (image.format == Yolo26PixelFormat::I420)
+    {
+        roi.data_uv = image.data_uv + (size_t)(y / 2) * image.stride_uv + (size_t)(x / 2);
+        roi.data_v = image.data_v + (size_t)(y / 2) * image.stride_v + (size_t)(x / 2);
+    }
+    return true;
+}
+
+LetterBoxPlan::LetterBoxPlan(int src_w, int src_h, int input_w, int input_h, bool scaleup, bool center, int stride)
+    : src_w_(src_w),
+      src_h_(src_h),
+      input_w_(input_w),
+      input_h_(input_h),
+      scaleup_(scaleup),
+      center_(center),
+      stride_(std::max(0, stride))
+{
+    if (src_w <= 0 || src_h <= 0 || input_w <= 0 || input_h <= 0)
+        return;
+
+    letterbox_geometry(src_w, src_h, input_w, input_h, scaleup, center, stride_, info_);
+    bilinear_table(src_w, info_.resized_w, xofs0_, xofs1_, xalpha_);
+    bilinear_table(src_h, info_.resized_h, yofs0_, yofs1_, yalpha_);
+}
+
+std::shared_ptr<const LetterBoxPlan::ResampleTables> LetterBoxPlan::resample_tables(int from_w, int from_h)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < resample_.size(); i++)
+    {
+        if (resample_[i]->from_w == from_w && resample_[i]->from_h == from_h)
+            return resample_[i];
+    }
+
+    // First frame prepared at this geometry for this plan; every later one finds it above.
+    std::shared_ptr<ResampleTables> tables = std::make_shared<ResampleTables>();
+    tables->from_w = from_w;
+    tables->from_h = from_h;
+    bilinear_table(from_w, info_.resized_w, tables->xofs0, tables->xofs1, tables->xalpha);
+    bilinear_table(from_h, info_.resized_h, tables->yofs0, tables->yofs1, tables->yalpha);
+    resample_.push_back(tables);
+    return tables;
+}
+
+bool LetterBoxPlan::matches(int src_w, int src_h, int input_w, int input_h, bool scaleup, bool center, int stride) const
+{
+    return src_w_ == src_w && src_h_ == src_h && input_w_ == input_w && input_h_ == input_h
+           && scaleup_ == scaleup && center_ == center && stride_ == std::max(0, stride);
+}
+
+void LetterBoxPlan::run(const Yolo26Image& image,
+                        int padding_value,
+                        ncnn::Mat& out,
+                        float* rows,
+                        bool raw_bgr,
+                        int dst_x,
+                        int dst_y) const
+{
+    BilinearTables t;
+    t.xofs0 = xofs0_.data();
+    t.xofs1 = xofs1_.data();
+    t.xalpha = xalpha_.data();
+    t.yofs0 = yofs0_.data();
+    t.yofs1 = yofs1_.data();
+    t.yalpha = yalpha_.data();
+
+    switch (image.format)
+    {
+    case Yolo26PixelFormat::BGR:
+        letterbox_rows(PackedPixels<3, 2, 1, 0>(image), info_, t, padding_value, raw_bgr, out, dst_x, dst_y, rows);
+        break;
+    case Yolo26PixelFormat::RGB:
+        letterbox_rows(PackedPixels<3, 0, 1, 2>(image), info_, t, padding_value, raw_bgr, out, dst_x, dst_y, rows);
+        break;
+    case Yolo26PixelFormat::BGRA:
+        letterbox_rows(PackedPixels<4, 2, 1, 0>(image), info_, t, padding_value, raw_bgr, out, dst_x, dst_y, rows);
+        break;
+    case Yolo26PixelFormat::RGBA:
+        letterbox_rows(PackedPixels<4, 0, 1, 2>(image), info_, t, padding_value, raw_bgr, out, dst_x, dst_y, rows);
+        break;
+    case Yolo26PixelFormat::GRAY:
+        letterbox_rows(PackedPixels<1, 0, 0, 0>(image), info_, t, padding_value, raw_bgr, out, dst_x, dst_y, rows);
+        break;
+    case Yolo26PixelFormat::NV12:
+        letterbox_rows(SemiPlanarPixels<0, 1>(image), info_, t, padding_value, raw_bgr, out, dst_x, dst_y, rows);
+        break;
+    case Yolo26PixelFormat::NV21:
+        letterbox_rows(SemiPlanarPixels<1, 0>(image), info_, t, padding_value, raw_bgr, out, dst_x, dst_y, rows);
+        break;
+    case Yolo26PixelFormat::I420:
+        letterbox_rows(PlanarPixels(image), info_, t, padding_value, raw_bgr, out, dst_x, dst_y, rows);
+        break;
+    }
+}
+
+LetterBoxPlan::Buffers* LetterBoxPlan::acquire()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!free_.empty())
+    {
+        Buffers* buffers = free_.back();
+        free_.pop_back();
+        return buffers;
+    }
+
+    // First use on this thread count: grow the pool once, steady state never gets here.
+    std::unique_ptr<Buffers> buffers(new Buffers);
+    buffers->input.create(info_.input_w, info_.input_h, 3);
+    buffers->rows.resize(rows_size());
+    buffers_.push_back(std::move(buffers));
+    free_.reserve(buffers_.size());
+    return buffers_.back().get();
+}
+
+void LetterBoxPlan::release(Buffers* buffers)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(buffers);
+}
+
+LetterBoxPlan::Lease::Lease(LetterBoxPlan& plan)
+    : plan_(plan), buffers_(plan.acquire())
+{
+}
+
+LetterBoxPlan::Lease::~Lease()
+{
+    plan_.release(buffers_);
+}
+
+std::shared_ptr<LetterBoxPlan> LetterBoxPlanCache::get(int src_w,
+                                                       int src_h,
+                                                       int input_w,
+                                                       int input_h,
+                                                       bool scaleup,
+                                                       bool center,
+                                                       int stride)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < plans_.size(); i++)
+    {
+        if (plans_[i]->matches(src_w, src_h, input_w, input_h, scaleup, center, stride))
+        {
+            std::rotate(plans_.begin(), plans_.begin() + i, plans_.begin() + i + 1);
+            return plans_.front();
+        }
+    }
+
+    std::shared_ptr<LetterBoxPlan> plan
+        = std::make_shared<LetterBoxPlan>(src_w, src_h, input_w, input_h, scaleup, center, stride);
+    if (!plan->valid())
+        return std::shared_ptr<LetterBoxPlan>();
+
+    if (plans_.size() >= max_plans_)
+        plans_.pop_back();
+    plans_.insert(plans_.begin(), plan);
+    return plan;
+}
+
+bool ShapeBuckets::admit(int w, int h)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < shapes_.size(); i++)
+    {
+        if (shapes_[i].first == w && shapes_[i].second == h)
+            return true;
+    }
+
+    if ((int)shapes_.size() >= max_shapes_)
+        return false;
+
+    shapes_.push_back(std::make_pair(w, h));
+    return true;
+}
+
+std::vector<std::pair<int, int> > ShapeBuckets::shapes()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return shapes_;
+}
+
+}  // namespace yolo26
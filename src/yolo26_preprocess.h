@@ -2,19 +2,18 @@
 
 #include <opencv2/core/core.hpp>
 
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
 #include "mat.h"
 
-namespace yolo26 {
+#include "yolo26_image.h"
+#include "yolo26_input.h"
 
-struct LetterBoxInfo {
-    float gain = 1.f;  // resize ratio r
-    int pad_x = 0;     // left padding in pixels
-    int pad_y = 0;     // top padding in pixels
-    int resized_w = 0;
-    int resized_h = 0;
-    int input_w = 0;
-    int input_h = 0;
-};
+namespace yolo26 {
 
 bool letterbox(const cv::Mat& bgr,
                int input_w,
@@ -27,5 +26,176 @@ bool letterbox(const cv::Mat& bgr,
 
 void normalize_01_inplace(ncnn::Mat& in);
 
-}  // namespace yolo26
+// Single-pass equivalent of letterbox() + normalize_01_inplace():
+// bilinear resize, BGR -> RGB, * 1/255 and constant padding are written straight into the CHW output.
+bool letterbox_normalized(const cv::Mat& bgr,
+                          int input_w,
+                          int input_h,
+                          int padding_value,
+                          bool scaleup,
+                          bool center,
+                          ncnn::Mat& out,
+                          LetterBoxInfo& info);
+
+// Validates a view and fills in default strides / chroma plane pointers.
+bool resolve_image(const Yolo26Image& image, Yolo26Image& resolved);
+
+// True when `prepared` can be fed as-is to a model expecting `info` geometry and this input encoding.
+bool prepared_matches(const Yolo26PreparedInput& prepared, const LetterBoxInfo& info, int padding_value, bool raw_bgr);
+
+// Zero-copy w x h sub-view at (x, y) of a resolved image (x / y even for YUV). The ROI reports results
+// in its own pixel coordinates (orig_width / orig_height are reset).
+bool crop_image(const Yolo26Image& image, int x, int y, int w, int h, Yolo26Image& roi);
+
+// Letterbox geometry, bilinear tables and preallocated input buffers for one
+// (src_w, src_h, input_w, input_h, scaleup, center, stride) key. Built once per stream resolution;
+// running it afterwards does no heap allocation.
+// stride > 0 selects the minimal-padding "rect" shape (Ultralytics auto=True): the image is still
+// resized to fit input_w x input_h, but each side is only padded up to a multiple of stride, so
+// info().input_w / input_h may be smaller than the requested size.
+class LetterBoxPlan {
+    struct Buffers {
+        ncnn::Mat input;
+        std::vector<float> rows;
+    };
+
+public:
+    // Bilinear tables from another plan's resized content (from_w x from_h) into this plan's.
+    struct ResampleTables {
+        int from_w = 0;
+        int from_h = 0;
+        std::vector<int> xofs0;
+        std::vector<int> xofs1;
+        std::vector<float> xalpha;
+        std::vector<int> yofs0;
+        std::vector<int> yofs1;
+        std::vector<float> yalpha;
+    };
+
+    LetterBoxPlan(int src_w, int src_h, int input_w, int input_h, bool scaleup, bool center, int stride = 0);
+
+    LetterBoxPlan(const LetterBoxPlan&) = delete;
+    LetterBoxPlan& operator=(const LetterBoxPlan&) = delete;
+
+    bool valid() const { return info_.input_w > 0 && info_.input_h > 0; }
+    bool matches(int src_w, int src_h, int input_w, int input_h, bool scaleup, bool center, int stride) const;
+    const LetterBoxInfo& info() const { return info_; }
+
+    // Floats of row scratch needed by run().
+    size_t rows_size() const { return (size_t)6 * (size_t)info_.resized_w; }
+
+    // Fused resize + color conversion to RGB + 1/255 + padding, sampling the source view directly
+    // (packed, GRAY or YUV, any stride). `image` must be resolved and of the plan's source size,
+    // `out` must already be input_w x input_h x 3 floats and `rows` must hold rows_size() floats.
+    // raw_bgr writes BGR in 0..255 instead, for models exported with --fold-preprocess.
+    // dst_x / dst_y place the input_w x input_h block inside a larger `out` (mosaic canvases).
+    void run(const Yolo26Image& image,
+             int padding_value,
+             ncnn::Mat& out,
+             float* rows,
+             bool raw_bgr = false,
+             int dst_x = 0,
+             int dst_y = 0) const;
+
+    // Tables for resample_input(), built the first time a from_w x from_h content is seen and kept.
+    std::shared_ptr<const ResampleTables> resample_tables(int from_w, int from_h);
+
+    // Exclusive use of one preallocated input tensor + row scratch; returned to the plan on destruction.
+    // Keep the lease alive until the extractor that consumed input() is gone.
+    class Lease {
+    public:
+        explicit Lease(LetterBoxPlan& plan);
+        ~Lease();
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
 
+        ncnn::Mat& input() { return buffers_->input; }
+        float* rows() { return buffers_->rows.data(); }
+
+    private:
+        LetterBoxPlan& plan_;
+        Buffers* buffers_;
+    };
+
+private:
+    friend class Lease;
+    Buffers* acquire();
+    void release(Buffers* buffers);
+
+    int src_w_ = 0;
+    int src_h_ = 0;
+    int input_w_ = 0;
+    int input_h_ = 0;
+    bool scaleup_ = true;
+    bool center_ = true;
+    int stride_ = 0;
+    LetterBoxInfo info_;
+
+    std::vector<int> xofs0_;
+    std::vector<int> xofs1_;
+    std::vector<float> xalpha_;
+    std::vector<int> yofs0_;
+    std::vector<int> yofs1_;
+    std::vector<float> yalpha_;
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Buffers>> buffers_;
+    std::vector<Buffers*> free_;
+    std::vector<std::shared_ptr<const ResampleTables>> resample_;
+};
+
+// Derives the input for `plan` from another model's prepared input: strided bilinear resample of its
+// letterboxed content (no trip back to the source frame), channel order / scale conversion when the
+// encodings differ, and fresh padding. `out` is (re)created as the plan's input_w x input_h x 3. The
+// bilinear tables are the plan's, built once per prepared geometry.
+bool resample_input(const Yolo26PreparedInput& prepared,
+                    LetterBoxPlan& plan,
+                    int padding_value,
+                    bool raw_bgr,
+                    ncnn::Mat& out);
+
+// Small MRU cache of plans so a detector serving a few fixed-resolution streams never rebuilds them.
+// A mosaic needs one plan per cell plus the canvas at once, so detectors size it for their grid.
+class LetterBoxPlanCache {
+public:
+    explicit LetterBoxPlanCache(size_t max_plans = 4)
+        : max_plans_(max_plans)
+    {
+    }
+
+    std::shared_ptr<LetterBoxPlan> get(int src_w,
+                                       int src_h,
+                                       int input_w,
+                                       int input_h,
+                                       bool scaleup,
+                                       bool center,
+                                       int stride = 0);
+
+private:
+    const size_t max_plans_;
+    std::mutex mutex_;
+    std::vector<std::shared_ptr<LetterBoxPlan>> plans_;  // most recently used first
+};
+
+// Distinct rect-mode input shapes seen by a detector. Capped so the set of shapes ncnn (and its
+// pooled allocators) has to serve stays small; shapes beyond the cap fall back to the full input.
+class ShapeBuckets {
+public:
+    explicit ShapeBuckets(int max_shapes)
+        : max_shapes_(max_shapes)
+    {
+    }
+
+    // False when (w, h) is unknown and the cache is full.
+    bool admit(int w, int h);
+    // Shapes admitted so far, in admission order.
+    std::vector<std::pair<int, int> > shapes();
+
+private:
+    int max_shapes_;
+    std::mutex mutex_;
+    std::vector<std::pair<int, int> > shapes_;
+};
+
+}  // namespace yolo26
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+
+#include "yolo26.h"
+#include "yolo26_mask.h"
+#include "yolo26_nms.h"
+#include "yolo26_seg.h"
+#include "yolo26_topk.h"
+#include "yolo26_workspace.h"
+
+namespace yolo26 {
+
+// A Yolo26Seg candidate; its mask_dim coefficients start at `coeffs` in the workspace's coeffs.
+struct SegCandidate {
+    float x1 = 0.f;
+    float y1 = 0.f;
+    float x2 = 0.f;
+    float y2 = 0.f;
+    int label = -1;
+    float prob = 0.f;
+    int coeffs = 0;
+};
+
+// The calling thread's workspace, for calls made without one.
+Yolo26Workspace& thread_workspace();
+
+}  // namespace yolo26
+
+struct Yolo26Workspace::Impl {
+    std::vector<Yolo26Object> proposals;
+    yolo26::TopKScratch topk;
+    yolo26::NmsScratch<Yolo26Object> nms;
+    std::vector<const float*> score_rows;
+    std::vector<const float*> mask_rows;
+
+    std::vector<yolo26::SegCandidate> seg_candidates;
+    yolo26::NmsScratch<yolo26::SegCandidate> seg_nms;
+    std::vector<float> coeffs;
+    std::vector<int> seg_heap;  // candidate indices, lowest score first, when candidates are capped
+    yolo26::MaskScratch mask;
+    Yolo26SegObject streamed;  // the object detect_stream() hands out
+
+    template <typename T>
+    static size_t bytes(const std::vector<T>& v)
+    {
+        return v.capacity() * sizeof(T);
+    }
+
+    size_t capacity_bytes() const
+    {
+        return bytes(proposals) + bytes(topk.anchor_best) + bytes(topk.candidates) + bytes(topk.results) + bytes(nms.order) + bytes(nms.sorted)
+               + bytes(nms.suppressed) + bytes(score_rows) + bytes(mask_rows) + bytes(seg_candidates) + bytes(seg_nms.order)
+               + bytes(seg_nms.sorted) + bytes(seg_nms.suppressed) + bytes(coeffs) + bytes(seg_heap) + bytes(mask.logits) + bytes(mask.plane)
+               + bytes(mask.roi) + bytes(mask.scaled) + streamed.mask.total() * streamed.mask.elemSize();
+    }
+};
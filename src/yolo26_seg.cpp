@@ -1,110 +1,690 @@
 #include "yolo26_seg.h"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <mutex>
 
 #include <opencv2/imgproc/imgproc.hpp>
 
 #include "net.h"
 #include "cpu.h"
 
+#include "yolo26_allocator.h"
+#include "yolo26_async.h"
+#include "yolo26_budget.h"
+#include "yolo26_bounded_reader.h"
+#include "yolo26_bundle.h"
+#include "yolo26_mapped_file.h"
+#include "yolo26_model.h"
 #include "yolo26_preprocess.h"
 #include "yolo26_ops.h"
+#include "yolo26_option_profile.h"
 #include "yolo26_ncnn_io.h"
 #include "yolo26_ncnn_mat.h"
 #include "yolo26_topk.h"
 #include "yolo26_mask.h"
 #include "yolo26_nms.h"
+#include "yolo26_scratch.h"
+#include "yolo26_thread_pool.h"
+#include "yolo26_tile.h"
 
 namespace {
 
-struct Yolo26SegCandidate {
-    float x1 = 0.f;
-    float y1 = 0.f;
-    float x2 = 0.f;
-    float y2 = 0.f;
-    int label = -1;
-    float prob = 0.f;
-    std::vector<float> mask_feat;
-};
+// Under a memory budget, NMS sees at most this many candidates per max_det.
+const int kBudgetCandidatesPerDet = 10;
+
+// Adds a candidate with its mask_dim coefficients (coefficient m at coeff[m * stride]). With a cap,
+// only the `cap` highest-scoring candidates are kept: once full, a better one takes over the slot and
+// coefficient block of the lowest, found through a min-heap of candidate indices.
+void add_candidate(std::vector<yolo26::SegCandidate>& candidates,
+                   std::vector<float>& coeffs,
+                   std::vector<int>& heap,
+                   size_t cap,
+                   int mask_dim,
+                   yolo26::SegCandidate obj,
+                   const float* coeff,
+                   int stride)
+{
+    const auto lower = [&candidates](int a, int b) { return candidates[a].prob > candidates[b].prob; };
+    if (cap == 0 || candidates.size() < cap)
+    {
+        obj.coeffs = (int)coeffs.size();
+        for (int m = 0; m < mask_dim; m++)
+            coeffs.push_back(coeff[(size_t)m * stride]);
+        candidates.push_back(obj);
+        if (cap > 0)
+        {
+            heap.push_back((int)candidates.size() - 1);
+            std::push_heap(heap.begin(), heap.end(), lower);
+        }
+        return;
+    }
+
+    const int worst = heap.front();
+    if (obj.prob <= candidates[worst].prob)
+        return;
+    std::pop_heap(heap.begin(), heap.end(), lower);
+    obj.coeffs = candidates[worst].coeffs;
+    for (int m = 0; m < mask_dim; m++)
+        coeffs[obj.coeffs + m] = coeff[(size_t)m * stride];
+    candidates[worst] = obj;
+    std::push_heap(heap.begin(), heap.end(), lower);
+}
 
 }  // namespace
 
 Yolo26Seg::Yolo26Seg(const Yolo26SegConfig& config)
-    : config_(config), net_(std::make_shared<ncnn::Net>())
+    : config_(config),
+      model_(std::make_shared<yolo26::ModelSlot>()),
+      letterbox_plans_(std::make_shared<yolo26::LetterBoxPlanCache>()),
+      rect_shapes_(std::make_shared<yolo26::ShapeBuckets>(config.rect_max_shapes)),
+      allocators_(std::make_shared<yolo26::AllocatorPool>(config.huge_pages)),
+      memory_(std::make_shared<yolo26::MemoryStatsRecorder>(config.memory_budget_bytes))
 {
 }
 
-Yolo26Seg::~Yolo26Seg() = default;
+Yolo26Seg::~Yolo26Seg()
+{
+    // Copies share the queue; none of the jobs may outlive the instance they call into.
+    if (async_)
+        async_->wait_idle();
+}
 
-bool Yolo26Seg::load(const std::string& param_path, const std::string& bin_path)
+bool Yolo26Seg::configure_net(ncnn::Net& net) const
 {
-    if (!net_)
-        net_ = std::make_shared<ncnn::Net>();
+#if NCNN_VULKAN
+    net.opt.use_vulkan_compute = config_.use_gpu;
+#endif
+    net.opt.num_threads = config_.num_threads > 0 ? config_.num_threads : ncnn::get_big_cpu_count();
 
+    // Options must be final before load_param: layers pick their kernels when they are created.
+    if (!config_.option_profile.empty() && !yolo26::load_option_profile(config_.option_profile, config_.num_threads, net.opt))
+        return false;
+    if (config_.int8)
+    {
+        // ncnn's Vulkan backend has no int8 convolutions.
+        net.opt.use_int8_inference = true;
+#if NCNN_VULKAN
+        net.opt.use_vulkan_compute = false;
+#endif
+    }
+    if (config_.memory_budget_bytes > 0)
+    {
+        // Blobs freed as soon as consumed, weights and blobs in half precision. The budget only sees
+        // CPU memory.
+        net.opt.lightmode = true;
+        net.opt.use_fp16_storage = true;
+        net.opt.use_fp16_packed = true;
 #if NCNN_VULKAN
-    net_->opt.use_vulkan_compute = config_.use_gpu;
+        net.opt.use_vulkan_compute = false;
 #endif
-    net_->opt.num_threads = ncnn::get_big_cpu_count();
+    }
+    return true;
+}
+
+std::unique_ptr<yolo26::LoadedModel> Yolo26Seg::open_model(const std::string& param_path, const std::string& bin_path) const
+{
+    if (config_.mmap_model)
+    {
+        std::string param;
+        const std::shared_ptr<const yolo26::MappedFile> bin = yolo26::MappedFile::open(bin_path);
+        if (!bin || !yolo26::read_text_file(param_path, param))
+            return std::unique_ptr<yolo26::LoadedModel>();
+        return open_model(param.c_str(), bin->data(), bin, bin->size());
+    }
+
+    std::unique_ptr<yolo26::LoadedModel> model(new yolo26::LoadedModel);
+    if (!configure_net(model->net))
+        return std::unique_ptr<yolo26::LoadedModel>();
+    if (model->net.load_param(param_path.c_str()) != 0)
+        return std::unique_ptr<yolo26::LoadedModel>();
+    if (model->net.load_model(bin_path.c_str()) != 0)
+        return std::unique_ptr<yolo26::LoadedModel>();
+    return model;
+}
+
+std::unique_ptr<yolo26::LoadedModel> Yolo26Seg::open_model(const char* param_mem,
+                                                           const unsigned char* bin_mem,
+                                                           const std::shared_ptr<const yolo26::MappedFile>& data,
+                                                           size_t bin_size) const
+{
+    if (!param_mem || !bin_mem)
+        return std::unique_ptr<yolo26::LoadedModel>();
+
+    std::unique_ptr<yolo26::LoadedModel> model(new yolo26::LoadedModel);
+    model->data = data;
+    if (!configure_net(model->net))
+        return std::unique_ptr<yolo26::LoadedModel>();
+    if (model->net.load_param_mem(param_mem) != 0)
+        return std::unique_ptr<yolo26::LoadedModel>();
+    if (bin_size == 0)
+    {
+        if (model->net.load_model(bin_mem) == 0)
+            return std::unique_ptr<yolo26::LoadedModel>();
+        return model;
+    }
+
+    // A known size bounds every weight read, and the model must use all of it: a truncated or
+    // mismatched .bin fails here instead of feeding ncnn bytes past the mapping.
+    const yolo26::BoundedDataReader reader(bin_mem, bin_size);
+    if (model->net.load_model(reader) != 0 || reader.remaining() != 0)
+        return std::unique_ptr<yolo26::LoadedModel>();
+    return model;
+}
+
+bool Yolo26Seg::plan_model(yolo26::LoadedModel& model) const
+{
+    // Blob indices and the output layout are fixed by the graph: resolve them once with a blank
+    // input_width x input_height run, so per-frame calls skip name lookups and shape guessing.
+    model.io.resolve(model.net, config_.input_name, config_.output_name);
+    model.io.resolve_proto(model.net, config_.proto_name);
+    Yolo26OutputLayout layout = Yolo26OutputLayout::Auto;
+    if (!warmup_shape(model, config_.input_width, config_.input_height, &layout) || layout == Yolo26OutputLayout::Auto)
+        return false;
+    model.io.layout = layout;
+    return true;
+}
+
+bool Yolo26Seg::finish_load(std::unique_ptr<yolo26::LoadedModel> model)
+{
+    // Opening the model needs no lock; planning it and publishing it are serialized with reload().
+    std::lock_guard<std::mutex> lock(model_->load_mutex());
+    if (!model || !plan_model(*model))
+        return false;
+    model_->publish(std::move(model), false, yolo26::ModelSlot::Clock::time_point(), 0.0, 0.0);
+
+    if (config_.tiled)
+    {
+        // The calling thread works on tiles too.
+        const int workers = config_.tile_workers > 0 ? config_.tile_workers : ncnn::get_big_cpu_count();
+        tile_pool_ = std::make_shared<yolo26::ThreadPool>(std::max(0, workers - 1));
+    }
+    // detect_batch() workers live as long as the detector, and with them their thread_workspace().
+    const int batch_workers = config_.batch_workers > 0 ? config_.batch_workers : ncnn::get_big_cpu_count();
+    if (batch_workers > 1)
+        batch_pool_ = std::make_shared<yolo26::ThreadPool>(batch_workers - 1);
+    if (config_.async_workers > 0)
+        async_ = std::make_shared<yolo26::AsyncQueue>(config_.async_workers, config_.async_queue_depth);
+
+    return true;
+}
+
+bool Yolo26Seg::load(const std::string& param_path, const std::string& bin_path)
+{
+    return finish_load(open_model(param_path, bin_path));
+}
+
+bool Yolo26Seg::load_bundle(const std::string& path)
+{
+    const std::shared_ptr<const yolo26::MappedFile> file = yolo26::MappedFile::open(path);
+    yolo26::Bundle bundle;
+    Yolo26SegConfig config = config_;
+    if (!file || !yolo26::parse_bundle(*file, bundle) || !yolo26::apply_bundle(bundle, "segment", config))
+        return false;
+    config.mask_dim = bundle.get_int("nm", config.mask_dim);
+    config.proto_name = bundle.get("proto_blob", config.proto_name);
+    if (config.mask_dim <= 0)
+        return false;
+
+    // The bundle's config is only kept once its model is current.
+    const Yolo26SegConfig previous = config_;
+    config_ = config;
+    if (finish_load(open_model(bundle.param, bundle.bin, file, bundle.bin_size)))
+        return true;
+    config_ = previous;
+    return false;
+}
+
+bool Yolo26Seg::load_memory(const char* param_mem, const unsigned char* bin_mem)
+{
+    return finish_load(open_model(param_mem, bin_mem, std::shared_ptr<const yolo26::MappedFile>()));
+}
+
+bool Yolo26Seg::reload(const std::string& param_path, const std::string& bin_path)
+{
+    typedef yolo26::ModelSlot::Clock Clock;
+    std::lock_guard<std::mutex> lock(model_->load_mutex());
+    if (!model_->get())
+        return false;
 
-    if (net_->load_param(param_path.c_str()) != 0)
+    const Clock::time_point started = Clock::now();
+    std::unique_ptr<yolo26::LoadedModel> model = open_model(param_path, bin_path);
+    const Clock::time_point loaded = Clock::now();
+
+    // Warm every shape calls are being served at, so the first frames on the new net do not stall.
+    bool ok = model && plan_model(*model);
+    if (ok && config_.rect)
+    {
+        const std::vector<std::pair<int, int> > shapes = rect_shapes_->shapes();
+        for (size_t i = 0; ok && i < shapes.size(); i++)
+            ok = warmup_shape(*model, shapes[i].first, shapes[i].second);
+    }
+    if (!ok)
+    {
+        model_->failed();
+        return false;
+    }
+
+    const Clock::time_point warmed = Clock::now();
+    model_->publish(std::move(model),
+                    true,
+                    started,
+                    std::chrono::duration<double, std::milli>(loaded - started).count(),
+                    std::chrono::duration<double, std::milli>(warmed - loaded).count());
+    return true;
+}
+
+Yolo26ReloadStats Yolo26Seg::reload_stats() const
+{
+    return model_->stats();
+}
+
+Yolo26MemoryStats Yolo26Seg::memory_stats() const
+{
+    return memory_->stats();
+}
+
+bool Yolo26Seg::warmup(int src_w, int src_h) const
+{
+    const std::shared_ptr<const yolo26::LoadedModel> model = model_->get();
+    if (!model)
+        return false;
+
+    const std::shared_ptr<yolo26::LetterBoxPlan> plan = letterbox_plan(src_w, src_h);
+    if (!plan)
+        return false;
+    return warmup_shape(*model, plan->info().input_w, plan->info().input_h);
+}
+
+std::shared_ptr<yolo26::LetterBoxPlan> Yolo26Seg::letterbox_plan(int img_w, int img_h) const
+{
+    if (config_.rect && config_.rect_stride > 0)
+    {
+        std::shared_ptr<yolo26::LetterBoxPlan> plan = letterbox_plans_->get(img_w,
+                                                                           img_h,
+                                                                           config_.input_width,
+                                                                           config_.input_height,
+                                                                           config_.scaleup,
+                                                                           config_.center,
+                                                                           config_.rect_stride);
+        // No dry run here: this is the detect path. warmup() and reload() warm admitted shapes.
+        if (plan && rect_shapes_->admit(plan->info().input_w, plan->info().input_h))
+        {
+            // A memory budget needs the shape's measured extraction peak; until warmup() measured
+            // it, the frame runs at the full input size, which load() measured.
+            size_t peak = 0;
+            const std::shared_ptr<const yolo26::LoadedModel> current = config_.memory_budget_bytes > 0 ? model_->get() : nullptr;
+            if (config_.memory_budget_bytes == 0 || (current && current->peaks.find(plan->info().input_w, plan->info().input_h, peak)))
+                return plan;
+        }
+    }
+
+    return letterbox_plans_->get(
+        img_w, img_h, config_.input_width, config_.input_height, config_.scaleup, config_.center);
+}
+
+bool Yolo26Seg::warmup_shape(const yolo26::LoadedModel& model, int input_w, int input_h, Yolo26OutputLayout* layout) const
+{
+    ncnn::Mat in(input_w, input_h, 3);
+    if (in.empty())
         return false;
-    if (net_->load_model(bin_path.c_str()) != 0)
+    in.fill(0.f);
+
+    // Under a memory budget the dry run also measures the shape's extraction peak (ShapePeaks).
+    yolo26::MemoryBudget extraction((size_t)-1);
+    yolo26::AllocatorPool::Lease allocators(*allocators_);
+    yolo26::BudgetAllocator budget_blobs(&extraction);
+    yolo26::BudgetAllocator budget_workspace(&extraction);
+    ncnn::Extractor ex = yolo26::create_extractor(model.net, allocators);
+    if (config_.memory_budget_bytes > 0)
+    {
+        ex.set_blob_allocator(&budget_blobs);
+        ex.set_workspace_allocator(&budget_workspace);
+    }
+    if (!model.io.input(ex, config_.input_name, in))
         return false;
 
+    ncnn::Mat out;
+    ncnn::Mat proto;
+    if (!model.io.output(ex, config_.output_name, out))
+        return false;
+    if (!model.io.proto(ex, config_.proto_name, proto))
+        return false;
+    if (config_.memory_budget_bytes > 0)
+        model.peaks.record(input_w, input_h, extraction.peak());
+    if (layout)
+    {
+        ncnn::Mat out_2d;
+        if (!yolo26::to_mat2d(out, out_2d))
+            return false;
+        const int det_mask_dim = 4 + config_.num_classes + config_.mask_dim;
+        *layout = yolo26::resolve_output_layout(out_2d.w, out_2d.h, det_mask_dim, 6 + config_.mask_dim, config_.output_layout);
+    }
     return true;
 }
 
 bool Yolo26Seg::detect(const cv::Mat& bgr, std::vector<Yolo26SegObject>& objects) const
 {
-    if (!net_ || bgr.empty())
+    return detect(yolo26_image_from_mat(bgr), objects, yolo26::thread_workspace());
+}
+
+bool Yolo26Seg::detect(const Yolo26Image& image, std::vector<Yolo26SegObject>& objects) const
+{
+    return detect(image, objects, yolo26::thread_workspace());
+}
+
+bool Yolo26Seg::detect(const cv::Mat& bgr, std::vector<Yolo26SegObject>& objects, Yolo26Workspace& workspace) const
+{
+    return detect(yolo26_image_from_mat(bgr), objects, workspace);
+}
+
+bool Yolo26Seg::detect(const Yolo26Image& image, std::vector<Yolo26SegObject>& objects, Yolo26Workspace& workspace) const
+{
+    if (config_.tiled && tile_pool_)
+    {
+        Yolo26Image src;
+        if (!yolo26::resolve_image(image, src))
+            return false;
+        // Tiles run on pool threads, each with its own thread's workspace.
+        if (src.width > config_.input_width || src.height > config_.input_height)
+            return detect_tiled(src, objects);
+    }
+    return detect_once(image, 0, objects, workspace);
+}
+
+bool Yolo26Seg::detect_stream(const cv::Mat& bgr, const Yolo26SegObjectCallback& callback, Yolo26Workspace& workspace) const
+{
+    return detect_stream(yolo26_image_from_mat(bgr), callback, workspace);
+}
+
+bool Yolo26Seg::detect_stream(const Yolo26Image& image, const Yolo26SegObjectCallback& callback, Yolo26Workspace& workspace) const
+{
+    if (!callback)
         return false;
+    std::vector<Yolo26SegObject> unused;
+    return detect_once(image, 0, unused, workspace, &callback);
+}
 
-    const int img_w = bgr.cols;
-    const int img_h = bgr.rows;
-
-    yolo26::LetterBoxInfo lb;
-    ncnn::Mat in_pad;
-    if (!yolo26::letterbox(bgr,
-                           config_.input_width,
-                           config_.input_height,
-                           config_.padding_value,
-                           config_.scaleup,
-                           config_.center,
-                           in_pad,
-                           lb))
+bool Yolo26Seg::detect_once(const Yolo26Image& image,
+                            int num_threads,
+                            std::vector<Yolo26SegObject>& objects,
+                            Yolo26Workspace& workspace,
+                            const Yolo26SegObjectCallback* stream) const
+{
+    Yolo26Image src;
+    if (!yolo26::resolve_image(image, src))
         return false;
-    yolo26::normalize_01_inplace(in_pad);
 
-    ncnn::Extractor ex = net_->create_extractor();
-    if (!yolo26::ncnn_input_image(ex, config_.input_name, in_pad))
+    // Results are reported in original coordinates, which differ from src for reduced decodes.
+    const int img_w = src.orig_width;
+    const int img_h = src.orig_height;
+
+    const std::shared_ptr<yolo26::LetterBoxPlan> plan = letterbox_plan(src.width, src.height);
+    if (!plan)
+        return false;
+
+    // The lease must outlive the extractor below, which references the input tensor.
+    yolo26::LetterBoxPlan::Lease lease(*plan);
+    ncnn::Mat& in_pad = lease.input();
+    plan->run(src, config_.padding_value, in_pad, lease.rows(), config_.raw_bgr_input);
+    yolo26::LetterBoxInfo lb = plan->info();
+    lb.src_scale_x = img_w / (float)src.width;
+    lb.src_scale_y = img_h / (float)src.height;
+
+    return infer(in_pad, lb, img_w, img_h, num_threads, objects, workspace, stream);
+}
+
+bool Yolo26Seg::detect_batch(const std::vector<cv::Mat>& images, std::vector<std::vector<Yolo26SegObject>>& objects) const
+{
+    std::vector<Yolo26Image> views(images.size());
+    for (size_t i = 0; i < images.size(); i++)
+        views[i] = yolo26_image_from_mat(images[i]);
+    return detect_batch(views, objects);
+}
+
+bool Yolo26Seg::detect_batch(const std::vector<Yolo26Image>& images, std::vector<std::vector<Yolo26SegObject>>& objects) const
+{
+    // resize, not assign: entries keep their capacity across batches.
+    objects.resize(images.size());
+    if (images.empty())
+        return true;
+
+    const int n = (int)images.size();
+    const int cores = std::max(1, ncnn::get_big_cpu_count());
+    const int workers = std::min(n, config_.batch_workers > 0 ? config_.batch_workers : cores);
+    // Split the cores between the images in flight unless the caller fixed the ncnn thread count.
+    const int threads = config_.num_threads > 0 ? config_.num_threads : std::max(1, cores / workers);
+
+    std::atomic<bool> ok(true);
+    auto run = [&](int i) {
+        // Tiled images go through detect() and spread over the tile pool instead.
+        const bool done = config_.tiled ? detect(images[i], objects[i]) : detect_once(images[i], threads, objects[i], yolo26::thread_workspace());
+        if (!done)
+        {
+            objects[i].clear();
+            ok = false;
+        }
+    };
+
+    if (workers <= 1 || !batch_pool_)
+    {
+        for (int i = 0; i < n; i++)
+            run(i);
+    }
+    else
+    {
+        batch_pool_->parallel_for(n, workers, run);
+    }
+    return ok;
+}
+
+bool Yolo26Seg::detect_async(const Yolo26Image& image, Yolo26SegAsyncCallback callback) const
+{
+    return yolo26::submit_detect<Yolo26SegAsyncResult>(
+        async_.get(), image, cv::Mat(), callback, [this](const Yolo26Image& img, std::vector<Yolo26SegObject>& objects) {
+            return detect(img, objects);
+        });
+}
+
+bool Yolo26Seg::detect_async(const cv::Mat& bgr, Yolo26SegAsyncCallback callback) const
+{
+    return yolo26::submit_detect<Yolo26SegAsyncResult>(
+        async_.get(), yolo26_image_from_mat(bgr), bgr, callback, [this](const Yolo26Image& img, std::vector<Yolo26SegObject>& objects) {
+            return detect(img, objects);
+        });
+}
+
+std::future<Yolo26SegAsyncResult> Yolo26Seg::detect_async(const cv::Mat& bgr) const
+{
+    std::shared_ptr<std::promise<Yolo26SegAsyncResult>> promise = std::make_shared<std::promise<Yolo26SegAsyncResult>>();
+    std::future<Yolo26SegAsyncResult> future = promise->get_future();
+    if (!detect_async(bgr, [promise](Yolo26SegAsyncResult& result) { promise->set_value(std::move(result)); }))
+        return std::future<Yolo26SegAsyncResult>();
+    return future;
+}
+
+bool Yolo26Seg::prepare(const Yolo26Image& image, Yolo26PreparedInput& prepared) const
+{
+    Yolo26Image src;
+    if (!yolo26::resolve_image(image, src))
+        return false;
+
+    const std::shared_ptr<yolo26::LetterBoxPlan> plan = letterbox_plan(src.width, src.height);
+    if (!plan)
+        return false;
+
+    const yolo26::LetterBoxInfo& info = plan->info();
+    prepared.input.create(info.input_w, info.input_h, 3);
+    if (prepared.input.empty())
+        return false;
+
+    // Only the row scratch of the lease is used; the tensor is owned by `prepared`.
+    yolo26::LetterBoxPlan::Lease lease(*plan);
+    plan->run(src, config_.padding_value, prepared.input, lease.rows(), config_.raw_bgr_input);
+    prepared.info = info;
+    prepared.info.src_scale_x = src.orig_width / (float)src.width;
+    prepared.info.src_scale_y = src.orig_height / (float)src.height;
+    prepared.src_w = src.width;
+    prepared.src_h = src.height;
+    prepared.img_w = src.orig_width;
+    prepared.img_h = src.orig_height;
+    prepared.padding_value = config_.padding_value;
+    prepared.raw_bgr = config_.raw_bgr_input;
+    return true;
+}
+
+bool Yolo26Seg::detect(const Yolo26PreparedInput& prepared, std::vector<Yolo26SegObject>& objects) const
+{
+    if (prepared.input.empty() || prepared.src_w <= 0 || prepared.src_h <= 0)
+        return false;
+
+    const std::shared_ptr<yolo26::LetterBoxPlan> plan = letterbox_plan(prepared.src_w, prepared.src_h);
+    if (!plan)
+        return false;
+
+    yolo26::LetterBoxInfo lb = plan->info();
+    lb.src_scale_x = prepared.info.src_scale_x;
+    lb.src_scale_y = prepared.info.src_scale_y;
+    if (yolo26::prepared_matches(prepared, lb, config_.padding_value, config_.raw_bgr_input))
+        return infer(prepared.input, lb, prepared.img_w, prepared.img_h, 0, objects, yolo26::thread_workspace());
+
+    // Another model prepared the frame for a different input: resample its letterboxed content
+    // instead of reading the source again.
+    yolo26::LetterBoxPlan::Lease lease(*plan);
+    if (!yolo26::resample_input(prepared, *plan, config_.padding_value, config_.raw_bgr_input, lease.input()))
+        return false;
+    return infer(lease.input(), lb, prepared.img_w, prepared.img_h, 0, objects, yolo26::thread_workspace());
+}
+
+bool Yolo26Seg::infer(const ncnn::Mat& in_pad,
+                      const yolo26::LetterBoxInfo& lb,
+                      int img_w,
+                      int img_h,
+                      int num_threads,
+                      std::vector<Yolo26SegObject>& objects,
+                      Yolo26Workspace& workspace,
+                      const Yolo26SegObjectCallback* stream) const
+{
+    if (config_.memory_budget_bytes == 0)
+        return infer_within(in_pad, lb, img_w, img_h, num_threads, objects, workspace, stream, 0);
+
+    // Masks of the previous frame go first: reusing them would hold memory the budget cannot see.
+    if (!stream)
+        objects.clear();
+    yolo26::MemoryBudget budget(config_.memory_budget_bytes);
+    const bool ok = infer_within(in_pad, lb, img_w, img_h, num_threads, objects, workspace, stream, &budget);
+    memory_->record(budget);
+    if (!ok && !stream)
+        objects.clear();
+    return ok;
+}
+
+bool Yolo26Seg::infer_within(const ncnn::Mat& in_pad,
+                             const yolo26::LetterBoxInfo& lb,
+                             int img_w,
+                             int img_h,
+                             int num_threads,
+                             std::vector<Yolo26SegObject>& objects,
+                             Yolo26Workspace& workspace,
+                             const Yolo26SegObjectCallback* stream,
+                             yolo26::MemoryBudget* budget) const
+{
+    // The call runs on this snapshot to the end, even if reload() swaps the model meanwhile.
+    const std::shared_ptr<const yolo26::LoadedModel> model = model_->get();
+    if (!model)
+        return false;
+
+    // The letterboxed input and the workspace are held for the whole call. The extraction is admitted
+    // only if the peak measured for this input shape fits too; ncnn is never refused memory mid-layer.
+    Yolo26Workspace::Impl& ws = *workspace.impl_;
+    size_t extraction_peak = 0;
+    if (budget
+        && (!model->peaks.find(in_pad.w, in_pad.h, extraction_peak)
+            || !budget->charge(in_pad.total() * in_pad.elemsize + ws.capacity_bytes() + extraction_peak)))
+        return false;
+
+    // Declared before the extractor: every blob it allocates, outputs included, must be freed first.
+    yolo26::MemoryBudget extraction((size_t)-1);
+    yolo26::AllocatorPool::Lease allocators(*allocators_);
+    yolo26::BudgetAllocator budget_blobs(&extraction);
+    yolo26::BudgetAllocator budget_workspace(&extraction);
+    ncnn::Extractor ex = yolo26::create_extractor(model->net, allocators, num_threads);
+    if (budget)
+    {
+        ex.set_blob_allocator(&budget_blobs);
+        ex.set_workspace_allocator(&budget_workspace);
+    }
+    if (!model->io.input(ex, config_.input_name, in_pad))
         return false;
 
     ncnn::Mat out;
     ncnn::Mat proto;
-    if (!yolo26::ncnn_extract_out0(ex, config_.output_name, out))
+    if (!model->io.output(ex, config_.output_name, out))
         return false;
 
-    if (!yolo26::ncnn_extract_out1(ex, config_.proto_name, proto))
+    if (!model->io.proto(ex, config_.proto_name, proto))
         return false;
 
+    if (budget)
+    {
+        // Swap the reservation for what the extraction really peaked at and still holds (the outputs).
+        model->peaks.record(in_pad.w, in_pad.h, extraction.peak());
+        budget->release(extraction_peak);
+        budget->add(extraction.peak());
+        budget->release(extraction.peak() - extraction.used());
+        if (budget->exceeded())
+            return false;
+    }
+
     ncnn::Mat out_2d;
     if (!yolo26::to_mat2d(out, out_2d))
         return false;
 
-    std::vector<Yolo26SegCandidate> candidates;
+    // Candidates and their mask coefficients live in the workspace, reset here for this frame.
+    std::vector<yolo26::SegCandidate>& candidates = ws.seg_candidates;
+    std::vector<float>& coeffs = ws.coeffs;
+    std::vector<int>& heap = ws.seg_heap;
+    candidates.clear();
+    coeffs.clear();
+    heap.clear();
 
     const int det_dim = 4 + config_.num_classes;
     const int det_mask_dim = det_dim + config_.mask_dim;
     const int row_stride = 6 + config_.mask_dim;
-    const bool is_end2end_out = (out_2d.w == row_stride && out_2d.h > 0) || (out_2d.h == row_stride && out_2d.w > 0);
+    const Yolo26OutputLayout layout =
+        yolo26::resolve_output_layout(out_2d.w, out_2d.h, det_mask_dim, row_stride, model->io.layout);
+    const bool is_end2end_out = layout == Yolo26OutputLayout::End2EndRows || layout == Yolo26OutputLayout::End2EndCols;
     Yolo26PostprocessType postprocess = config_.postprocess;
     if (postprocess == Yolo26PostprocessType::Auto)
         postprocess = (config_.box_format == Yolo26BoxFormat::XYXY) ? Yolo26PostprocessType::TopK : Yolo26PostprocessType::NMS;
 
+    // Under a budget every candidate buffer is sized up front, charged before it is allocated.
+    const size_t max_det = (size_t)std::max(config_.max_det, 1);
+    const size_t cap = budget ? max_det * kBudgetCandidatesPerDet : 0;
+    if (budget)
+    {
+        const size_t rows = (size_t)((layout == Yolo26OutputLayout::ChannelMajor || layout == Yolo26OutputLayout::End2EndCols) ? out_2d.w : out_2d.h);
+        const bool topk = !is_end2end_out && postprocess == Yolo26PostprocessType::TopK;
+        const size_t k = std::min(rows, max_det);
+        const size_t n = is_end2end_out || topk ? k : std::min(rows, cap);
+        if (!yolo26::charge_reserve(candidates, n, budget) || !yolo26::charge_reserve(coeffs, n * config_.mask_dim, budget)
+            || !yolo26::charge_reserve(heap, n, budget) || !yolo26::charge_reserve(ws.seg_nms.order, n, budget)
+            || !yolo26::charge_reserve(ws.seg_nms.sorted, n, budget) || !yolo26::charge_reserve(ws.seg_nms.suppressed, n, budget)
+            || !yolo26::charge_reserve(ws.score_rows, (size_t)config_.num_classes, budget)
+            || !yolo26::charge_reserve(ws.mask_rows, (size_t)config_.mask_dim, budget))
+            return false;
+        if (topk
+            && (!yolo26::charge_reserve(ws.topk.anchor_best, rows, budget)
+                || !yolo26::charge_reserve(ws.topk.candidates, k * config_.num_classes, budget)
+                || !yolo26::charge_reserve(ws.topk.results, k, budget)))
+            return false;
+    }
+
     // Raw predictions layout: [4+nc+nm, num_anchors] i.e. (116, 8400).
     // Box format depends on export: one2many exports typically use CXCYWH, end2end-raw exports use XYXY.
-    if (out_2d.h == det_mask_dim && out_2d.w > 0)
+    if (layout == Yolo26OutputLayout::ChannelMajor)
     {
         const int num_anchors = out_2d.w;
 
@@ -113,19 +693,22 @@ bool Yolo26Seg::detect(const cv::Mat& bgr, std::vector<Yolo26SegObject>& objects
         const float* box_p2 = out_2d.row(2);
         const float* box_p3 = out_2d.row(3);
 
-        std::vector<const float*> score_rows(config_.num_classes);
+        std::vector<const float*>& score_rows = ws.score_rows;
+        score_rows.resize(config_.num_classes);
         for (int c = 0; c < config_.num_classes; c++)
             score_rows[c] = out_2d.row(4 + c);
 
-        std::vector<const float*> mask_rows(config_.mask_dim);
+        std::vector<const float*>& mask_rows = ws.mask_rows;
+        mask_rows.resize(config_.mask_dim);
         for (int m = 0; m < config_.mask_dim; m++)
             mask_rows[m] = out_2d.row(4 + config_.num_classes + m);
 
         if (postprocess == Yolo26PostprocessType::TopK)
         {
-            const auto topk = yolo26::get_topk_index(
+            const std::vector<yolo26::TopKResult>& topk = yolo26::get_topk_index(
                 num_anchors, config_.num_classes, config_.max_det,
-                [&](int anchor, int cls) { return score_rows[cls][anchor]; });
+                [&](int anchor, int cls) { return score_rows[cls][anchor]; },
+                ws.topk);
 
             candidates.reserve(topk.size());
             for (const auto& cand : topk)
@@ -139,7 +722,7 @@ bool Yolo26Seg::detect(const cv::Mat& bgr, std::vector<Yolo26SegObject>& objects
                 const float p2 = box_p2[i];
                 const float p3 = box_p3[i];
 
-                Yolo26SegCandidate obj;
+                yolo26::SegCandidate obj;
                 if (config_.box_format == Yolo26BoxFormat::CXCYWH)
                 {
                     obj.x1 = p0 - p2 * 0.5f;
@@ -156,16 +739,16 @@ bool Yolo26Seg::detect(const cv::Mat& bgr, std::vector<Yolo26SegObject>& objects
                 }
                 obj.prob = cand.score;
                 obj.label = cand.cls;
-                obj.mask_feat.resize(config_.mask_dim);
+                obj.coeffs = (int)coeffs.size();
                 for (int m = 0; m < config_.mask_dim; m++)
-                    obj.mask_feat[m] = mask_rows[m][i];
+                    coeffs.push_back(mask_rows[m][i]);
 
-                candidates.push_back(std::move(obj));
+                candidates.push_back(obj);
             }
         }
         else
         {
-            candidates.reserve((size_t)num_anchors);
+            candidates.reserve(cap > 0 ? std::min((size_t)num_anchors, cap) : (size_t)num_anchors);
             for (int i = 0; i < num_anchors; i++)
             {
                 float best = score_rows[0][i];
@@ -187,7 +770,7 @@ bool Yolo26Seg::detect(const cv::Mat& bgr, std::vector<Yolo26SegObject>& objects
                 const float p2 = box_p2[i];
                 const float p3 = box_p3[i];
 
-                Yolo26SegCandidate obj;
+                yolo26::SegCandidate obj;
                 if (config_.box_format == Yolo26BoxFormat::CXCYWH)
                 {
                     obj.x1 = p0 - p2 * 0.5f;
@@ -204,23 +787,20 @@ bool Yolo26Seg::detect(const cv::Mat& bgr, std::vector<Yolo26SegObject>& objects
                 }
                 obj.prob = best;
                 obj.label = best_cls;
-                obj.mask_feat.resize(config_.mask_dim);
-                for (int m = 0; m < config_.mask_dim; m++)
-                    obj.mask_feat[m] = mask_rows[m][i];
-
-                candidates.push_back(std::move(obj));
+                add_candidate(candidates, coeffs, heap, cap, config_.mask_dim, obj, mask_rows[0] + i, out_2d.w);
             }
         }
     }
     // Some converters may output [num_anchors, 4+nc+nm] i.e. (8400, 116).
-    else if (out_2d.w == det_mask_dim && out_2d.h > 0)
+    else if (layout == Yolo26OutputLayout::AnchorMajor)
     {
         const int num_anchors = out_2d.h;
         if (postprocess == Yolo26PostprocessType::TopK)
         {
-            const auto topk = yolo26::get_topk_index(
+            const std::vector<yolo26::TopKResult>& topk = yolo26::get_topk_index(
                 num_anchors, config_.num_classes, config_.max_det,
-                [&](int anchor, int cls) { return out_2d.row(anchor)[4 + cls]; });
+                [&](int anchor, int cls) { return out_2d.row(anchor)[4 + cls]; },
+                ws.topk);
 
             candidates.reserve(topk.size());
             for (const auto& cand : topk)
@@ -234,7 +814,7 @@ bool Yolo26Seg::detect(const cv::Mat& bgr, std::vector<Yolo26SegObject>& objects
                 const float p2 = p[2];
                 const float p3 = p[3];
 
-                Yolo26SegCandidate obj;
+                yolo26::SegCandidate obj;
                 if (config_.box_format == Yolo26BoxFormat::CXCYWH)
                 {
                     obj.x1 = p0 - p2 * 0.5f;
@@ -251,16 +831,16 @@ bool Yolo26Seg::detect(const cv::Mat& bgr, std::vector<Yolo26SegObject>& objects
                 }
                 obj.prob = cand.score;
                 obj.label = cand.cls;
-                obj.mask_feat.resize(config_.mask_dim);
+                obj.coeffs = (int)coeffs.size();
                 const float* mask_ptr = p + 4 + config_.num_classes;
-                std::copy(mask_ptr, mask_ptr + config_.mask_dim, obj.mask_feat.begin());
+                coeffs.insert(coeffs.end(), mask_ptr, mask_ptr + config_.mask_dim);
 
-                candidates.push_back(std::move(obj));
+                candidates.push_back(obj);
             }
         }
         else
         {
-            candidates.reserve((size_t)num_anchors);
+            candidates.reserve(cap > 0 ? std::min((size_t)num_anchors, cap) : (size_t)num_anchors);
             for (int i = 0; i < num_anchors; i++)
             {
                 const float* p = out_2d.row(i);
@@ -284,7 +864,7 @@ bool Yolo26Seg::detect(const cv::Mat& bgr, std::vector<Yolo26SegObject>& objects
                 const float p2 = p[2];
                 const float p3 = p[3];
 
-                Yolo26SegCandidate obj;
+                yolo26::SegCandidate obj;
                 if (config_.box_format == Yolo26BoxFormat::CXCYWH)
                 {
                     obj.x1 = p0 - p2 * 0.5f;
@@ -301,16 +881,12 @@ bool Yolo26Seg::detect(const cv::Mat& bgr, std::vector<Yolo26SegObject>& objects
                 }
                 obj.prob = best;
                 obj.label = best_cls;
-                obj.mask_feat.resize(config_.mask_dim);
-                const float* mask_ptr = p + 4 + config_.num_classes;
-                std::copy(mask_ptr, mask_ptr + config_.mask_dim, obj.mask_feat.begin());
-
-                candidates.push_back(std::move(obj));
+                add_candidate(candidates, coeffs, heap, cap, config_.mask_dim, obj, p + 4 + config_.num_classes, 1);
             }
         }
     }
     // End-to-end export outputs (already top-k): [num_dets, 6+nm] i.e. (300, 38) with xyxy + score + cls + mask coeffs.
-    else if (out_2d.w == row_stride && out_2d.h > 0)
+    else if (layout == Yolo26OutputLayout::End2EndRows)
     {
         const int num_dets = out_2d.h;
         candidates.reserve(std::min(num_dets, config_.max_det));
@@ -321,23 +897,23 @@ bool Yolo26Seg::detect(const cv::Mat& bgr, std::vector<Yolo26SegObject>& objects
             if (score < config_.conf_threshold)
                 continue;
 
-            Yolo26SegCandidate obj;
+            yolo26::SegCandidate obj;
             obj.x1 = p[0];
             obj.y1 = p[1];
             obj.x2 = p[2];
             obj.y2 = p[3];
             obj.prob = score;
             obj.label = (int)p[5];
-            obj.mask_feat.resize(config_.mask_dim);
-            std::copy(p + 6, p + row_stride, obj.mask_feat.begin());
+            obj.coeffs = (int)coeffs.size();
+            coeffs.insert(coeffs.end(), p + 6, p + row_stride);
 
-            candidates.push_back(std::move(obj));
+            candidates.push_back(obj);
             if ((int)candidates.size() >= config_.max_det)
                 break;
         }
     }
     // Some converters may output [6+nm, num_dets] i.e. (38, 300).
-    else if (out_2d.h == row_stride && out_2d.w > 0)
+    else if (layout == Yolo26OutputLayout::End2EndCols)
     {
         const int num_dets = out_2d.w;
         const float* x1_row = out_2d.row(0);
@@ -347,7 +923,8 @@ bool Yolo26Seg::detect(const cv::Mat& bgr, std::vector<Yolo26SegObject>& objects
         const float* score_row = out_2d.row(4);
         const float* cls_row = out_2d.row(5);
 
-        std::vector<const float*> mask_rows(config_.mask_dim);
+        std::vector<const float*>& mask_rows = ws.mask_rows;
+        mask_rows.resize(config_.mask_dim);
         for (int m = 0; m < config_.mask_dim; m++)
             mask_rows[m] = out_2d.row(6 + m);
 
@@ -358,18 +935,18 @@ bool Yolo26Seg::detect(const cv::Mat& bgr, std::vector<Yolo26SegObject>& objects
             if (score < config_.conf_threshold)
                 continue;
 
-            Yolo26SegCandidate obj;
+            yolo26::SegCandidate obj;
             obj.x1 = x1_row[i];
             obj.y1 = y1_row[i];
             obj.x2 = x2_row[i];
             obj.y2 = y2_row[i];
             obj.prob = score;
             obj.label = (int)cls_row[i];
-            obj.mask_feat.resize(config_.mask_dim);
+            obj.coeffs = (int)coeffs.size();
             for (int m = 0; m < config_.mask_dim; m++)
-                obj.mask_feat[m] = mask_rows[m][i];
+                coeffs.push_back(mask_rows[m][i]);
 
-            candidates.push_back(std::move(obj));
+            candidates.push_back(obj);
             if ((int)candidates.size() >= config_.max_det)
                 break;
         }
@@ -381,38 +958,23 @@ bool Yolo26Seg::detect(const cv::Mat& bgr, std::vector<Yolo26SegObject>& objects
 
     if (!is_end2end_out && postprocess == Yolo26PostprocessType::NMS)
     {
-        candidates = yolo26::nms(candidates, config_.iou_threshold, config_.agnostic_nms);
+        yolo26::nms_inplace(candidates, config_.iou_threshold, config_.agnostic_nms, ws.seg_nms);
         if ((int)candidates.size() > config_.max_det)
             candidates.resize((size_t)config_.max_det);
     }
 
     if (postprocess == Yolo26PostprocessType::TopK && config_.topk_dedup)
     {
-        candidates = yolo26::nms(candidates, config_.iou_threshold, config_.agnostic_nms);
+        yolo26::nms_inplace(candidates, config_.iou_threshold, config_.agnostic_nms, ws.seg_nms);
         if ((int)candidates.size() > config_.max_det)
             candidates.resize((size_t)config_.max_det);
     }
 
-    objects.clear();
     if (candidates.empty())
-        return true;
-
-    const int n = (int)candidates.size();
-    ncnn::Mat mask_feat = ncnn::Mat(config_.mask_dim, n);
-    std::vector<yolo26::BoxXYXY> boxes_input;
-    boxes_input.reserve(n);
-    for (int i = 0; i < n; i++)
     {
-        const Yolo26SegCandidate& src = candidates[i];
-        yolo26::BoxXYXY box;
-        box.x1 = src.x1;
-        box.y1 = src.y1;
-        box.x2 = src.x2;
-        box.y2 = src.y2;
-        boxes_input.push_back(box);
-
-        float* mask_feat_ptr = mask_feat.row(i);
-        std::copy(src.mask_feat.begin(), src.mask_feat.end(), mask_feat_ptr);
+        if (!stream)
+            objects.clear();
+        return true;
     }
 
     // Normalize proto to CHW layout (mask_dim, mh, mw)
@@ -425,104 +987,277 @@ bool Yolo26Seg::detect(const cv::Mat& bgr, std::vector<Yolo26SegObject>& objects
     {
         if (proto.h != config_.mask_dim)
             return false;
-        const int side = (int)std::round(std::sqrt((double)proto.w));
-        if (side <= 0 || side * side != proto.w)
-            return false;
-        proto_chw = proto.reshape(side, side, proto.h);
+        // Protos are at stride 4 of the network input, which is not square in rect mode.
+        int mw = lb.input_w / 4;
+        int mh = lb.input_h / 4;
+        if (mw * mh != proto.w)
+        {
+            mw = mh = (int)std::round(std::sqrt((double)proto.w));
+            if (mw <= 0 || mw * mh != proto.w)
+                return false;
+        }
+        proto_chw = proto.reshape(mw, mh, proto.h);
     }
 
-    if (proto_chw.dims != 3 || proto_chw.c != config_.mask_dim)
+    if (proto_chw.dims != 3 || proto_chw.c != config_.mask_dim || lb.input_w <= 0 || lb.input_h <= 0)
         return false;
 
-    const bool retina_masks = config_.retina_masks;
+    const size_t proto_size = (size_t)proto_chw.w * (size_t)proto_chw.h;
+    const size_t input_size = (size_t)lb.input_w * (size_t)lb.input_h;
+    const size_t mask_bytes = (size_t)img_w * (size_t)img_h;
+    if (budget)
+    {
+        // The largest each mask plane gets for this frame.
+        yolo26::MaskScratch& m = ws.mask;
+        const size_t roi_size = config_.retina_masks ? proto_size : input_size;
+        const size_t plane_size = config_.retina_masks || proto_size == input_size ? 0 : input_size;
+        if (!yolo26::charge_reserve(m.logits, proto_size, budget) || !yolo26::charge_reserve(m.plane, plane_size, budget)
+            || !yolo26::charge_reserve(m.roi, roi_size, budget) || !yolo26::charge_reserve(m.scaled, mask_bytes, budget))
+            return false;
+        if (stream && ws.streamed.mask.total() != mask_bytes)
+        {
+            const size_t old_bytes = ws.streamed.mask.total();
+            if (!budget->charge(mask_bytes))
+                return false;
+            ws.streamed.mask.create(img_h, img_w, CV_8UC1);
+            budget->release(old_bytes);
+        }
+    }
 
-    if (retina_masks)
+    // One instance at a time through the workspace's mask planes, straight into the masks of the
+    // objects already in `objects` (the caller's previous frame), whose storage is reused. A stream
+    // gets each object as soon as it is done, in the workspace's single streamed object.
+    size_t count = 0;
+    size_t charged = 0;
+    for (const yolo26::SegCandidate& c : candidates)
     {
-        std::vector<yolo26::BoxXYXY> boxes_orig;
-        boxes_orig.reserve(n);
-        for (const auto& b : boxes_input)
+        yolo26::BoxXYXY box;
+        box.x1 = c.x1;
+        box.y1 = c.y1;
+        box.x2 = c.x2;
+        box.y2 = c.y2;
+        if (config_.retina_masks)
         {
-            float x1 = b.x1;
-            float y1 = b.y1;
-            float x2 = b.x2;
-            float y2 = b.y2;
+            float x1 = box.x1;
+            float y1 = box.y1;
+            float x2 = box.x2;
+            float y2 = box.y2;
             yolo26::scale_xyxy_inplace(x1, y1, x2, y2, img_w, img_h, lb, true);
-            yolo26::BoxXYXY box;
             box.x1 = x1;
             box.y1 = y1;
             box.x2 = x2;
             box.y2 = y2;
-            boxes_orig.push_back(box);
         }
 
-        std::vector<cv::Mat> masks_orig;
-        if (!yolo26::process_mask_native(proto_chw, mask_feat, boxes_orig, img_h, img_w, masks_orig))
+        if (!stream && count == objects.size())
+            objects.push_back(Yolo26SegObject());
+        Yolo26SegObject& obj = stream ? ws.streamed : objects[count];
+        // Each slot is charged once, when first used; a slot whose mask came out empty is taken by the
+        // next candidate without a second charge.
+        if (budget && !stream && count == charged)
+        {
+            if (!budget->charge(mask_bytes))
+                return false;
+            charged++;
+        }
+        bool empty = false;
+        const bool ok = config_.retina_masks
+                            ? yolo26::instance_mask_native(proto_chw, &coeffs[c.coeffs], box, img_h, img_w, ws.mask, obj.mask, empty)
+                            : yolo26::instance_mask(proto_chw, &coeffs[c.coeffs], box, lb.input_h, lb.input_w, img_h, img_w, ws.mask, obj.mask, empty);
+        if (!ok)
+        {
+            if (!stream)
+                objects.clear();
             return false;
+        }
+        if (empty)
+            continue;
 
-        objects.reserve((size_t)masks_orig.size());
-        for (int i = 0; i < n; i++)
+        if (!config_.retina_masks)
         {
-            if (cv::countNonZero(masks_orig[i]) <= 0)
-                continue;
-            Yolo26SegObject obj;
-            obj.x1 = boxes_orig[i].x1;
-            obj.y1 = boxes_orig[i].y1;
-            obj.x2 = boxes_orig[i].x2;
-            obj.y2 = boxes_orig[i].y2;
-            obj.label = candidates[i].label;
-            obj.prob = candidates[i].prob;
-            obj.mask = masks_orig[i];
-            objects.push_back(std::move(obj));
+            float x1 = box.x1;
+            float y1 = box.y1;
+            float x2 = box.x2;
+            float y2 = box.y2;
+            yolo26::scale_xyxy_inplace(x1, y1, x2, y2, img_w, img_h, lb, true);
+            box.x1 = x1;
+            box.y1 = y1;
+            box.x2 = x2;
+            box.y2 = y2;
         }
-        return true;
+        obj.x1 = box.x1;
+        obj.y1 = box.y1;
+        obj.x2 = box.x2;
+        obj.y2 = box.y2;
+        obj.label = c.label;
+        obj.prob = c.prob;
+        obj.mask_offset = cv::Point();
+        if (stream)
+        {
+            if (!(*stream)(obj))
+                return true;
+            continue;
+        }
+        count++;
     }
+    if (!stream)
+        objects.resize(count);
+
+    return true;
+}
 
-    std::vector<cv::Mat> masks_input;
-    if (!yolo26::process_mask(
-            proto_chw, mask_feat, boxes_input, config_.input_height, config_.input_width, true, masks_input))
+bool Yolo26Seg::detect_tiled(const Yolo26Image& src, std::vector<Yolo26SegObject>& objects) const
+{
+    const bool is_yuv = src.format == Yolo26PixelFormat::NV12 || src.format == Yolo26PixelFormat::NV21
+                        || src.format == Yolo26PixelFormat::I420;
+    const std::vector<yolo26::TileRect> tiles = yolo26::tile_grid(
+        src.width, src.height, config_.input_width, config_.input_height, config_.tile_overlap, is_yuv ? 2 : 1);
+    const int num_tiles = (int)tiles.size();
+    const int num_jobs = num_tiles + (config_.tile_full_pass ? 1 : 0);
+
+    // Split the ncnn threads between tiles in flight instead of oversubscribing the cores.
+    const int workers = std::min(num_jobs, tile_pool_->size() + 1);
+    const std::shared_ptr<const yolo26::LoadedModel> model = model_->get();
+    if (!model)
         return false;
+    const int threads = std::max(1, model->net.opt.num_threads / workers);
+
+    const int img_w = src.orig_width;
+    const int img_h = src.orig_height;
+    const float sx = img_w / (float)src.width;
+    const float sy = img_h / (float)src.height;
+
+    // Each job streams its objects (one full mask at a time, in the worker's workspace) and keeps
+    // their boxes in original coordinates with every mask cropped to its box (mask_rects).
+    std::vector<std::vector<Yolo26SegObject>> results((size_t)num_jobs);
+    std::vector<std::vector<cv::Rect>> mask_rects((size_t)num_jobs);
+    std::vector<std::vector<char>> cut((size_t)num_jobs);
+    std::vector<char> ok((size_t)num_jobs, 0);
+    tile_pool_->parallel_for(num_jobs, workers, [&](int k) {
+        yolo26::TileRect t;
+        t.w = src.width;
+        t.h = src.height;
+        Yolo26Image roi;
+        if (k < num_tiles)
+        {
+            t = tiles[k];
+            if (!yolo26::crop_image(src, t.x, t.y, t.w, t.h, roi))
+                return;
+        }
 
-    std::vector<int> keep;
-    keep.reserve(n);
-    std::vector<cv::Mat> masks_input_keep;
-    masks_input_keep.reserve((size_t)n);
-    for (int i = 0; i < n; i++)
+        // Full-pass results are already in original coordinates.
+        const float tx = k == num_tiles ? 0.f : (float)t.x;
+        const float ty = k == num_tiles ? 0.f : (float)t.y;
+        const float ox = k == num_tiles ? 1.f : sx;
+        const float oy = k == num_tiles ? 1.f : sy;
+        const Yolo26SegObjectCallback keep_box = [&](const Yolo26SegObject& found) {
+            cut[k].push_back(k < num_tiles
+                             && yolo26::tile_box_is_cut(
+                                 t, src.width, src.height, found.x1 + tx, found.y1 + ty, found.x2 + tx, found.y2 + ty));
+
+            const int mx0 = std::max(0, (int)std::floor(found.x1));
+            const int my0 = std::max(0, (int)std::floor(found.y1));
+            const int mx1 = std::min(found.mask.cols, (int)std::ceil(found.x2));
+            const int my1 = std::min(found.mask.rows, (int)std::ceil(found.y2));
+
+            Yolo26SegObject obj;
+            obj.x1 = (found.x1 + tx) * ox;
+            obj.y1 = (found.y1 + ty) * oy;
+            obj.x2 = (found.x2 + tx) * ox;
+            obj.y2 = (found.y2 + ty) * oy;
+            obj.label = found.label;
+            obj.prob = found.prob;
+
+            cv::Rect rect;
+            if (mx1 > mx0 && my1 > my0)
+            {
+                rect.x = std::max(0, (int)std::floor((mx0 + tx) * ox));
+                rect.y = std::max(0, (int)std::floor((my0 + ty) * oy));
+                rect.width = std::min(img_w, (int)std::ceil((mx1 + tx) * ox)) - rect.x;
+                rect.height = std::min(img_h, (int)std::ceil((my1 + ty) * oy)) - rect.y;
+                const cv::Mat box_mask = found.mask(cv::Rect(mx0, my0, mx1 - mx0, my1 - my0));
+                if (rect.width <= 0 || rect.height <= 0)
+                    rect = cv::Rect();
+                else if (box_mask.cols != rect.width || box_mask.rows != rect.height)
+                    cv::resize(box_mask, obj.mask, rect.size(), 0, 0, cv::INTER_NEAREST);
+                else
+                    obj.mask = box_mask.clone();
+            }
+            results[k].push_back(std::move(obj));
+            mask_rects[k].push_back(rect);
+            return true;
+        };
+
+        std::vector<Yolo26SegObject> unused;
+        if (detect_once(k < num_tiles ? roi : src, threads, unused, yolo26::thread_workspace(), &keep_box))
+            ok[k] = 1;
+    });
+
+    std::vector<Yolo26SegObject> merged;
+    std::vector<cv::Rect> rects;
+    std::vector<yolo26::TileOrigin> origins;
+    for (int k = 0; k < num_jobs; k++)
     {
-        if (cv::countNonZero(masks_input[i]) <= 0)
-            continue;
-        keep.push_back(i);
-        masks_input_keep.push_back(masks_input[i]);
+        if (!ok[k])
+            return false;
+        for (size_t i = 0; i < results[k].size(); i++)
+        {
+            yolo26::TileOrigin origin;
+            origin.tile = k < num_tiles ? k : -1;
+            origin.cut = cut[k][i] != 0;
+            merged.push_back(std::move(results[k][i]));
+            rects.push_back(mask_rects[k][i]);
+            origins.push_back(origin);
+        }
+        std::vector<Yolo26SegObject>().swap(results[k]);
     }
 
-    std::vector<cv::Mat> masks_orig;
-    if (!yolo26::scale_masks(masks_input_keep, img_h, img_w, masks_orig, true))
-        return false;
+    // A cut box counts as the same object when 60% of it lies inside a box from another window.
+    std::vector<int> absorbed_by;
+    std::vector<int> keep = yolo26::merge_tiles(
+        merged, origins, config_.iou_threshold, 0.6f, config_.agnostic_nms, absorbed_by);
+    if ((int)keep.size() > config_.max_det)
+        keep.resize((size_t)config_.max_det);
+
+    // Stitch: each kept object's mask covers the bounds of its own crop and those it absorbed, placed
+    // at mask_offset in the image, and is the union of those crops.
+    std::vector<int> slot(merged.size(), -1);
+    std::vector<cv::Rect> bounds(keep.size());
+    for (size_t s = 0; s < keep.size(); s++)
+        slot[keep[s]] = (int)s;
+    for (size_t j = 0; j < merged.size(); j++)
+    {
+        const int s = slot[absorbed_by[j]];
+        if (s >= 0)
+            bounds[s] |= rects[j];
+    }
 
+    objects.clear();
     objects.reserve(keep.size());
-    for (size_t j = 0; j < keep.size(); j++)
+    for (size_t s = 0; s < keep.size(); s++)
     {
-        const int i = keep[j];
+        const Yolo26SegObject& kept = merged[keep[s]];
         Yolo26SegObject obj;
-        obj.x1 = candidates[i].x1;
-        obj.y1 = candidates[i].y1;
-        obj.x2 = candidates[i].x2;
-        obj.y2 = candidates[i].y2;
-        obj.label = candidates[i].label;
-        obj.prob = candidates[i].prob;
-
-        float x1 = obj.x1;
-        float y1 = obj.y1;
-        float x2 = obj.x2;
-        float y2 = obj.y2;
-        yolo26::scale_xyxy_inplace(x1, y1, x2, y2, img_w, img_h, lb, true);
-        obj.x1 = x1;
-        obj.y1 = y1;
-        obj.x2 = x2;
-        obj.y2 = y2;
-
-        obj.mask = masks_orig[j];
+        obj.x1 = kept.x1;
+        obj.y1 = kept.y1;
+        obj.x2 = kept.x2;
+        obj.y2 = kept.y2;
+        obj.label = kept.label;
+        obj.prob = kept.prob;
+        if (!bounds[s].empty())
+        {
+            obj.mask = cv::Mat::zeros(bounds[s].size(), CV_8UC1);
+            obj.mask_offset = bounds[s].tl();
+        }
         objects.push_back(std::move(obj));
     }
-
+    for (size_t j = 0; j < merged.size(); j++)
+    {
+        const int s = slot[absorbed_by[j]];
+        if (s < 0 || merged[j].mask.empty())
+            continue;
+        cv::Mat dst = objects[s].mask(rects[j] - bounds[s].tl());
+        cv::bitwise_or(dst, merged[j].mask, dst);
+    }
     return true;
 }
@@ -1,6 +1,7 @@
 #include "yolo26_draw.h"
 #include "yolo26_seg.h"
 #include "yolo26_cli.h"
+#include "yolo26_io.h"
 
 #include <opencv2/imgcodecs/imgcodecs.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
@@ -21,29 +22,54 @@ static void print_usage(const char* prog)
                  "  --box <cxcywh|xyxy>       Box format for raw outputs\n"
                  "  --dedup                  Apply IoU de-dup after TopK\n"
                  "  --agnostic               Class-agnostic NMS\n"
+                 "  --rect                   Minimal padding (stride-32 shapes, dynamic-shape export)\n"
+                 "  --full-decode            Always decode the image at full resolution\n"
+                 "  --raw-bgr                Model exported with --fold-preprocess (raw BGR input)\n"
+                 "  --tile                   Tiled inference with overlapping input-sized tiles\n"
                  "  --retina                 Use retina masks path\n"
+                 "  --budget-mb <int>        Memory budget per call (light mode, fp16, capped candidates)\n"
+                 "  --stream                 Draw each mask as it is produced instead of collecting them\n"
                  "  --gpu                    Enable Vulkan (if available)\n",
                  prog);
 }
 
-static void draw_segmentation(cv::Mat& bgr, const std::vector<Yolo26SegObject>& objects)
+static void draw_mask(cv::Mat& bgr, const Yolo26SegObject& obj, const cv::Size& orig_size, cv::Mat& blended)
 {
     const auto& colors = yolo26_coco_colors();
-    cv::Mat blended;
+    cv::Scalar color = colors[obj.label % colors.size()];
 
-    for (size_t i = 0; i < objects.size(); i++)
+    if (obj.mask.empty() || obj.mask.type() != CV_8UC1)
+        return;
+    // Tiled masks are cropped to their object; place them back in the image first.
+    cv::Mat mask_bin = obj.mask;
+    if (obj.mask.size() != orig_size)
+    {
+        mask_bin = cv::Mat::zeros(orig_size, CV_8UC1);
+        const cv::Rect rect = cv::Rect(obj.mask_offset, obj.mask.size()) & cv::Rect(cv::Point(), orig_size);
+        if (!rect.empty())
+        {
+            cv::Mat dst = mask_bin(rect);
+            obj.mask(rect - obj.mask_offset).copyTo(dst);
+        }
+    }
+    // Masks are at original resolution, which exceeds bgr after a reduced decode.
+    if (mask_bin.cols != bgr.cols || mask_bin.rows != bgr.rows)
     {
-        const auto& obj = objects[i];
-        cv::Scalar color = colors[obj.label % colors.size()];
+        cv::Mat resized;
+        cv::resize(mask_bin, resized, bgr.size(), 0, 0, cv::INTER_NEAREST);
+        mask_bin = resized;
+    }
 
-        if (obj.mask.empty() || obj.mask.type() != CV_8UC1)
-            continue;
-        const cv::Mat& mask_bin = obj.mask;
+    cv::Mat color_img(bgr.size(), bgr.type(), color);
+    cv::addWeighted(color_img, 0.5, bgr, 0.5, 0, blended);
+    blended.copyTo(bgr, mask_bin);
+}
 
-        cv::Mat color_img(bgr.size(), bgr.type(), color);
-        cv::addWeighted(color_img, 0.5, bgr, 0.5, 0, blended);
-        blended.copyTo(bgr, mask_bin);
-    }
+static void draw_segmentation(cv::Mat& bgr, const std::vector<Yolo26SegObject>& objects, const cv::Size& orig_size)
+{
+    cv::Mat blended;
+    for (size_t i = 0; i < objects.size(); i++)
+        draw_mask(bgr, objects[i], orig_size, blended);
 }
 
 int main(int argc, char** argv)
@@ -62,14 +88,10 @@ int main(int argc, char** argv)
     if (argi < argc && !yolo26_cli::starts_with(argv[argi], "--"))
         output_path = argv[argi++];
 
-    cv::Mat bgr = cv::imread(image_path, cv::IMREAD_COLOR);
-    if (bgr.empty())
-    {
-        std::fprintf(stderr, "Failed to read image: %s\n", image_path.c_str());
-        return 1;
-    }
-
     Yolo26SegConfig config;
+    bool full_decode = false;
+    bool stream = false;
+    int budget_mb = 0;
     while (argi < argc)
     {
         const std::string arg = argv[argi++];
@@ -77,6 +99,32 @@ int main(int argc, char** argv)
         {
             config.retina_masks = true;
         }
+        else if (arg == "--rect")
+        {
+            config.rect = true;
+        }
+        else if (arg == "--full-decode")
+        {
+            full_decode = true;
+        }
+        else if (arg == "--raw-bgr")
+        {
+            config.raw_bgr_input = true;
+        }
+        else if (arg == "--tile")
+        {
+            config.tiled = true;
+        }
+        else if (arg == "--stream")
+        {
+            stream = true;
+        }
+        else if (arg == "--budget-mb" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], budget_mb) || budget_mb < 0)
+                return (print_usage(argv[0]), 1);
+            config.memory_budget_bytes = (size_t)budget_mb << 20;
+        }
         else if (!yolo26_cli::parse_common_arg(arg,
                                                argc,
                                                argv,
@@ -92,6 +140,21 @@ int main(int argc, char** argv)
             return (print_usage(argv[0]), 1);
     }
 
+    // Large JPEGs are decoded at 1/2..1/8 scale; results still come back in original coordinates.
+    int orig_w = 0;
+    int orig_h = 0;
+    cv::Mat bgr = full_decode ? cv::imread(image_path, cv::IMREAD_COLOR)
+                              : yolo26_imread(image_path, config.input_width, config.input_height, &orig_w, &orig_h);
+    if (bgr.empty())
+    {
+        std::fprintf(stderr, "Failed to read image: %s\n", image_path.c_str());
+        return 1;
+    }
+    Yolo26Image image = yolo26_image_from_mat(bgr);
+    image.orig_width = orig_w;
+    image.orig_height = orig_h;
+    const cv::Size orig_size = orig_w > 0 ? cv::Size(orig_w, orig_h) : bgr.size();
+
     Yolo26Seg detector(config);
     if (!detector.load(param_path, bin_path))
     {
@@ -100,22 +163,60 @@ int main(int argc, char** argv)
     }
 
     std::vector<Yolo26SegObject> objects;
-    if (!detector.detect(bgr, objects))
+    if (stream)
     {
-        std::fprintf(stderr, "Segmentation failed\n");
-        return 1;
+        // Masks are drawn as they come; only the boxes are kept.
+        Yolo26Workspace workspace;
+        cv::Mat blended;
+        const bool ok = detector.detect_stream(image,
+                                               [&](const Yolo26SegObject& obj) {
+                                                   draw_mask(bgr, obj, orig_size, blended);
+                                                   Yolo26SegObject box = obj;
+                                                   box.mask = cv::Mat();
+                                                   objects.push_back(box);
+                                                   return true;
+                                               },
+                                               workspace);
+        if (!ok)
+        {
+            std::fprintf(stderr, "Segmentation failed\n");
+            return 1;
+        }
+    }
+    else
+    {
+        if (!detector.detect(image, objects))
+        {
+            std::fprintf(stderr, "Segmentation failed\n");
+            return 1;
+        }
+        draw_segmentation(bgr, objects, orig_size);
+    }
+    if (config.memory_budget_bytes > 0)
+    {
+        const Yolo26MemoryStats mem = detector.memory_stats();
+        std::fprintf(stdout,
+                     "Memory: peak %.1f MB of %.1f MB budget%s\n",
+                     mem.max_peak_bytes / 1048576.0,
+                     mem.budget_bytes / 1048576.0,
+                     mem.rejected > 0 ? " (over budget)" : "");
+    }
+    float sx = 1.f;
+    float sy = 1.f;
+    if (orig_w > 0 && orig_h > 0)
+    {
+        sx = bgr.cols / (float)orig_w;
+        sy = bgr.rows / (float)orig_h;
     }
-
-    draw_segmentation(bgr, objects);
     std::vector<Yolo26Object> det_objects;
     det_objects.reserve(objects.size());
     for (const auto& obj : objects)
     {
         Yolo26Object det;
-        det.x1 = obj.x1;
-        det.y1 = obj.y1;
-        det.x2 = obj.x2;
-        det.y2 = obj.y2;
+        det.x1 = obj.x1 * sx;
+        det.y1 = obj.y1 * sy;
+        det.x2 = obj.x2 * sx;
+        det.y2 = obj.y2 * sy;
         det.label = obj.label;
         det.prob = obj.prob;
         det_objects.push_back(det);
@@ -0,0 +1,218 @@
+#include "yolo26_sharded.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "cpu.h"
+
+#include "yolo26_mapped_file.h"
+#include "yolo26_thread_pool.h"
+
+namespace {
+
+// Big cores in id order; all cores when ncnn cannot tell them apart.
+std::vector<int> big_cpus()
+{
+    const ncnn::CpuSet& big = ncnn::get_cpu_thread_affinity_mask(2);
+    std::vector<int> cpus;
+    for (int i = 0; i < ncnn::get_cpu_count(); i++)
+    {
+        if (big.is_enabled(i))
+            cpus.push_back(i);
+    }
+    if (cpus.empty())
+    {
+        for (int i = 0; i < ncnn::get_cpu_count(); i++)
+            cpus.push_back(i);
+    }
+    return cpus;
+}
+
+}  // namespace
+
+struct Yolo26Sharded::Shard {
+    explicit Shard(const Yolo26Config& config)
+        : detector(config),
+          thread(1)
+    {
+    }
+
+    // Runs fn on the shard's dispatch thread and waits for its result.
+    template <typename Fn>
+    bool run(const Fn& fn)
+    {
+        struct Call {
+            std::mutex mutex;
+            std::condition_variable cond;
+            bool done = false;
+            bool ok = false;
+        } call;
+
+        thread.submit([&call, &fn]() {
+            const bool ok = fn();
+            std::lock_guard<std::mutex> lock(call.mutex);
+            call.ok = ok;
+            call.done = true;
+            call.cond.notify_one();
+        });
+
+        std::unique_lock<std::mutex> lock(call.mutex);
+        call.cond.wait(lock, [&call] { return call.done; });
+        return call.ok;
+    }
+
+    Yolo26 detector;
+    yolo26::ThreadPool thread;  // joined before the detector goes away
+    std::atomic<int> in_flight{0};
+};
+
+Yolo26Sharded::Yolo26Sharded(const Yolo26ShardedConfig& config)
+    : config_(config)
+{
+}
+
+Yolo26Sharded::~Yolo26Sharded() = default;
+
+bool Yolo26Sharded::load(const std::string& param_path, const std::string& bin_path)
+{
+    bin_ = yolo26::MappedFile::open(bin_path);
+    if (!bin_ || !yolo26::read_text_file(param_path, param_))
+        return false;
+    tuning_.clear();
+
+    const int cores = std::max(1, ncnn::get_big_cpu_count());
+    if (config_.shards > 0)
+    {
+        const int threads = config_.threads_per_shard > 0 ? config_.threads_per_shard : std::max(1, cores / config_.shards);
+        return start(config_.shards, threads);
+    }
+
+    Yolo26ShardLayout best;
+    for (int k = 1; k <= cores; k++)
+    {
+        if (config_.threads_per_shard > 0 && k != config_.threads_per_shard)
+            continue;
+        const int n = std::max(1, cores / k);
+        if (cores % k != 0 || n > std::max(1, config_.max_shards))
+            continue;
+        if (!start(n, k))
+            return false;
+
+        Yolo26ShardLayout tried = layout_;
+        tried.fps = measure(config_.tune_seconds);
+        tuning_.push_back(tried);
+        if (tried.fps > best.fps)
+            best = tried;
+    }
+    if (best.shards == 0)
+        return start(std::max(1, cores / std::max(1, config_.threads_per_shard)), std::max(1, config_.threads_per_shard));
+
+    if (best.shards != layout_.shards || best.threads_per_shard != layout_.threads_per_shard)
+    {
+        if (!start(best.shards, best.threads_per_shard))
+            return false;
+    }
+    layout_ = best;
+    return true;
+}
+
+bool Yolo26Sharded::start(int shards, int threads_per_shard)
+{
+    shards_.clear();
+    layout_ = Yolo26ShardLayout();
+
+    Yolo26Config config = config_.detector;
+    config.num_threads = threads_per_shard;
+    const std::vector<int> cpus = big_cpus();
+
+    for (int i = 0; i < shards; i++)
+    {
+        std::unique_ptr<Shard> shard(new Shard(config));
+        if (!shard->detector.load_memory(param_.c_str(), bin_->data()))
+            return false;
+
+        // ncnn binds the OpenMP team of the calling thread, i.e. this shard's dispatch thread.
+        if (config_.pin_threads && (size_t)((i + 1) * threads_per_shard) <= cpus.size())
+        {
+            ncnn::CpuSet mask;
+            mask.disable_all();
+            for (int j = 0; j < threads_per_shard; j++)
+                mask.enable(cpus[i * threads_per_shard + j]);
+            shard->run([&mask]() { return ncnn::set_cpu_thread_affinity(mask) == 0; });
+        }
+
+        Shard* s = shard.get();
+        const int w = config.input_width;
+        const int h = config.input_height;
+        if (!s->run([s, w, h]() { return s->detector.warmup(w, h); }))
+            return false;
+        shards_.push_back(std::move(shard));
+    }
+
+    layout_.shards = shards;
+    layout_.threads_per_shard = threads_per_shard;
+    return true;
+}
+
+double Yolo26Sharded::measure(double seconds) const
+{
+    const int w = config_.detector.input_width;
+    const int h = config_.detector.input_height;
+    const std::vector<unsigned char> blank((size_t)w * h * 3, (unsigned char)config_.detector.padding_value);
+    Yolo26Image image;
+    image.data = blank.data();
+    image.width = w;
+    image.height = h;
+
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point begin = Clock::now();
+    const Clock::time_point end = begin + std::chrono::microseconds((long long)(std::max(0.05, seconds) * 1e6));
+
+    // Two callers per shard keep every queue non-empty.
+    std::atomic<long> frames(0);
+    std::vector<std::thread> callers;
+    for (size_t i = 0; i < shards_.size() * 2; i++)
+    {
+        callers.emplace_back([&]() {
+            std::vector<Yolo26Object> objects;
+            while (Clock::now() < end && detect(image, objects))
+                frames++;
+        });
+    }
+    for (auto& t : callers)
+        t.join();
+
+    const double elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+    return elapsed > 0.0 ? frames / elapsed : 0.0;
+}
+
+bool Yolo26Sharded::detect(const cv::Mat& bgr, std::vector<Yolo26Object>& objects) const
+{
+    return detect(yolo26_image_from_mat(bgr), objects);
+}
+
+bool Yolo26Sharded::detect(const Yolo26Image& image, std::vector<Yolo26Object>& objects) const
+{
+    objects.clear();
+    if (shards_.empty())
+        return false;
+
+    // Least loaded, ties broken round-robin so idle shards take turns.
+    const size_t n = shards_.size();
+    const size_t first = next_shard_++ % n;
+    Shard* shard = shards_[first].get();
+    for (size_t i = 1; i < n && shard->in_flight > 0; i++)
+    {
+        Shard* s = shards_[(first + i) % n].get();
+        if (s->in_flight < shard->in_flight)
+            shard = s;
+    }
+
+    shard->in_flight++;
+    const bool ok = shard->run([shard, &image, &objects]() { return shard->detector.detect(image, objects); });
+    shard->in_flight--;
+    return ok;
+}
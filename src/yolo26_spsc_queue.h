@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace yolo26 {
+
+// Bounded single-producer / single-consumer ring. Lock-free: one thread may call try_push while
+// another calls try_pop; neither ever blocks on the other.
+template <typename T>
+class SpscQueue {
+public:
+    typedef T value_type;
+
+    explicit SpscQueue(size_t capacity)
+        : slots_(capacity + 1)
+    {
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    bool try_push(const T& value)
+    {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t next = (tail + 1) % slots_.size();
+        if (next == head_.load(std::memory_order_acquire))
+            return false;
+        slots_[tail] = value;
+        tail_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T& value)
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire))
+            return false;
+        value = slots_[head];
+        head_.store((head + 1) % slots_.size(), std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::vector<T> slots_;
+    // Written by the consumer / producer only; padded onto separate cache lines (heap objects, so no
+    // alignas: C++11 new ignores extended alignment).
+    char pad0_[64];
+    std::atomic<size_t> head_{0};
+    char pad1_[64];
+    std::atomic<size_t> tail_{0};
+    char pad2_[64];
+};
+
+// Waiting side of a lock-free stage: spin briefly, then yield, then sleep in short steps so an idle
+// stage does not steal cores from ncnn.
+class Backoff {
+public:
+    void wait()
+    {
+        if (count_ >= 128)
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        else if (count_ >= 64)
+            std::this_thread::yield();
+        count_++;
+    }
+
+    void reset() { count_ = 0; }
+
+private:
+    int count_ = 0;
+};
+
+}  // namespace yolo26
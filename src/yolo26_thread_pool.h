@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace yolo26 {
+
+// Fixed set of worker threads draining a FIFO of tasks.
+class ThreadPool {
+public:
+    explicit ThreadPool(int num_threads)
+    {
+        for (int i = 0; i < num_threads; i++)
+            threads_.emplace_back([this] { worker(); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cond_.notify_all();
+        for (auto& t : threads_)
+            t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return (int)threads_.size(); }
+
+    void submit(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push_back(std::move(task));
+        }
+        cond_.notify_one();
+    }
+
+    // Runs fn(0) .. fn(n - 1) on up to `max_workers` threads (the caller included) and returns once all
+    // have finished. Indices are handed out one at a time, so each worker holds a single item in flight.
+    // Safe to call concurrently and from a pool thread; the caller always makes progress itself.
+    void parallel_for(int n, int max_workers, const std::function<void(int)>& fn)
+    {
+        if (n <= 0)
+            return;
+
+        struct State {
+            std::atomic<int> next{0};
+            int running = 0;
+            std::mutex mutex;
+            std::condition_variable done;
+        };
+        std::shared_ptr<State> state = std::make_shared<State>();
+        const std::function<void(int)>* body = &fn;
+
+        auto drain = [state, n, body]() {
+            for (int i = state->next++; i < n; i = state->next++)
+                (*body)(i);
+        };
+
+        const int helpers = std::min(std::min(n, std::max(1, max_workers)) - 1, size());
+        state->running = helpers;
+        for (int i = 0; i < helpers; i++)
+        {
+            submit([state, drain]() {
+                drain();
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (--state->running == 0)
+                    state->done.notify_all();
+            });
+        }
+
+        drain();
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->done.wait(lock, [&state] { return state->running == 0; });
+    }
+
+private:
+    void worker()
+    {
+        for (;;)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cond_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+                if (stop_ && tasks_.empty())
+                    return;
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::deque<std::function<void()>> tasks_;
+    bool stop_ = false;
+};
+
+}  // namespace yolo26
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "yolo26_nms.h"
+
+namespace yolo26 {
+
+struct TileRect {
+    int x = 0;
+    int y = 0;
+    int w = 0;
+    int h = 0;
+};
+
+// Overlapping tile_w x tile_h windows covering img_w x img_h. The last row / column is shifted back
+// to end at the image border instead of running past it; a side smaller than the tile gets a single
+// window spanning it. Origins are rounded down to a multiple of `align` (2 for subsampled YUV); the
+// last row / column then grows by what the rounding took, so it still ends at the border.
+inline std::vector<TileRect> tile_grid(int img_w, int img_h, int tile_w, int tile_h, float overlap, int align = 1)
+{
+    std::vector<TileRect> tiles;
+    if (img_w <= 0 || img_h <= 0 || tile_w <= 0 || tile_h <= 0)
+        return tiles;
+
+    overlap = std::max(0.f, std::min(overlap, 0.9f));
+    align = std::max(1, align);
+
+    auto origins = [&](int size, int tile) {
+        std::vector<int> o;
+        if (size <= tile)
+        {
+            o.push_back(0);
+            return o;
+        }
+        const int step = std::max(1, (int)std::floor(tile * (1.f - overlap)));
+        for (int p = 0;; p += step)
+        {
+            // Aligning can round an origin onto the previous one; that window would run twice.
+            const int q = std::min(p, size - tile) / align * align;
+            if (o.empty() || q != o.back())
+                o.push_back(q);
+            if (p + tile >= size)
+                break;
+        }
+        return o;
+    };
+
+    const std::vector<int> xs = origins(img_w, tile_w);
+    const std::vector<int> ys = origins(img_h, tile_h);
+    tiles.reserve(xs.size() * ys.size());
+    for (int y : ys)
+    {
+        for (int x : xs)
+        {
+            TileRect t;
+            t.x = x;
+            t.y = y;
+            t.w = x == xs.back() ? img_w - x : tile_w;
+            t.h = y == ys.back() ? img_h - y : tile_h;
+            tiles.push_back(t);
+        }
+    }
+    return tiles;
+}
+
+// Where a detection came from: tile index (-1 for a full-image pass) and whether its box touches an
+// edge of the tile that lies inside the image, i.e. the object is probably cut off there.
+struct TileOrigin {
+    int tile = -1;
+    bool cut = false;
+};
+
+inline bool tile_box_is_cut(const TileRect& t, int img_w, int img_h, float x1, float y1, float x2, float y2)
+{
+    const float margin = 2.f;
+    return (t.x > 0 && x1 <= t.x + margin) || (t.y > 0 && y1 <= t.y + margin)
+           || (t.x + t.w < img_w && x2 >= t.x + t.w - margin) || (t.y + t.h < img_h && y2 >= t.y + t.h - margin);
+}
+
+// Cross-tile NMS over detections already in original image coordinates. Besides the usual IoU test, a
+// box cut by a tile edge is merged into an overlapping box from another window when it is mostly
+// contained in it (intersection over the smaller area > ios_threshold); the kept box then grows to
+// the union so objects split across tiles come back whole.
+// Returns the kept indices in descending score order; absorbed_by[j] is the kept index that
+// suppressed j (or j itself when kept), so callers can stitch per-tile masks.
+template <typename Object>
+std::vector<int> merge_tiles(std::vector<Object>& objects,
+                             const std::vector<TileOrigin>& origins,
+                             float iou_threshold,
+                             float ios_threshold,
+                             bool agnostic,
+                             std::vector<int>& absorbed_by)
+{
+    const int n = (int)objects.size();
+    std::vector<int> order(n);
+    for (int i = 0; i < n; i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&objects](int a, int b) { return objects[a].prob > objects[b].prob; });
+
+    absorbed_by.assign(n, -1);
+    std::vector<int> keep;
+    std::vector<bool> cut(n);
+    for (int i = 0; i < n; i++)
+        cut[i] = origins[i].cut;
+
+    for (int oi = 0; oi < n; oi++)
+    {
+        const int i = order[oi];
+        if (absorbed_by[i] >= 0)
+            continue;
+        absorbed_by[i] = i;
+        keep.push_back(i);
+
+        Object& a = objects[i];
+        for (int oj = oi + 1; oj < n; oj++)
+        {
+            const int j = order[oj];
+            if (absorbed_by[j] >= 0)
+                continue;
+            const Object& b = objects[j];
+            if (!agnostic && a.label != b.label)
+                continue;
+
+            bool merge = compute_iou(a.x1, a.y1, a.x2, a.y2, b.x1, b.y1, b.x2, b.y2) > iou_threshold;
+            bool grow = false;
+            if (!merge && (cut[i] || cut[j]) && origins[i].tile != origins[j].tile)
+            {
+                const float iw = std::min(a.x2, b.x2) - std::max(a.x1, b.x1);
+                const float ih = std::min(a.y2, b.y2) - std::max(a.y1, b.y1);
+                const float smaller = std::min((a.x2 - a.x1) * (a.y2 - a.y1), (b.x2 - b.x1) * (b.y2 - b.y1));
+                merge = iw > 0.f && ih > 0.f && smaller > 0.f && iw * ih / smaller > ios_threshold;
+                grow = merge;
+            }
+            if (!merge)
+                continue;
+
+            absorbed_by[j] = i;
+            if (grow)
+            {
+                a.x1 = std::min(a.x1, b.x1);
+                a.y1 = std::min(a.y1, b.y1);
+                a.x2 = std::max(a.x2, b.x2);
+                a.y2 = std::max(a.y2, b.y2);
+                cut[i] = cut[i] && cut[j];
+            }
+        }
+    }
+    return keep;
+}
+
+}  // namespace yolo26
@@ -11,20 +11,36 @@ struct TopKResult {
     int anchor = -1;
 };
 
+// Buffers of get_topk_index(); reused across calls they stop allocating once grown.
+struct TopKScratch {
+    struct AnchorBest {
+        float score;
+        int anchor;
+    };
+    struct Candidate {
+        float score;
+        int cls;
+        int anchor;
+        int flat_index;
+    };
+
+    std::vector<AnchorBest> anchor_best;
+    std::vector<Candidate> candidates;
+    std::vector<TopKResult> results;
+};
+
+// Results are in scratch.results, valid until its next use.
 template <typename ScoreGetter>
-inline std::vector<TopKResult> get_topk_index(int anchors, int num_classes, int max_det, ScoreGetter get_score)
+inline const std::vector<TopKResult>& get_topk_index(int anchors, int num_classes, int max_det, ScoreGetter get_score, TopKScratch& scratch)
 {
-    std::vector<TopKResult> empty;
+    scratch.results.clear();
     if (anchors <= 0 || num_classes <= 0 || max_det <= 0)
-        return empty;
+        return scratch.results;
 
     const int k = std::max(1, std::min(max_det, anchors));
 
-    struct AnchorBest {
-        float score;
-        int anchor;
-    };
-    std::vector<AnchorBest> anchor_best;
+    std::vector<TopKScratch::AnchorBest>& anchor_best = scratch.anchor_best;
+    anchor_best.clear();
     anchor_best.reserve((size_t)anchors);
     for (int a = 0; a < anchors; a++)
     {
@@ -35,20 +51,15 @@ inline std::vector<TopKResult> get_topk_index(int anchors, int num_classes, int
     }
 
     std::partial_sort(anchor_best.begin(), anchor_best.begin() + k, anchor_best.end(),
-                      [](const AnchorBest& lhs, const AnchorBest& rhs) {
+                      [](const TopKScratch::AnchorBest& lhs, const TopKScratch::AnchorBest& rhs) {
                           if (lhs.score != rhs.score)
                               return lhs.score > rhs.score;
                           return lhs.anchor < rhs.anchor;
                       });
     anchor_best.resize(k);
 
-    struct Candidate {
-        float score;
-        int cls;
-        int anchor;
-        int flat_index;
-    };
-    std::vector<Candidate> candidates;
+    std::vector<TopKScratch::Candidate>& candidates = scratch.candidates;
+    candidates.clear();
     candidates.reserve((size_t)k * (size_t)num_classes);
 
     for (int p = 0; p < k; p++)
@@ -61,14 +72,14 @@ inline std::vector<TopKResult> get_topk_index(int anchors, int num_classes, int
     }
 
     std::partial_sort(candidates.begin(), candidates.begin() + k, candidates.end(),
-                      [](const Candidate& lhs, const Candidate& rhs) {
+                      [](const TopKScratch::Candidate& lhs, const TopKScratch::Candidate& rhs) {
                           if (lhs.score != rhs.score)
                               return lhs.score > rhs.score;
                           return lhs.flat_index < rhs.flat_index;
                       });
     candidates.resize(k);
 
-    std::vector<TopKResult> results;
+    std::vector<TopKResult>& results = scratch.results;
     results.reserve(candidates.size());
     for (const auto& cand : candidates)
     {
@@ -82,5 +93,11 @@ inline std::vector<TopKResult> get_topk_index(int anchors, int num_classes, int
     return results;
 }
 
-}  // namespace yolo26
+template <typename ScoreGetter>
+inline std::vector<TopKResult> get_topk_index(int anchors, int num_classes, int max_det, ScoreGetter get_score)
+{
+    TopKScratch scratch;
+    return get_topk_index(anchors, num_classes, max_det, get_score, scratch);
+}
 
+}  // namespace yolo26
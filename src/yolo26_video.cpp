@@ -0,0 +1,209 @@
+#include "yolo26_video.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "yolo26_nms.h"
+#include "yolo26_preprocess.h"
+
+namespace {
+
+struct CropRect {
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+};
+
+bool overlaps(const CropRect& a, const CropRect& b)
+{
+    return a.x0 < b.x1 && b.x0 < a.x1 && a.y0 < b.y1 && b.y0 < a.y1;
+}
+
+}  // namespace
+
+Yolo26VideoDetector::Yolo26VideoDetector(const Yolo26& detector, const Yolo26VideoConfig& config)
+    : detector_(detector),
+      config_(config)
+{
+}
+
+void Yolo26VideoDetector::reset()
+{
+    tracks_.clear();
+    frames_since_full_ = 0;
+    next_id_ = 0;
+    last_full_ = false;
+}
+
+bool Yolo26VideoDetector::detect(const cv::Mat& bgr, std::vector<Yolo26Object>& objects)
+{
+    return detect(yolo26_image_from_mat(bgr), objects);
+}
+
+bool Yolo26VideoDetector::detect(const Yolo26Image& frame, std::vector<Yolo26Object>& objects)
+{
+    const bool due = tracks_.empty() || frames_since_full_ + 1 >= std::max(1, config_.full_frame_interval);
+    if (!due)
+    {
+        std::vector<Yolo26Object> cropped;
+        if (detect_crops(frame, cropped) && associate(cropped, false))
+        {
+            frames_since_full_++;
+            last_full_ = false;
+            objects.swap(cropped);
+            return true;
+        }
+        // Crops too large or a track was lost: redo this frame in full.
+    }
+
+    if (!detector_.detect(frame, objects))
+        return false;
+    associate(objects, true);
+    frames_since_full_ = 0;
+    last_full_ = true;
+    return true;
+}
+
+bool Yolo26VideoDetector::detect_crops(const Yolo26Image& frame, std::vector<Yolo26Object>& objects) const
+{
+    Yolo26Image src;
+    if (!yolo26::resolve_image(frame, src))
+        return false;
+
+    // Tracks are in original coordinates; crops are cut from the (possibly reduced) view.
+    const float sx = src.width / (float)src.orig_width;
+    const float sy = src.height / (float)src.orig_height;
+    const int align = (src.format == Yolo26PixelFormat::NV12 || src.format == Yolo26PixelFormat::NV21
+                       || src.format == Yolo26PixelFormat::I420)
+                          ? 2
+                          : 1;
+
+    std::vector<CropRect> crops;
+    for (const auto& track : tracks_)
+    {
+        const Yolo26Object& b = track.object;
+        const float mw = std::max((b.x2 - b.x1) * sx * (1.f + 2.f * config_.crop_margin), (float)config_.min_crop_size);
+        const float mh = std::max((b.y2 - b.y1) * sy * (1.f + 2.f * config_.crop_margin), (float)config_.min_crop_size);
+        const float cx = (b.x1 + b.x2) * 0.5f * sx;
+        const float cy = (b.y1 + b.y2) * 0.5f * sy;
+
+        CropRect r;
+        r.x0 = std::max(0, (int)std::floor(cx - mw * 0.5f)) / align * align;
+        r.y0 = std::max(0, (int)std::floor(cy - mh * 0.5f)) / align * align;
+        r.x1 = std::min(src.width, (int)std::ceil(cx + mw * 0.5f));
+        r.y1 = std::min(src.height, (int)std::ceil(cy + mh * 0.5f));
+        if (r.x1 > r.x0 && r.y1 > r.y0)
+            crops.push_back(r);
+    }
+
+    // Overlapping crops become their bounding rect, so no object is detected twice.
+    for (bool merged = true; merged;)
+    {
+        merged = false;
+        for (size_t i = 0; i < crops.size() && !merged; i++)
+        {
+            for (size_t j = i + 1; j < crops.size(); j++)
+            {
+                if (!overlaps(crops[i], crops[j]))
+                    continue;
+                crops[i].x0 = std::min(crops[i].x0, crops[j].x0);
+                crops[i].y0 = std::min(crops[i].y0, crops[j].y0);
+                crops[i].x1 = std::max(crops[i].x1, crops[j].x1);
+                crops[i].y1 = std::max(crops[i].y1, crops[j].y1);
+                crops.erase(crops.begin() + j);
+                merged = true;
+                break;
+            }
+        }
+    }
+
+    // All crops share one mosaic canvas, i.e. one inference at the input size: never more work than
+    // the full frame. Crops covering most of the frame take the full frame instead, as do more crops
+    // than canvas cells or a crop larger than its cell (detect_regions() refuses those).
+    double area = 0.0;
+    for (const auto& r : crops)
+        area += (double)(r.x1 - r.x0) * (r.y1 - r.y0);
+    if (crops.empty() || area > config_.max_crop_area * (double)src.width * src.height)
+        return false;
+
+    std::vector<cv::Rect> regions;
+    regions.reserve(crops.size());
+    for (const auto& r : crops)
+        regions.push_back(cv::Rect(r.x0, r.y0, r.x1 - r.x0, r.y1 - r.y0));
+    return detector_.detect_regions(src, regions, objects);
+}
+
+bool Yolo26VideoDetector::associate(const std::vector<Yolo26Object>& objects, bool full_frame)
+{
+    struct Pair {
+        float iou;
+        int track;
+        int det;
+    };
+    std::vector<Pair> pairs;
+    for (int t = 0; t < (int)tracks_.size(); t++)
+    {
+        const Yolo26Object& a = tracks_[t].object;
+        for (int d = 0; d < (int)objects.size(); d++)
+        {
+            const Yolo26Object& b = objects[d];
+            if (a.label != b.label)
+                continue;
+            const float iou = yolo26::compute_iou(a.x1, a.y1, a.x2, a.y2, b.x1, b.y1, b.x2, b.y2);
+            if (iou >= config_.match_iou)
+            {
+                Pair p;
+                p.iou = iou;
+                p.track = t;
+                p.det = d;
+                pairs.push_back(p);
+            }
+        }
+    }
+    std::stable_sort(pairs.begin(), pairs.end(), [](const Pair& a, const Pair& b) { return a.iou > b.iou; });
+
+    // Greedy: best overlaps first, each track and detection used once. Tracks are only updated once
+    // the association stands, so a rejected crop pass leaves them as they were for the full frame.
+    std::vector<char> track_matched(tracks_.size(), 0);
+    std::vector<char> det_matched(objects.size(), 0);
+    std::vector<Pair> matches;
+    for (const auto& p : pairs)
+    {
+        if (track_matched[p.track] || det_matched[p.det])
+            continue;
+        track_matched[p.track] = 1;
+        det_matched[p.det] = 1;
+        matches.push_back(p);
+    }
+
+    if (!full_frame && matches.size() != tracks_.size())
+        return false;
+
+    for (const auto& m : matches)
+    {
+        tracks_[m.track].object = objects[m.det];
+        tracks_[m.track].hits++;
+    }
+
+    // A full frame is authoritative: unmatched tracks are gone, unmatched detections start new ones.
+    std::vector<Yolo26Track> next;
+    next.reserve(objects.size());
+    for (size_t t = 0; t < tracks_.size(); t++)
+    {
+        if (track_matched[t])
+            next.push_back(tracks_[t]);
+    }
+    for (size_t d = 0; d < objects.size(); d++)
+    {
+        if (det_matched[d])
+            continue;
+        Yolo26Track track;
+        track.id = next_id_++;
+        track.object = objects[d];
+        track.hits = 1;
+        next.push_back(track);
+    }
+    tracks_.swap(next);
+    return true;
+}
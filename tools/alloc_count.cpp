@@ -0,0 +1,309 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <opencv2/imgcodecs/imgcodecs.hpp>
+
+#include "net.h"
+#include "cpu.h"
+
+#include "yolo26.h"
+#include "yolo26_allocator.h"
+#include "yolo26_cli.h"
+#include "yolo26_seg.h"
+
+// Counts heap allocations made by steady-state detect() calls. glibc's malloc family is interposed
+// here and forwarded to the __libc_* entry points, so every allocation of the process (ncnn's
+// worker threads included) goes through the counter.
+#if defined(__GLIBC__)
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+}
+
+static std::atomic<long> g_allocations(0);
+
+extern "C" {
+void* malloc(size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    void* p = __libc_memalign(alignment, size);
+    if (!p)
+        return 12;  // ENOMEM
+    *ptr = p;
+    return 0;
+}
+
+void free(void* ptr)
+{
+    __libc_free(ptr);
+}
+}
+
+static long allocations()
+{
+    return g_allocations.load(std::memory_order_relaxed);
+}
+#else
+static long allocations()
+{
+    return -1;
+}
+#endif
+
+static void print_usage(const char* prog)
+{
+    std::fprintf(stderr,
+                 "Usage: %s <param> <bin> <image> [options]\n"
+                 "\n"
+                 "Heap allocations per steady-state detect() with a reused Yolo26Workspace and result\n"
+                 "vector, against a bare ncnn extraction of the same model at the same input size. ncnn\n"
+                 "allocates its per-extraction bookkeeping itself; everything above that baseline is\n"
+                 "yolo26's, and must be 0. Exits 1 otherwise.\n"
+                 "\n"
+                 "Options:\n"
+                 "  --seg                    Segmentation model (Yolo26Seg, proto blob out1)\n"
+                 "  --into                   Detection via detect_into() and max_det-sized SoA buffers\n"
+                 "  --iterations <int>       Counted frames (default 50)\n"
+                 "  --warmup <int>           Uncounted frames first (default 5)\n"
+                 "  --threads <int>          ncnn threads per detect (default: big cores)\n"
+                 "  (plus the yolo26_det options: --conf --iou --max-det --post --box --dedup --agnostic --gpu)\n",
+                 prog);
+}
+
+// Bare extraction: a second net from the same files, the same pooled allocators, a fixed input.
+static bool extract_once(const ncnn::Net& net, yolo26::AllocatorPool& pool, const ncnn::Mat& in, bool seg)
+{
+    yolo26::AllocatorPool::Lease allocators(pool);
+    ncnn::Extractor ex = yolo26::create_extractor(net, allocators);
+    if (ex.input("in0", in) != 0)
+        return false;
+    ncnn::Mat out;
+    if (ex.extract("out0", out) != 0)
+        return false;
+    if (seg)
+    {
+        ncnn::Mat proto;
+        if (ex.extract("out1", proto) != 0)
+            return false;
+    }
+    return true;
+}
+
+template<typename Frame>
+static double per_frame(Frame frame, int warmup, int iterations, bool& ok)
+{
+    ok = true;
+    for (int i = 0; i < warmup && ok; i++)
+        ok = frame();
+    const long before = allocations();
+    for (int i = 0; i < iterations && ok; i++)
+        ok = frame();
+    return (double)(allocations() - before) / iterations;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 4)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (allocations() < 0)
+    {
+        std::fprintf(stderr, "allocation counting needs glibc\n");
+        return 1;
+    }
+
+    const std::string param_path = argv[1];
+    const std::string bin_path = argv[2];
+    const std::string image_path = argv[3];
+
+    bool seg = false;
+    bool into = false;
+    int iterations = 50;
+    int warmup = 5;
+    Yolo26Config config;
+    int argi = 4;
+    while (argi < argc)
+    {
+        const std::string arg = argv[argi++];
+        if (arg == "--seg")
+        {
+            seg = true;
+        }
+        else if (arg == "--into")
+        {
+            into = true;
+        }
+        else if (arg == "--iterations" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], iterations) || iterations <= 0)
+                return (print_usage(argv[0]), 1);
+        }
+        else if (arg == "--warmup" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], warmup) || warmup < 0)
+                return (print_usage(argv[0]), 1);
+        }
+        else if (arg == "--threads" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], config.num_threads))
+                return (print_usage(argv[0]), 1);
+        }
+        else if (!yolo26_cli::parse_common_arg(arg,
+                                               argc,
+                                               argv,
+                                               argi,
+                                               config.conf_threshold,
+                                               config.iou_threshold,
+                                               config.max_det,
+                                               config.postprocess,
+                                               config.box_format,
+                                               config.topk_dedup,
+                                               config.agnostic_nms,
+                                               config.use_gpu))
+            return (print_usage(argv[0]), 1);
+    }
+
+    const cv::Mat bgr = cv::imread(image_path, cv::IMREAD_COLOR);
+    if (bgr.empty())
+    {
+        std::fprintf(stderr, "Failed to read image: %s\n", image_path.c_str());
+        return 1;
+    }
+
+    ncnn::Net net;
+    net.opt.num_threads = config.num_threads > 0 ? config.num_threads : ncnn::get_big_cpu_count();
+    if (net.load_param(param_path.c_str()) != 0 || net.load_model(bin_path.c_str()) != 0)
+    {
+        std::fprintf(stderr, "Failed to load model: %s %s\n", param_path.c_str(), bin_path.c_str());
+        return 1;
+    }
+    yolo26::AllocatorPool pool;
+    ncnn::Mat in(config.input_width, config.input_height, 3);
+    in.fill(0.5f);
+
+    bool ok = false;
+    const double baseline = per_frame([&]() { return extract_once(net, pool, in, seg); }, warmup, iterations, ok);
+    if (!ok)
+    {
+        std::fprintf(stderr, "Bare extraction failed\n");
+        return 1;
+    }
+
+    Yolo26Workspace workspace;
+    double detect = 0.0;
+    size_t count = 0;
+    if (seg)
+    {
+        Yolo26SegConfig seg_config;
+        seg_config.num_threads = config.num_threads;
+        seg_config.conf_threshold = config.conf_threshold;
+        seg_config.iou_threshold = config.iou_threshold;
+        seg_config.max_det = config.max_det;
+        seg_config.postprocess = config.postprocess;
+        seg_config.box_format = config.box_format;
+        seg_config.topk_dedup = config.topk_dedup;
+        seg_config.agnostic_nms = config.agnostic_nms;
+        seg_config.use_gpu = config.use_gpu;
+        Yolo26Seg detector(seg_config);
+        if (!detector.load(param_path, bin_path))
+        {
+            std::fprintf(stderr, "Failed to load model: %s %s\n", param_path.c_str(), bin_path.c_str());
+            return 1;
+        }
+        std::vector<Yolo26SegObject> objects;
+        detect = per_frame([&]() { return detector.detect(bgr, objects, workspace); }, warmup, iterations, ok);
+        count = objects.size();
+    }
+    else
+    {
+        Yolo26 detector(config);
+        if (!detector.load(param_path, bin_path))
+        {
+            std::fprintf(stderr, "Failed to load model: %s %s\n", param_path.c_str(), bin_path.c_str());
+            return 1;
+        }
+        if (into)
+        {
+            const size_t capacity = (size_t)std::max(config.max_det, 0);
+            std::vector<float> x1(capacity), y1(capacity), x2(capacity), y2(capacity), score(capacity);
+            std::vector<int> label(capacity);
+            Yolo26Detections out;
+            out.x1 = x1.data();
+            out.y1 = y1.data();
+            out.x2 = x2.data();
+            out.y2 = y2.data();
+            out.score = score.data();
+            out.label = label.data();
+            out.capacity = (int)capacity;
+            int n = 0;
+            detect = per_frame([&]() { return (n = detector.detect_into(bgr, out, workspace)) >= 0; }, warmup, iterations, ok);
+            count = (size_t)std::max(n, 0);
+        }
+        else
+        {
+            std::vector<Yolo26Object> objects;
+            detect = per_frame([&]() { return detector.detect(bgr, objects, workspace); }, warmup, iterations, ok);
+            count = objects.size();
+        }
+    }
+    if (!ok)
+    {
+        std::fprintf(stderr, "Detection failed\n");
+        return 1;
+    }
+
+    const double extra = detect - baseline;
+    std::fprintf(stdout,
+                 "allocations/frame: bare extraction %.2f, detect %.2f, yolo26 %.2f (%zu objects, workspace %zu bytes)\n",
+                 baseline,
+                 detect,
+                 extra,
+                 count,
+                 workspace.capacity_bytes());
+    if (extra > 0.0)
+    {
+        std::fprintf(stderr, "FAIL: steady-state detect allocates beyond the extraction itself\n");
+        return 1;
+    }
+    std::fprintf(stdout, "PASS\n");
+    return 0;
+}
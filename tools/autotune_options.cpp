@@ -0,0 +1,355 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "net.h"
+#include "cpu.h"
+
+#include "yolo26_cli.h"
+#include "yolo26_ncnn_io.h"
+#include "yolo26_ncnn_mat.h"
+#include "yolo26_option_profile.h"
+
+static void print_usage(const char* prog)
+{
+    std::fprintf(stderr,
+                 "Usage: %s <param> <bin> [options]\n"
+                 "\n"
+                 "Benchmarks ncnn::Option settings on the model with a synthetic input and writes the fastest\n"
+                 "one whose output stays within --tolerance of the fp32 output to a profile for\n"
+                 "Yolo26Config::option_profile.\n"
+                 "\n"
+                 "Options:\n"
+                 "  --out <path>             Profile to write (default yolo26_options.txt)\n"
+                 "  --width <int>            Input width (default 640)\n"
+                 "  --height <int>           Input height (default 640)\n"
+                 "  --threads <list>         Thread counts to try (default: big cores, halved down to 1)\n"
+                 "  --tolerance <float>      Max |out - fp32 out| / max |fp32 out|, boxes and scores each\n"
+                 "                           against their own max (default 0.005)\n"
+                 "  --seconds <float>        Timing per candidate (default 1)\n"
+                 "  --raw-bgr                Model takes raw BGR 0..255 (exported with --fold-preprocess)\n"
+                 "  --input-name <name>      Input blob (default in0)\n"
+                 "  --output-name <name>     Output blob (default out0)\n",
+                 prog);
+}
+
+static std::vector<int> parse_list(const std::string& s)
+{
+    std::vector<int> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        int v = 0;
+        if (yolo26_cli::parse_int(item.c_str(), v) && v > 0)
+            out.push_back(v);
+    }
+    return out;
+}
+
+class Tuner {
+public:
+    Tuner(const std::string& param_path,
+          const std::string& bin_path,
+          const std::string& input_name,
+          const std::string& output_name,
+          const ncnn::Mat& input,
+          float seconds)
+        : param_path_(param_path),
+          bin_path_(bin_path),
+          input_name_(input_name),
+          output_name_(output_name),
+          input_(input),
+          seconds_(seconds)
+    {
+    }
+
+    // fp32 output every candidate is compared against.
+    bool reference(int num_threads)
+    {
+        ncnn::Option opt;
+        opt.num_threads = num_threads;
+        opt.use_fp16_packed = false;
+        opt.use_fp16_storage = false;
+        opt.use_fp16_arithmetic = false;
+        double ms = 0.0;
+        return run(opt, reference_, ms, false);
+    }
+
+    // Times `profile` and fills in its ms / drift; false when the model cannot run with it.
+    bool measure(yolo26::OptionProfile& profile)
+    {
+        ncnn::Option opt;
+        yolo26::apply_option_profile(profile, opt);
+        opt.num_threads = profile.num_threads;
+
+        ncnn::Mat out;
+        if (!run(opt, out, profile.ms, true))
+            return false;
+        profile.drift = drift(out);
+        return true;
+    }
+
+private:
+    bool run(const ncnn::Option& opt, ncnn::Mat& out, double& ms, bool timed) const
+    {
+        ncnn::Net net;
+        net.opt = opt;
+        if (net.load_param(param_path_.c_str()) != 0 || net.load_model(bin_path_.c_str()) != 0)
+            return false;
+
+        // The first run pays for lazy allocations and supplies the output; time the ones after it.
+        if (!extract(net, out))
+            return false;
+        if (!timed)
+            return true;
+
+        typedef std::chrono::steady_clock Clock;
+        const Clock::time_point start = Clock::now();
+        int runs = 0;
+        double elapsed = 0.0;
+        while (runs < 3 || elapsed < seconds_)
+        {
+            ncnn::Mat result;
+            if (!extract(net, result))
+                return false;
+            runs++;
+            elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        }
+        ms = elapsed * 1e3 / runs;
+        return true;
+    }
+
+    bool extract(const ncnn::Net& net, ncnn::Mat& out) const
+    {
+        ncnn::Extractor ex = net.create_extractor();
+        ncnn::Mat result;
+        if (!yolo26::ncnn_input_image(ex, input_name_, input_) || !yolo26::ncnn_extract_out0(ex, output_name_, result))
+            return false;
+        out = result.clone();
+        return true;
+    }
+
+    // Largest error relative to the reference, with boxes (pixels) and scores (0..1) each measured
+    // against their own scale: the first 4 features of every prediction are its box, the rest its
+    // class scores (end2end exports: score and label; seg: mask coefficients too). Predictions
+    // outnumber features, which tells which axis holds the features.
+    double drift(const ncnn::Mat& out) const
+    {
+        ncnn::Mat ref_2d;
+        ncnn::Mat out_2d;
+        if (!yolo26::to_mat2d(reference_, ref_2d) || !yolo26::to_mat2d(out, out_2d) || out_2d.w != ref_2d.w
+            || out_2d.h != ref_2d.h)
+            return HUGE_VAL;
+
+        const bool feature_rows = ref_2d.h < ref_2d.w;
+        float max_ref[2] = {0.f, 0.f};
+        float max_diff[2] = {0.f, 0.f};
+        for (int y = 0; y < ref_2d.h; y++)
+        {
+            const float* a = ref_2d.row(y);
+            const float* b = out_2d.row(y);
+            for (int x = 0; x < ref_2d.w; x++)
+            {
+                const int group = (feature_rows ? y : x) < 4 ? 0 : 1;
+                max_ref[group] = std::max(max_ref[group], std::fabs(a[x]));
+                max_diff[group] = std::max(max_diff[group], std::fabs(a[x] - b[x]));
+            }
+        }
+
+        double worst = 0.0;
+        for (int group = 0; group < 2; group++)
+            worst = std::max(worst, (double)(max_ref[group] > 0.f ? max_diff[group] / max_ref[group] : max_diff[group]));
+        return worst;
+    }
+
+    std::string param_path_;
+    std::string bin_path_;
+    std::string input_name_;
+    std::string output_name_;
+    ncnn::Mat input_;
+    float seconds_;
+    ncnn::Mat reference_;
+};
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    const std::string param_path = argv[1];
+    const std::string bin_path = argv[2];
+
+    std::string out_path = "yolo26_options.txt";
+    std::string input_name = "in0";
+    std::string output_name = "out0";
+    int width = 640;
+    int height = 640;
+    float tolerance = 0.005f;
+    float seconds = 1.f;
+    bool raw_bgr = false;
+    std::vector<int> threads;
+    int argi = 3;
+    while (argi < argc)
+    {
+        const std::string arg = argv[argi++];
+        if (arg == "--out" && argi < argc)
+            out_path = argv[argi++];
+        else if (arg == "--input-name" && argi < argc)
+            input_name = argv[argi++];
+        else if (arg == "--output-name" && argi < argc)
+            output_name = argv[argi++];
+        else if (arg == "--raw-bgr")
+            raw_bgr = true;
+        else if (arg == "--threads" && argi < argc)
+        {
+            threads = parse_list(argv[argi++]);
+            if (threads.empty())
+                return (print_usage(argv[0]), 1);
+        }
+        else if (arg == "--width" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], width) || width <= 0)
+                return (print_usage(argv[0]), 1);
+        }
+        else if (arg == "--height" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], height) || height <= 0)
+                return (print_usage(argv[0]), 1);
+        }
+        else if (arg == "--tolerance" && argi < argc)
+        {
+            if (!yolo26_cli::parse_float(argv[argi++], tolerance))
+                return (print_usage(argv[0]), 1);
+        }
+        else if (arg == "--seconds" && argi < argc)
+        {
+            if (!yolo26_cli::parse_float(argv[argi++], seconds))
+                return (print_usage(argv[0]), 1);
+        }
+        else
+        {
+            return (print_usage(argv[0]), 1);
+        }
+    }
+
+    const int cores = std::max(1, ncnn::get_big_cpu_count());
+    if (threads.empty())
+    {
+        for (int t = cores; t >= 1; t /= 2)
+            threads.push_back(t);
+    }
+
+    // Deterministic noise in the model's input range; the values only need to exercise every layer.
+    ncnn::Mat input(width, height, 3);
+    unsigned int seed = 12345u;
+    for (int q = 0; q < 3; q++)
+    {
+        float* p = input.channel(q);
+        for (int i = 0; i < width * height; i++)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            const float v = (seed >> 8) / 16777216.f;
+            p[i] = raw_bgr ? v * 255.f : v;
+        }
+    }
+
+    Tuner tuner(param_path, bin_path, input_name, output_name, input, seconds);
+    if (!tuner.reference(cores))
+    {
+        std::fprintf(stderr, "Failed to run model: %s %s\n", param_path.c_str(), bin_path.c_str());
+        return 1;
+    }
+
+    std::fprintf(stdout, "threads fp16 pack wino sgemm light  ms        drift\n");
+    auto evaluate = [&](yolo26::OptionProfile& p) {
+        if (!tuner.measure(p))
+            return false;
+        std::fprintf(stdout,
+                     "%-7d %d%d%d  %-4d %-4d %-5d %-5d  %-9.2f %.2e%s\n",
+                     p.num_threads,
+                     p.use_fp16_packed ? 1 : 0,
+                     p.use_fp16_storage ? 1 : 0,
+                     p.use_fp16_arithmetic ? 1 : 0,
+                     p.use_packing_layout ? 1 : 0,
+                     p.use_winograd_convolution ? 1 : 0,
+                     p.use_sgemm_convolution ? 1 : 0,
+                     p.lightmode ? 1 : 0,
+                     p.ms,
+                     p.drift,
+                     p.drift > tolerance ? "  (drift)" : "");
+        return p.drift <= tolerance;
+    };
+
+    // Coordinate descent from ncnn's defaults: each switch in turn keeps whichever value is fastest
+    // with the others fixed at the best found so far. The full grid is ~50x the model loads for
+    // little gain, as the switches mostly act on separate layers.
+    ncnn::Option defaults;
+    defaults.num_threads = cores;
+    yolo26::OptionProfile best = yolo26::option_profile_from(defaults);
+    bool found = evaluate(best);
+    if (!found)
+    {
+        best.use_fp16_packed = false;
+        best.use_fp16_storage = false;
+        best.use_fp16_arithmetic = false;
+        found = evaluate(best);
+    }
+    if (!found)
+    {
+        std::fprintf(stderr, "No configuration within tolerance\n");
+        return 1;
+    }
+
+    typedef std::function<void(yolo26::OptionProfile&, int)> Setter;
+    struct Axis {
+        int values;
+        Setter set;
+    };
+    std::vector<Axis> axes;
+    axes.push_back(Axis{3, [](yolo26::OptionProfile& p, int v) {
+                            p.use_fp16_packed = v > 0;
+                            p.use_fp16_storage = v > 0;
+                            p.use_fp16_arithmetic = v > 1;
+                        }});
+    axes.push_back(Axis{2, [](yolo26::OptionProfile& p, int v) { p.use_packing_layout = v != 0; }});
+    axes.push_back(Axis{2, [](yolo26::OptionProfile& p, int v) { p.use_winograd_convolution = v != 0; }});
+    axes.push_back(Axis{2, [](yolo26::OptionProfile& p, int v) { p.use_sgemm_convolution = v != 0; }});
+    axes.push_back(Axis{2, [](yolo26::OptionProfile& p, int v) { p.lightmode = v != 0; }});
+    axes.push_back(Axis{(int)threads.size(), [&threads](yolo26::OptionProfile& p, int v) { p.num_threads = threads[v]; }});
+
+    for (const Axis& axis : axes)
+    {
+        const yolo26::OptionProfile base = best;
+        for (int v = 0; v < axis.values; v++)
+        {
+            yolo26::OptionProfile p = base;
+            axis.set(p, v);
+            if (p.num_threads == base.num_threads && p.use_fp16_packed == base.use_fp16_packed
+                && p.use_fp16_storage == base.use_fp16_storage && p.use_fp16_arithmetic == base.use_fp16_arithmetic
+                && p.use_packing_layout == base.use_packing_layout
+                && p.use_winograd_convolution == base.use_winograd_convolution
+                && p.use_sgemm_convolution == base.use_sgemm_convolution && p.lightmode == base.lightmode)
+                continue;
+            if (evaluate(p) && p.ms < best.ms)
+                best = p;
+        }
+    }
+
+    best.cpu_count = ncnn::get_cpu_count();
+    if (!yolo26::write_option_profile(out_path, best))
+    {
+        std::fprintf(stderr, "Failed to write %s\n", out_path.c_str());
+        return 1;
+    }
+    std::fprintf(stdout, "best: %.2f ms, drift %.2e -> %s\n", best.ms, best.drift, out_path.c_str());
+    return 0;
+}
@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/imgcodecs/imgcodecs.hpp>
+
+#include "yolo26.h"
+#include "yolo26_cli.h"
+#include "yolo26_sharded.h"
+
+static void print_usage(const char* prog)
+{
+    std::fprintf(stderr,
+                 "Usage: %s <param> <bin> <image> [options]\n"
+                 "\n"
+                 "Many threads calling one Yolo26 (or Yolo26Sharded) detect; prints throughput and latency per caller count.\n"
+                 "\n"
+                 "Options:\n"
+                 "  --callers <list>         Caller thread counts (default 1,2,4,8,16)\n"
+                 "  --ncnn-threads <int>     ncnn threads per call (default 1)\n"
+                 "  --seconds <float>        Duration per caller count (default 5)\n"
+                 "  --sharded                Use Yolo26Sharded, layout chosen by measuring\n"
+                 "  --shards <int>           Use Yolo26Sharded with this many instances (--ncnn-threads each)\n"
+                 "  (plus the yolo26_det options: --conf --iou --max-det --post --box --dedup --agnostic --gpu)\n",
+                 prog);
+}
+
+static std::vector<int> parse_list(const std::string& s)
+{
+    std::vector<int> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        int v = 0;
+        if (yolo26_cli::parse_int(item.c_str(), v) && v > 0)
+            out.push_back(v);
+    }
+    return out;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 4)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    const std::string param_path = argv[1];
+    const std::string bin_path = argv[2];
+    const std::string image_path = argv[3];
+
+    std::vector<int> callers = {1, 2, 4, 8, 16};
+    float seconds = 5.f;
+    Yolo26Config config;
+    config.num_threads = 1;
+    bool sharded = false;
+    int shards = 0;
+    int argi = 4;
+    while (argi < argc)
+    {
+        const std::string arg = argv[argi++];
+        if (arg == "--callers" && argi < argc)
+        {
+            callers = parse_list(argv[argi++]);
+            if (callers.empty())
+                return (print_usage(argv[0]), 1);
+        }
+        else if (arg == "--ncnn-threads" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], config.num_threads))
+                return (print_usage(argv[0]), 1);
+        }
+        else if (arg == "--seconds" && argi < argc)
+        {
+            if (!yolo26_cli::parse_float(argv[argi++], seconds))
+                return (print_usage(argv[0]), 1);
+        }
+        else if (arg == "--sharded")
+        {
+            sharded = true;
+        }
+        else if (arg == "--shards" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], shards) || shards <= 0)
+                return (print_usage(argv[0]), 1);
+            sharded = true;
+        }
+        else if (!yolo26_cli::parse_common_arg(arg,
+                                               argc,
+                                               argv,
+                                               argi,
+                                               config.conf_threshold,
+                                               config.iou_threshold,
+                                               config.max_det,
+                                               config.postprocess,
+                                               config.box_format,
+                                               config.topk_dedup,
+                                               config.agnostic_nms,
+                                               config.use_gpu))
+            return (print_usage(argv[0]), 1);
+    }
+
+    const cv::Mat bgr = cv::imread(image_path, cv::IMREAD_COLOR);
+    if (bgr.empty())
+    {
+        std::fprintf(stderr, "Failed to read image: %s\n", image_path.c_str());
+        return 1;
+    }
+
+    Yolo26 detector(config);
+    Yolo26ShardedConfig sharded_config;
+    sharded_config.detector = config;
+    sharded_config.shards = shards;
+    sharded_config.threads_per_shard = shards > 0 ? config.num_threads : 0;
+    Yolo26Sharded sharded_detector(sharded_config);
+    std::function<bool(std::vector<Yolo26Object>&)> detect;
+    if (sharded)
+    {
+        if (!sharded_detector.load(param_path, bin_path))
+        {
+            std::fprintf(stderr, "Failed to load model: %s %s\n", param_path.c_str(), bin_path.c_str());
+            return 1;
+        }
+        for (const Yolo26ShardLayout& l : sharded_detector.tuning())
+            std::fprintf(stdout, "tune: %d shards x %d threads  %.1f fps\n", l.shards, l.threads_per_shard, l.fps);
+        config.num_threads = sharded_detector.layout().threads_per_shard;
+        std::fprintf(stdout, "layout: %d shards x %d threads\n", sharded_detector.layout().shards, config.num_threads);
+        detect = [&](std::vector<Yolo26Object>& objects) { return sharded_detector.detect(bgr, objects); };
+    }
+    else
+    {
+        if (!detector.load(param_path, bin_path))
+        {
+            std::fprintf(stderr, "Failed to load model: %s %s\n", param_path.c_str(), bin_path.c_str());
+            return 1;
+        }
+        if (!detector.warmup(bgr.cols, bgr.rows))
+            return 1;
+        detect = [&](std::vector<Yolo26Object>& objects) { return detector.detect(bgr, objects); };
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    std::fprintf(stdout, "callers  ncnn_threads  frames   fps       p50_ms   p99_ms\n");
+    for (int n : callers)
+    {
+        std::atomic<bool> failed(false);
+        std::vector<std::vector<double>> latencies((size_t)n);
+        std::vector<std::thread> threads;
+        const Clock::time_point start = Clock::now();
+        const Clock::time_point stop = start + std::chrono::microseconds((long long)(seconds * 1e6));
+        for (int t = 0; t < n; t++)
+        {
+            threads.emplace_back([&, t]() {
+                std::vector<Yolo26Object> objects;
+                while (Clock::now() < stop)
+                {
+                    const Clock::time_point t0 = Clock::now();
+                    if (!detect(objects))
+                    {
+                        failed = true;
+                        return;
+                    }
+                    latencies[t].push_back(std::chrono::duration<double, std::milli>(Clock::now() - t0).count());
+                }
+            });
+        }
+        for (auto& th : threads)
+            th.join();
+        const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        if (failed)
+        {
+            std::fprintf(stderr, "Detection failed\n");
+            return 1;
+        }
+
+        std::vector<double> all;
+        for (const auto& l : latencies)
+            all.insert(all.end(), l.begin(), l.end());
+        std::sort(all.begin(), all.end());
+        const double p50 = all.empty() ? 0.0 : all[all.size() / 2];
+        const double p99 = all.empty() ? 0.0 : all[std::min(all.size() - 1, all.size() * 99 / 100)];
+        std::fprintf(stdout,
+                     "%-8d %-13d %-8zu %-9.1f %-8.2f %-8.2f\n",
+                     n,
+                     config.num_threads,
+                     all.size(),
+                     all.size() / elapsed,
+                     p50,
+                     p99);
+    }
+    return 0;
+}
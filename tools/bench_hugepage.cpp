@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencv2/imgcodecs/imgcodecs.hpp>
+
+#include "yolo26.h"
+#include "yolo26_cli.h"
+
+static void print_usage(const char* prog)
+{
+    std::fprintf(stderr,
+                 "Usage: %s <param> <bin> <image> [options]\n"
+                 "\n"
+                 "Detect latency with the default pooled allocators vs Yolo26Config::huge_pages. The two\n"
+                 "detectors run in alternating rounds so drift (thermal, other load) hits both alike.\n"
+                 "\n"
+                 "Options:\n"
+                 "  --iterations <int>       Timed detects per mode (default 200)\n"
+                 "  --rounds <int>           Alternations between the modes (default 10)\n"
+                 "  --warmup <int>           Untimed detects per mode first (default 10)\n"
+                 "  --threads <int>          ncnn threads per detect (default: big cores)\n"
+                 "  (plus the yolo26_det options: --conf --iou --max-det --post --box --dedup --agnostic --gpu)\n",
+                 prog);
+}
+
+// kB values from a /proc file with "Key:   123 kB" lines.
+static long proc_kb(const char* path, const char* key)
+{
+    std::FILE* fp = std::fopen(path, "r");
+    if (!fp)
+        return -1;
+    char line[256];
+    long value = -1;
+    const size_t len = std::strlen(key);
+    while (std::fgets(line, sizeof(line), fp))
+    {
+        if (std::strncmp(line, key, len) == 0 && line[len] == ':')
+        {
+            value = std::atol(line + len + 1);
+            break;
+        }
+    }
+    std::fclose(fp);
+    return value;
+}
+
+// First line of a small text file, without the newline ("" when unreadable).
+static std::string first_line(const char* path)
+{
+    std::FILE* fp = std::fopen(path, "r");
+    if (!fp)
+        return std::string();
+    char line[256] = {0};
+    if (!std::fgets(line, sizeof(line), fp))
+        line[0] = 0;
+    std::fclose(fp);
+    std::string s = line;
+    while (!s.empty() && (s[s.size() - 1] == '\n' || s[s.size() - 1] == '\r'))
+        s.erase(s.size() - 1);
+    return s;
+}
+
+static double percentile(std::vector<double> v, double p)
+{
+    if (v.empty())
+        return 0.0;
+    std::sort(v.begin(), v.end());
+    const size_t i = std::min(v.size() - 1, (size_t)(p * (v.size() - 1) + 0.5));
+    return v[i];
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 4)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    const std::string param_path = argv[1];
+    const std::string bin_path = argv[2];
+    const std::string image_path = argv[3];
+
+    int iterations = 200;
+    int rounds = 10;
+    int warmup = 10;
+    Yolo26Config config;
+    int argi = 4;
+    while (argi < argc)
+    {
+        const std::string arg = argv[argi++];
+        if (arg == "--iterations" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], iterations) || iterations <= 0)
+                return (print_usage(argv[0]), 1);
+        }
+        else if (arg == "--rounds" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], rounds) || rounds <= 0)
+                return (print_usage(argv[0]), 1);
+        }
+        else if (arg == "--warmup" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], warmup) || warmup < 0)
+                return (print_usage(argv[0]), 1);
+        }
+        else if (arg == "--threads" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], config.num_threads))
+                return (print_usage(argv[0]), 1);
+        }
+        else if (!yolo26_cli::parse_common_arg(arg,
+                                               argc,
+                                               argv,
+                                               argi,
+                                               config.conf_threshold,
+                                               config.iou_threshold,
+                                               config.max_det,
+                                               config.postprocess,
+                                               config.box_format,
+                                               config.topk_dedup,
+                                               config.agnostic_nms,
+                                               config.use_gpu))
+            return (print_usage(argv[0]), 1);
+    }
+
+    const cv::Mat bgr = cv::imread(image_path, cv::IMREAD_COLOR);
+    if (bgr.empty())
+    {
+        std::fprintf(stderr, "Failed to read image: %s\n", image_path.c_str());
+        return 1;
+    }
+
+    const char* names[2] = {"pool", "huge_pages"};
+    std::unique_ptr<Yolo26> detectors[2];
+    std::vector<double> latency_ms[2];
+    std::vector<Yolo26Object> objects;
+    const long huge_free_before = proc_kb("/proc/meminfo", "HugePages_Free");
+    for (int m = 0; m < 2; m++)
+    {
+        Yolo26Config c = config;
+        c.huge_pages = m == 1;
+        detectors[m].reset(new Yolo26(c));
+        if (!detectors[m]->load(param_path, bin_path))
+        {
+            std::fprintf(stderr, "Failed to load model: %s %s\n", param_path.c_str(), bin_path.c_str());
+            return 1;
+        }
+        for (int i = 0; i < warmup; i++)
+        {
+            if (!detectors[m]->detect(bgr, objects))
+                return 1;
+        }
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    const int per_round = std::max(1, iterations / rounds);
+    for (int r = 0; r < rounds; r++)
+    {
+        for (int m = 0; m < 2; m++)
+        {
+            for (int i = 0; i < per_round; i++)
+            {
+                const Clock::time_point t0 = Clock::now();
+                if (!detectors[m]->detect(bgr, objects))
+                    return 1;
+                latency_ms[m].push_back(std::chrono::duration<double, std::milli>(Clock::now() - t0).count());
+            }
+        }
+    }
+
+    std::fprintf(stdout, "%-12s %-8s %-9s %-9s %-9s %s\n", "allocator", "frames", "mean_ms", "p50_ms", "p99_ms", "max_ms");
+    double mean[2] = {0.0, 0.0};
+    for (int m = 0; m < 2; m++)
+    {
+        for (double v : latency_ms[m])
+            mean[m] += v;
+        mean[m] /= latency_ms[m].size();
+        std::fprintf(stdout,
+                     "%-12s %-8d %-9.3f %-9.3f %-9.3f %.3f\n",
+                     names[m],
+                     (int)latency_ms[m].size(),
+                     mean[m],
+                     percentile(latency_ms[m], 0.5),
+                     percentile(latency_ms[m], 0.99),
+                     percentile(latency_ms[m], 1.0));
+    }
+
+    // Where the pages came from: reserved hugetlbfs pages taken, or THP-backed anonymous memory.
+    const long huge_free_after = proc_kb("/proc/meminfo", "HugePages_Free");
+    std::fprintf(stdout,
+                 "speedup %.3fx; hugetlb pages used %ld, AnonHugePages %ld kB, THP %s\n",
+                 mean[1] > 0.0 ? mean[0] / mean[1] : 0.0,
+                 huge_free_before >= 0 && huge_free_after >= 0 ? huge_free_before - huge_free_after : -1L,
+                 proc_kb("/proc/self/smaps_rollup", "AnonHugePages"),
+                 first_line("/sys/kernel/mm/transparent_hugepage/enabled").c_str());
+    return 0;
+}
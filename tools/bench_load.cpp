@@ -0,0 +1,192 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "yolo26.h"
+#include "yolo26_cli.h"
+
+static void print_usage(const char* prog)
+{
+    std::fprintf(stderr,
+                 "Usage: %s <param> <bin> [options]\n"
+                 "\n"
+                 "Load time and memory of N Yolo26 instances, file loading vs mmap_model. Each mode runs in its\n"
+                 "own process; Pss splits shared pages between the processes using them.\n"
+                 "\n"
+                 "Options:\n"
+                 "  --instances <int>        Instances per process (default 4)\n"
+                 "  --workers <int>          Forked processes per mode, all loading the model (default 1)\n"
+                 "  --width <int>            Input width (default 640)\n"
+                 "  --height <int>           Input height (default 640)\n",
+                 prog);
+}
+
+// kB values from a /proc file with "Key:   123 kB" lines.
+static long proc_kb(const char* path, const char* key)
+{
+    std::FILE* fp = std::fopen(path, "r");
+    if (!fp)
+        return -1;
+    char line[256];
+    long value = -1;
+    const size_t len = std::strlen(key);
+    while (std::fgets(line, sizeof(line), fp))
+    {
+        if (std::strncmp(line, key, len) == 0 && line[len] == ':')
+        {
+            value = std::atol(line + len + 1);
+            break;
+        }
+    }
+    std::fclose(fp);
+    return value;
+}
+
+static int run_worker(const std::string& param_path,
+                      const std::string& bin_path,
+                      bool mmap_model,
+                      int instances,
+                      const Yolo26Config& base,
+                      int worker,
+                      int ready_fd,
+                      int go_fd)
+{
+    Yolo26Config config = base;
+    config.mmap_model = mmap_model;
+
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point t0 = Clock::now();
+    std::vector<std::unique_ptr<Yolo26>> detectors;
+    for (int i = 0; i < instances; i++)
+    {
+        detectors.push_back(std::unique_ptr<Yolo26>(new Yolo26(config)));
+        if (!detectors.back()->load(param_path, bin_path))
+        {
+            std::fprintf(stderr, "Failed to load model: %s %s\n", param_path.c_str(), bin_path.c_str());
+            return 1;
+        }
+    }
+    const double load_ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    for (const auto& d : detectors)
+    {
+        if (!d->warmup(config.input_width, config.input_height))
+            return 1;
+    }
+
+    // Measure only once every worker of this mode is loaded, so Pss sees all the sharing.
+    char c = 0;
+    if (write(ready_fd, &c, 1) != 1 || read(go_fd, &c, 1) != 1)
+        return 1;
+
+    std::printf("%-5s  %-6d %-9d %-10.1f %-9ld %-9ld %-9ld %-9ld\n",
+                mmap_model ? "mmap" : "file",
+                worker,
+                instances,
+                load_ms,
+                proc_kb("/proc/self/status", "VmRSS") / 1024,
+                proc_kb("/proc/self/status", "RssAnon") / 1024,
+                proc_kb("/proc/self/status", "RssFile") / 1024,
+                proc_kb("/proc/self/smaps_rollup", "Pss") / 1024);
+    std::fflush(stdout);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    const std::string param_path = argv[1];
+    const std::string bin_path = argv[2];
+
+    int instances = 4;
+    int workers = 1;
+    Yolo26Config config;
+    config.num_threads = 1;
+    int argi = 3;
+    while (argi < argc)
+    {
+        const std::string arg = argv[argi++];
+        if (arg == "--instances" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], instances) || instances <= 0)
+                return (print_usage(argv[0]), 1);
+        }
+        else if (arg == "--workers" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], workers) || workers <= 0)
+                return (print_usage(argv[0]), 1);
+        }
+        else if (arg == "--width" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], config.input_width))
+                return (print_usage(argv[0]), 1);
+        }
+        else if (arg == "--height" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], config.input_height))
+                return (print_usage(argv[0]), 1);
+        }
+        else
+        {
+            return (print_usage(argv[0]), 1);
+        }
+    }
+
+    std::printf("mode   worker instances load_ms    rss_mb    anon_mb   file_mb   pss_mb\n");
+    std::fflush(stdout);
+
+    int status_all = 0;
+    for (int mode = 0; mode < 2; mode++)
+    {
+        int ready[2];
+        int go[2];
+        if (pipe(ready) != 0 || pipe(go) != 0)
+            return 1;
+
+        std::vector<pid_t> pids;
+        for (int w = 0; w < workers; w++)
+        {
+            const pid_t pid = fork();
+            if (pid == 0)
+                _exit(run_worker(param_path, bin_path, mode == 1, instances, config, w, ready[1], go[0]));
+            if (pid < 0)
+                return 1;
+            pids.push_back(pid);
+        }
+
+        // A worker that fails exits without signalling; its closed pipe ends the wait early.
+        close(ready[1]);
+        for (int w = 0; w < workers; w++)
+        {
+            char c = 0;
+            if (read(ready[0], &c, 1) != 1)
+                break;
+        }
+        const std::vector<char> go_bytes((size_t)workers, 0);
+        if (write(go[1], go_bytes.data(), go_bytes.size()) != (ssize_t)go_bytes.size())
+            status_all = 1;
+        close(ready[0]);
+        close(go[0]);
+        close(go[1]);
+
+        for (pid_t pid : pids)
+        {
+            int status = 0;
+            waitpid(pid, &status, 0);
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+                status_all = 1;
+        }
+    }
+    return status_all;
+}
@@ -0,0 +1,139 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/imgcodecs/imgcodecs.hpp>
+
+#include "yolo26.h"
+#include "yolo26_cli.h"
+#include "yolo26_pipeline.h"
+
+static void print_usage(const char* prog)
+{
+    std::fprintf(stderr,
+                 "Usage: %s <param> <bin> <image> [options]\n"
+                 "\n"
+                 "Throughput of serial Yolo26::detect vs Yolo26Pipeline on the same image stream.\n"
+                 "\n"
+                 "Options:\n"
+                 "  --frames <int>           Frames per run (default 200)\n"
+                 "  --depth <int>            Pipeline frames in flight (default 4)\n"
+                 "  --ncnn-threads <int>     ncnn threads per extraction (default: big CPU cores)\n"
+                 "  (plus the yolo26_det options: --conf --iou --max-det --post --box --dedup --agnostic --gpu)\n",
+                 prog);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 4)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    const std::string param_path = argv[1];
+    const std::string bin_path = argv[2];
+    const std::string image_path = argv[3];
+
+    int frames = 200;
+    int depth = 4;
+    Yolo26Config config;
+    int argi = 4;
+    while (argi < argc)
+    {
+        const std::string arg = argv[argi++];
+        if (arg == "--frames" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], frames) || frames <= 0)
+                return (print_usage(argv[0]), 1);
+        }
+        else if (arg == "--depth" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], depth) || depth <= 0)
+                return (print_usage(argv[0]), 1);
+        }
+        else if (arg == "--ncnn-threads" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], config.num_threads))
+                return (print_usage(argv[0]), 1);
+        }
+        else if (!yolo26_cli::parse_common_arg(arg,
+                                               argc,
+                                               argv,
+                                               argi,
+                                               config.conf_threshold,
+                                               config.iou_threshold,
+                                               config.max_det,
+                                               config.postprocess,
+                                               config.box_format,
+                                               config.topk_dedup,
+                                               config.agnostic_nms,
+                                               config.use_gpu))
+            return (print_usage(argv[0]), 1);
+    }
+
+    const cv::Mat bgr = cv::imread(image_path, cv::IMREAD_COLOR);
+    if (bgr.empty())
+    {
+        std::fprintf(stderr, "Failed to read image: %s\n", image_path.c_str());
+        return 1;
+    }
+
+    Yolo26 detector(config);
+    if (!detector.load(param_path, bin_path))
+    {
+        std::fprintf(stderr, "Failed to load model: %s %s\n", param_path.c_str(), bin_path.c_str());
+        return 1;
+    }
+    if (!detector.warmup(bgr.cols, bgr.rows))
+        return 1;
+
+    typedef std::chrono::steady_clock Clock;
+    std::vector<Yolo26Object> objects;
+
+    Clock::time_point t0 = Clock::now();
+    for (int i = 0; i < frames; i++)
+    {
+        if (!detector.detect(bgr, objects))
+        {
+            std::fprintf(stderr, "Detection failed\n");
+            return 1;
+        }
+    }
+    const double serial = std::chrono::duration<double>(Clock::now() - t0).count();
+    const size_t serial_count = objects.size();
+
+    bool ok = true;
+    size_t pipeline_count = 0;
+    t0 = Clock::now();
+    {
+        Yolo26Pipeline pipeline(detector, depth);
+        std::thread producer([&]() {
+            for (int i = 0; i < frames; i++)
+                pipeline.push(bgr);
+        });
+        for (int i = 0; i < frames; i++)
+        {
+            // pop() returns false while the producer has not pushed yet; only a failed frame counts.
+            while (pipeline.pending() == 0)
+                std::this_thread::yield();
+            ok = pipeline.pop(objects) && ok;
+        }
+        producer.join();
+        pipeline_count = objects.size();
+    }
+    const double pipelined = std::chrono::duration<double>(Clock::now() - t0).count();
+    if (!ok)
+    {
+        std::fprintf(stderr, "Detection failed\n");
+        return 1;
+    }
+
+    std::fprintf(stdout, "mode      frames  fps      ms/frame  objects\n");
+    std::fprintf(stdout, "serial    %-7d %-8.1f %-9.2f %zu\n", frames, frames / serial, serial * 1e3 / frames, serial_count);
+    std::fprintf(stdout, "pipeline  %-7d %-8.1f %-9.2f %zu\n", frames, frames / pipelined, pipelined * 1e3 / frames, pipeline_count);
+    std::fprintf(stdout, "speedup   %.2fx\n", serial / pipelined);
+    return 0;
+}
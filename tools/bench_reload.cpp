@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/imgcodecs/imgcodecs.hpp>
+
+#include "yolo26.h"
+#include "yolo26_cli.h"
+
+static void print_usage(const char* prog)
+{
+    std::fprintf(stderr,
+                 "Usage: %s <param> <bin> <image> [options]\n"
+                 "\n"
+                 "Detects on the image from several threads while Yolo26::reload() swaps the model in,\n"
+                 "and reports the swap timings and the detect latency of frames served around each swap.\n"
+                 "\n"
+                 "Options:\n"
+                 "  --reload-param <path>    Model to swap in (default: the loaded one)\n"
+                 "  --reload-bin <path>\n"
+                 "  --reloads <int>          Swaps (default 5)\n"
+                 "  --interval <int>         Milliseconds between swaps (default 500)\n"
+                 "  --callers <int>          Detecting threads (default 2)\n"
+                 "  --ncnn-threads <int>     ncnn threads per detect (default 1)\n"
+                 "  --mmap                   Load with mmap_model\n"
+                 "  (plus the yolo26_det options: --conf --iou --max-det --post --box --dedup --agnostic --gpu)\n",
+                 prog);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 4)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    const std::string param_path = argv[1];
+    const std::string bin_path = argv[2];
+    const std::string image_path = argv[3];
+
+    std::string reload_param = param_path;
+    std::string reload_bin = bin_path;
+    int reloads = 5;
+    int interval_ms = 500;
+    int callers = 2;
+    Yolo26Config config;
+    config.num_threads = 1;
+    int argi = 4;
+    while (argi < argc)
+    {
+        const std::string arg = argv[argi++];
+        if (arg == "--reload-param" && argi < argc)
+            reload_param = argv[argi++];
+        else if (arg == "--reload-bin" && argi < argc)
+            reload_bin = argv[argi++];
+        else if (arg == "--mmap")
+            config.mmap_model = true;
+        else if (arg == "--reloads" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], reloads) || reloads <= 0)
+                return (print_usage(argv[0]), 1);
+        }
+        else if (arg == "--interval" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], interval_ms) || interval_ms < 0)
+                return (print_usage(argv[0]), 1);
+        }
+        else if (arg == "--callers" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], callers) || callers <= 0)
+                return (print_usage(argv[0]), 1);
+        }
+        else if (arg == "--ncnn-threads" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], config.num_threads))
+                return (print_usage(argv[0]), 1);
+        }
+        else if (!yolo26_cli::parse_common_arg(arg,
+                                               argc,
+                                               argv,
+                                               argi,
+                                               config.conf_threshold,
+                                               config.iou_threshold,
+                                               config.max_det,
+                                               config.postprocess,
+                                               config.box_format,
+                                               config.topk_dedup,
+                                               config.agnostic_nms,
+                                               config.use_gpu))
+            return (print_usage(argv[0]), 1);
+    }
+
+    const cv::Mat bgr = cv::imread(image_path, cv::IMREAD_COLOR);
+    if (bgr.empty())
+    {
+        std::fprintf(stderr, "Failed to read image: %s\n", image_path.c_str());
+        return 1;
+    }
+
+    Yolo26 detector(config);
+    if (!detector.load(param_path, bin_path))
+    {
+        std::fprintf(stderr, "Failed to load model: %s %s\n", param_path.c_str(), bin_path.c_str());
+        return 1;
+    }
+    if (!detector.warmup(bgr.cols, bgr.rows))
+        return 1;
+
+    typedef std::chrono::steady_clock Clock;
+    std::atomic<bool> stop(false);
+    std::atomic<long> frames(0);
+    std::atomic<long> failed(0);
+    // Worst detect latency since the last reset, in microseconds.
+    std::atomic<long long> worst_us(0);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < callers; i++)
+    {
+        threads.emplace_back([&]() {
+            std::vector<Yolo26Object> objects;
+            while (!stop)
+            {
+                const Clock::time_point t0 = Clock::now();
+                const bool ok = detector.detect(bgr, objects);
+                const long long us = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - t0).count();
+                long long prev = worst_us;
+                while (us > prev && !worst_us.compare_exchange_weak(prev, us))
+                {
+                }
+                if (ok)
+                    frames++;
+                else
+                    failed++;
+            }
+        });
+    }
+
+    // Steady-state latency first, so the per-swap worst case has something to be compared with.
+    std::this_thread::sleep_for(std::chrono::milliseconds(std::max(interval_ms, 200)));
+    const long long steady_us = worst_us.exchange(0);
+
+    std::fprintf(stdout, "reload  ok  load_ms   warmup_ms  swap_us   total_ms  worst_detect_ms\n");
+    bool all_ok = true;
+    for (int r = 0; r < reloads; r++)
+    {
+        worst_us = 0;
+        const bool ok = detector.reload(reload_param, reload_bin);
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+        const Yolo26ReloadStats s = detector.reload_stats();
+        std::fprintf(stdout,
+                     "%-7d %-3d %-9.2f %-10.2f %-9.2f %-9.2f %.2f\n",
+                     r,
+                     ok ? 1 : 0,
+                     s.load_ms,
+                     s.warmup_ms,
+                     s.swap_us,
+                     s.total_ms,
+                     worst_us / 1e3);
+        all_ok = all_ok && ok;
+    }
+
+    stop = true;
+    for (auto& t : threads)
+        t.join();
+
+    const Yolo26ReloadStats s = detector.reload_stats();
+    std::fprintf(stdout,
+                 "steady worst detect %.2f ms; frames %ld, failed %ld; reloads %d, failures %d; "
+                 "max total %.2f ms, last drain %.2f ms, max drain %.2f ms, retired alive %d\n",
+                 steady_us / 1e3,
+                 (long)frames,
+                 (long)failed,
+                 s.reloads,
+                 s.failures,
+                 s.max_total_ms,
+                 s.drain_ms,
+                 s.max_drain_ms,
+                 s.retired_alive);
+    return all_ok && failed == 0 ? 0 : 1;
+}
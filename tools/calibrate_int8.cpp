@@ -0,0 +1,955 @@
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgcodecs/imgcodecs.hpp>
+
+#include "cpu.h"
+#include "datareader.h"
+#include "layer.h"
+#include "modelbin.h"
+#include "net.h"
+#include "paramdict.h"
+
+#include "yolo26_cli.h"
+#include "yolo26_image.h"
+#include "yolo26_mapped_file.h"
+#include "yolo26_ncnn_io.h"
+#include "yolo26_preprocess.h"
+
+static void print_usage(const char* prog)
+{
+    std::fprintf(stderr,
+                 "Usage: %s <param> <bin> <image_dir> [options]\n"
+                 "\n"
+                 "Post-training int8 quantization. Calibration images are letterboxed exactly as Yolo26::detect\n"
+                 "does, the input of every Convolution / ConvolutionDepthWise / InnerProduct is measured through\n"
+                 "ncnn, and the model is rewritten with int8 weights for those layers (load it with\n"
+                 "Yolo26Config::int8). The last convolutions before each output - the detect / seg heads - stay\n"
+                 "fp32, as does any layer whose own quantization error is above --fp32-error.\n"
+                 "\n"
+                 "Options:\n"
+                 "  --out-param <path>       Quantized .param (default yolo26-int8.param)\n"
+                 "  --out-bin <path>         Quantized .bin (default yolo26-int8.bin)\n"
+                 "  --table <path>           Calibration table, ncnn2table format (default yolo26-int8.table)\n"
+                 "  --report <path>          Per-layer sensitivity report (default yolo26-int8-report.txt)\n"
+                 "  --width <int>            Input width (default 640)\n"
+                 "  --height <int>           Input height (default 640)\n"
+                 "  --raw-bgr                Model takes raw BGR 0..255 (exported with --fold-preprocess)\n"
+                 "  --max-images <int>       Calibration images used, 0 = all (default 0)\n"
+                 "  --method <kl|minmax>     Activation threshold: KL divergence or max |x| (default kl)\n"
+                 "  --fp32-head-depth <int>  Keep convolutions within this many of an output in fp32 (default 3)\n"
+                 "  --fp32-layers <list>     Comma-separated layer names kept in fp32\n"
+                 "  --fp32-error <float>     Keep layers whose error when quantized alone exceeds this (default off)\n"
+                 "  --sensitivity-images <n> Images for the per-layer error, 0 = skip the analysis (default 8)\n"
+                 "  --input-name <name>      Input blob (default in0)\n",
+                 prog);
+}
+
+namespace {
+
+// One layer line of an ncnn .param, kept as written so untouched layers round-trip unchanged.
+struct ParamLayer {
+    std::string type;
+    std::string name;
+    std::vector<std::string> bottoms;
+    std::vector<std::string> tops;
+    std::vector<std::string> params;  // "key=value" tokens
+
+    int get(int key, int fallback) const
+    {
+        char prefix[16];
+        std::snprintf(prefix, sizeof(prefix), "%d=", key);
+        for (const std::string& p : params)
+        {
+            if (yolo26_cli::starts_with(p, prefix))
+                return std::atoi(p.c_str() + std::strlen(prefix));
+        }
+        return fallback;
+    }
+
+    void set(int key, int value)
+    {
+        char prefix[16];
+        std::snprintf(prefix, sizeof(prefix), "%d=", key);
+        const std::string token = prefix + std::to_string(value);
+        for (std::string& p : params)
+        {
+            if (yolo26_cli::starts_with(p, prefix))
+            {
+                p = token;
+                return;
+            }
+        }
+        params.push_back(token);
+    }
+};
+
+struct Model {
+    std::string magic;
+    int blob_count = 0;
+    std::vector<ParamLayer> layers;
+    // Per layer: its bytes of the .bin and the weights its load_model() read from them.
+    std::vector<size_t> bin_begin;
+    std::vector<size_t> bin_end;
+    std::vector<std::vector<ncnn::Mat>> weights;
+    std::shared_ptr<const yolo26::MappedFile> bin;
+};
+
+bool is_float_token(const std::string& s)
+{
+    return s.find_first_of(".eE") != std::string::npos;
+}
+
+// ParamDict the way Net::load_param fills it, from the "key=value" tokens of one layer.
+void fill_param_dict(const ParamLayer& layer, ncnn::ParamDict& pd)
+{
+    for (const std::string& p : layer.params)
+    {
+        const size_t eq = p.find('=');
+        if (eq == std::string::npos)
+            continue;
+        int id = std::atoi(p.substr(0, eq).c_str());
+        const std::string value = p.substr(eq + 1);
+        if (id <= -23300)
+        {
+            // Array: "-233xx=n,v0,v1,..."
+            id = -id - 23300;
+            std::vector<std::string> items;
+            std::stringstream ss(value);
+            std::string item;
+            while (std::getline(ss, item, ','))
+                items.push_back(item);
+            const int n = items.empty() ? 0 : std::atoi(items[0].c_str());
+            ncnn::Mat v(std::max(n, 1));
+            bool is_float = false;
+            for (int i = 0; i < n && i + 1 < (int)items.size(); i++)
+                is_float = is_float || is_float_token(items[i + 1]);
+            for (int i = 0; i < n && i + 1 < (int)items.size(); i++)
+            {
+                if (is_float)
+                    ((float*)v.data)[i] = (float)std::atof(items[i + 1].c_str());
+                else
+                    ((int*)v.data)[i] = std::atoi(items[i + 1].c_str());
+            }
+            pd.set(id, v);
+        }
+        else if (is_float_token(value))
+        {
+            pd.set(id, (float)std::atof(value.c_str()));
+        }
+        else
+        {
+            pd.set(id, std::atoi(value.c_str()));
+        }
+    }
+}
+
+// Forwards to ncnn's reader and keeps what each load() returned.
+class RecordingModelBin : public ncnn::ModelBin {
+public:
+    explicit RecordingModelBin(const ncnn::DataReader& dr)
+        : mb_(dr)
+    {
+    }
+
+    virtual ncnn::Mat load(int w, int type) const
+    {
+        const ncnn::Mat m = mb_.load(w, type);
+        loaded.push_back(m);
+        return m;
+    }
+
+    mutable std::vector<ncnn::Mat> loaded;
+
+private:
+    ncnn::ModelBinFromDataReader mb_;
+};
+
+bool read_model(const std::string& param_path, const std::string& bin_path, Model& model)
+{
+    std::string text;
+    model.bin = yolo26::MappedFile::open(bin_path);
+    if (!model.bin || !yolo26::read_text_file(param_path, text))
+        return false;
+
+    std::istringstream in(text);
+    int layer_count = 0;
+    if (!(in >> model.magic >> layer_count >> model.blob_count) || model.magic != "7767517")
+        return false;
+    std::string line;
+    std::getline(in, line);
+    while ((int)model.layers.size() < layer_count && std::getline(in, line))
+    {
+        std::istringstream tokens(line);
+        ParamLayer layer;
+        int bottom_count = 0;
+        int top_count = 0;
+        if (!(tokens >> layer.type >> layer.name >> bottom_count >> top_count))
+            continue;
+        layer.bottoms.resize(bottom_count);
+        layer.tops.resize(top_count);
+        for (std::string& b : layer.bottoms)
+            tokens >> b;
+        for (std::string& t : layer.tops)
+            tokens >> t;
+        std::string p;
+        while (tokens >> p)
+            layer.params.push_back(p);
+        model.layers.push_back(layer);
+    }
+    if ((int)model.layers.size() != layer_count)
+        return false;
+
+    // Replays Net::load_model one layer at a time to learn each layer's byte range and weights.
+    const unsigned char* base = model.bin->data();
+    const unsigned char* p = base;
+    for (const ParamLayer& pl : model.layers)
+    {
+        std::unique_ptr<ncnn::Layer> layer(ncnn::create_layer(pl.type.c_str()));
+        if (!layer)
+        {
+            std::fprintf(stderr, "Unsupported layer type %s (%s)\n", pl.type.c_str(), pl.name.c_str());
+            return false;
+        }
+        ncnn::ParamDict pd;
+        fill_param_dict(pl, pd);
+        if (layer->load_param(pd) != 0)
+            return false;
+
+        model.bin_begin.push_back((size_t)(p - base));
+        ncnn::DataReaderFromMemory dr(p);
+        RecordingModelBin mb(dr);
+        if (layer->load_model(mb) != 0 || (size_t)(p - base) > model.bin->size())
+            return false;
+        model.bin_end.push_back((size_t)(p - base));
+        model.weights.push_back(mb.loaded);
+    }
+    return true;
+}
+
+// A layer ncnn can run in int8: its fp32 weights, its input blob and how its scales are grouped.
+struct QuantLayer {
+    int index = 0;
+    std::string bottom;
+    int scale_groups = 0;     // num_output, or group for depthwise
+    int int8_scale_term = 0;  // what ncnn2int8 writes for the type
+    std::vector<float> weight_scales;
+    float bottom_scale = 0.f;
+    int head_depth = INT_MAX;  // 1 = feeds an output with no other candidate in between
+    double error = -1.0;       // output error with only this layer quantized, -1 = not measured
+    bool int8 = true;
+};
+
+bool quant_candidate(const Model& model, int index, QuantLayer& q)
+{
+    const ParamLayer& l = model.layers[index];
+    const std::vector<ncnn::Mat>& w = model.weights[index];
+    const bool depthwise = l.type == "ConvolutionDepthWise";
+    if (l.type != "Convolution" && !depthwise && l.type != "InnerProduct")
+        return false;
+    // Already quantized, weights fed at runtime, or not plain fp32 weights + bias.
+    const int bias_term = l.get(5, 0);
+    if (l.get(8, 0) != 0 || l.get(19, 0) != 0 || l.bottoms.size() != 1 || w.empty() || w[0].elemsize != 4
+        || (int)w.size() != 1 + (bias_term ? 1 : 0))
+        return false;
+
+    const int num_output = l.get(0, 0);
+    q.index = index;
+    q.bottom = l.bottoms[0];
+    q.scale_groups = depthwise ? l.get(7, 1) : num_output;
+    q.int8_scale_term = depthwise ? 1 : 2;
+    const int size = (int)w[0].total();
+    if (q.scale_groups <= 0 || size % q.scale_groups != 0)
+        return false;
+
+    // Symmetric per output channel (per group for depthwise): 127 / max |w|.
+    const int per_group = size / q.scale_groups;
+    const float* p = w[0];
+    q.weight_scales.resize(q.scale_groups);
+    for (int g = 0; g < q.scale_groups; g++)
+    {
+        float absmax = 0.f;
+        for (int i = 0; i < per_group; i++)
+            absmax = std::max(absmax, std::fabs(p[g * per_group + i]));
+        q.weight_scales[g] = absmax == 0.f ? 1.f : 127.f / absmax;
+    }
+    return true;
+}
+
+// For every candidate, the fewest candidates (itself included) on a path to a graph output.
+void compute_head_depth(const Model& model, std::vector<QuantLayer>& quant)
+{
+    std::map<std::string, std::vector<int>> consumers;
+    for (size_t i = 0; i < model.layers.size(); i++)
+    {
+        for (const std::string& b : model.layers[i].bottoms)
+            consumers[b].push_back((int)i);
+    }
+    std::vector<int> is_quant(model.layers.size(), 0);
+    for (const QuantLayer& q : quant)
+        is_quant[q.index] = 1;
+
+    // Layers are stored in topological order, so walking backwards sees every consumer first.
+    std::vector<int> dist(model.layers.size(), INT_MAX);
+    for (int i = (int)model.layers.size() - 1; i >= 0; i--)
+    {
+        for (const std::string& t : model.layers[i].tops)
+        {
+            const std::vector<int>& c = consumers[t];
+            if (c.empty())
+                dist[i] = 0;
+            for (int j : c)
+            {
+                if (dist[j] != INT_MAX)
+                    dist[i] = std::min(dist[i], dist[j] + is_quant[j]);
+            }
+        }
+    }
+    for (QuantLayer& q : quant)
+        q.head_depth = dist[q.index] == INT_MAX ? INT_MAX : dist[q.index] + 1;
+}
+
+std::vector<std::string> output_blobs(const Model& model)
+{
+    std::map<std::string, int> used;
+    for (const ParamLayer& l : model.layers)
+    {
+        for (const std::string& b : l.bottoms)
+            used[b]++;
+    }
+    std::vector<std::string> outputs;
+    for (const ParamLayer& l : model.layers)
+    {
+        for (const std::string& t : l.tops)
+        {
+            if (!used.count(t))
+                outputs.push_back(t);
+        }
+    }
+    return outputs;
+}
+
+void append(std::vector<unsigned char>& bin, const void* data, size_t size)
+{
+    const unsigned char* p = (const unsigned char*)data;
+    bin.insert(bin.end(), p, p + size);
+}
+
+// The model with every candidate whose int8 flag is set rewritten as ncnn2int8 would: int8 weights
+// (tagged 0x000D4B38, padded to 4 bytes), the original bias, then weight and input scales.
+void build_model(const Model& model, const std::vector<QuantLayer>& quant, std::string& param, std::vector<unsigned char>& bin)
+{
+    std::map<int, const QuantLayer*> by_index;
+    for (const QuantLayer& q : quant)
+    {
+        if (q.int8)
+            by_index[q.index] = &q;
+    }
+
+    std::ostringstream out;
+    out << model.magic << "\n" << model.layers.size() << " " << model.blob_count << "\n";
+    bin.clear();
+    const unsigned char* base = model.bin->data();
+    for (size_t i = 0; i < model.layers.size(); i++)
+    {
+        ParamLayer l = model.layers[i];
+        std::map<int, const QuantLayer*>::const_iterator it = by_index.find((int)i);
+        if (it == by_index.end())
+        {
+            append(bin, base + model.bin_begin[i], model.bin_end[i] - model.bin_begin[i]);
+        }
+        else
+        {
+            const QuantLayer& q = *it->second;
+            l.set(8, q.int8_scale_term);
+
+            const ncnn::Mat& w = model.weights[i][0];
+            const int size = (int)w.total();
+            const int per_group = size / q.scale_groups;
+            const float* p = w;
+            const uint32_t tag = 0x000D4B38;
+            append(bin, &tag, 4);
+            std::vector<signed char> w8((size + 3) / 4 * 4, 0);
+            for (int k = 0; k < size; k++)
+            {
+                const float v = std::round(p[k] * q.weight_scales[k / per_group]);
+                w8[k] = (signed char)std::max(-127.f, std::min(127.f, v));
+            }
+            append(bin, w8.data(), w8.size());
+            for (size_t m = 1; m < model.weights[i].size(); m++)
+                append(bin, model.weights[i][m].data, model.weights[i][m].total() * sizeof(float));
+            append(bin, q.weight_scales.data(), q.weight_scales.size() * sizeof(float));
+            append(bin, &q.bottom_scale, sizeof(float));
+        }
+
+        char head[128];
+        std::snprintf(head, sizeof(head), "%-24s %-24s %d %d", l.type.c_str(), l.name.c_str(), (int)l.bottoms.size(), (int)l.tops.size());
+        out << head;
+        for (const std::string& b : l.bottoms)
+            out << " " << b;
+        for (const std::string& t : l.tops)
+            out << " " << t;
+        for (const std::string& p : l.params)
+            out << " " << p;
+        out << "\n";
+    }
+    param = out.str();
+}
+
+// Clipping point, in histogram bins, whose 128-level quantization keeps the distribution closest
+// (KL divergence) to the unclipped one - the TensorRT / ncnn2table calibration. p is the histogram
+// clipped at t (outliers folded into its last bin), q the first t bins requantized to `levels`.
+int kl_threshold_bins(const std::vector<double>& hist, int levels)
+{
+    const int bins = (int)hist.size();
+    const double eps = 1e-4;  // keeps empty bins from making the divergence infinite
+    int best = bins;
+    double best_kl = DBL_MAX;
+    for (int t = levels; t <= bins; t++)
+    {
+        std::vector<double> p(hist.begin(), hist.begin() + t);
+        for (int i = t; i < bins; i++)
+            p[t - 1] += hist[i];
+
+        // Each of the `levels` merged bins spread back evenly over the source bins that were non-zero.
+        std::vector<double> q(t, 0.0);
+        for (int j = 0; j < levels; j++)
+        {
+            const int start = j * t / levels;
+            const int end = (j + 1) * t / levels;
+            double sum = 0.0;
+            int nonzero = 0;
+            for (int k = start; k < end; k++)
+            {
+                sum += hist[k];
+                nonzero += hist[k] != 0.0 ? 1 : 0;
+            }
+            for (int k = start; k < end && nonzero > 0; k++)
+            {
+                if (hist[k] != 0.0)
+                    q[k] = sum / nonzero;
+            }
+        }
+
+        double p_sum = 0.0;
+        double q_sum = 0.0;
+        for (int k = 0; k < t; k++)
+        {
+            p[k] += eps;
+            q[k] += eps;
+            p_sum += p[k];
+            q_sum += q[k];
+        }
+        double kl = 0.0;
+        for (int k = 0; k < t; k++)
+            kl += p[k] / p_sum * std::log((p[k] / p_sum) / (q[k] / q_sum));
+        if (kl < best_kl)
+        {
+            best_kl = kl;
+            best = t;
+        }
+    }
+    return best;
+}
+
+// Calibration inputs, letterboxed by the same LetterBoxPlan Yolo26::detect runs.
+class Inputs {
+public:
+    Inputs(const std::vector<std::string>& files, int width, int height, bool raw_bgr)
+        : files_(files),
+          width_(width),
+          height_(height),
+          raw_bgr_(raw_bgr)
+    {
+    }
+
+    size_t size() const { return files_.size(); }
+
+    bool get(size_t i, ncnn::Mat& in)
+    {
+        const cv::Mat bgr = cv::imread(files_[i], cv::IMREAD_COLOR);
+        Yolo26Image src;
+        if (bgr.empty() || !yolo26::resolve_image(yolo26_image_from_mat(bgr), src))
+            return false;
+        const std::shared_ptr<yolo26::LetterBoxPlan> plan = plans_.get(src.width, src.height, width_, height_, true, true);
+        if (!plan || !plan->valid())
+            return false;
+        yolo26::LetterBoxPlan::Lease lease(*plan);
+        plan->run(src, 114, lease.input(), lease.rows(), raw_bgr_);
+        in = lease.input().clone();
+        return true;
+    }
+
+private:
+    std::vector<std::string> files_;
+    int width_;
+    int height_;
+    bool raw_bgr_;
+    yolo26::LetterBoxPlanCache plans_;
+};
+
+template <typename Fn>
+void for_each_value(const ncnn::Mat& m, const Fn& fn)
+{
+    const int size = m.w * m.h * m.d;
+    for (int q = 0; q < m.c; q++)
+    {
+        const float* p = m.channel(q);
+        for (int i = 0; i < size; i++)
+            fn(p[i]);
+    }
+}
+
+void measurement_options(ncnn::Option& opt, bool int8)
+{
+    opt.num_threads = std::max(1, ncnn::get_big_cpu_count());
+    // Full fp32 elsewhere so the error measured is int8's alone; every blob kept for extraction.
+    opt.use_fp16_packed = false;
+    opt.use_fp16_storage = false;
+    opt.use_fp16_arithmetic = false;
+    opt.use_packing_layout = false;
+    opt.use_int8_inference = int8;
+    opt.lightmode = false;
+}
+
+bool run_outputs(const ncnn::Net& net,
+                 const std::string& input_name,
+                 const ncnn::Mat& in,
+                 const std::vector<std::string>& outputs,
+                 std::vector<ncnn::Mat>& results)
+{
+    ncnn::Extractor ex = net.create_extractor();
+    if (!yolo26::ncnn_input_image(ex, input_name, in))
+        return false;
+    results.resize(outputs.size());
+    for (size_t i = 0; i < outputs.size(); i++)
+    {
+        ncnn::Mat out;
+        if (ex.extract(outputs[i].c_str(), out) != 0)
+            return false;
+        results[i] = out.clone();
+    }
+    return true;
+}
+
+// Mean over images of ||out - ref|| / ||ref||, worst output.
+double output_error(const std::vector<std::vector<ncnn::Mat>>& ref, const std::vector<std::vector<ncnn::Mat>>& out)
+{
+    double worst = 0.0;
+    for (size_t o = 0; !ref.empty() && o < ref[0].size(); o++)
+    {
+        double sum = 0.0;
+        for (size_t i = 0; i < ref.size(); i++)
+        {
+            if (out[i][o].total() != ref[i][o].total())
+                return HUGE_VAL;
+            double diff = 0.0;
+            double norm = 0.0;
+            const float* a = ref[i][o];
+            const float* b = out[i][o];
+            for (size_t k = 0; k < ref[i][o].total(); k++)
+            {
+                diff += (double)(a[k] - b[k]) * (a[k] - b[k]);
+                norm += (double)a[k] * a[k];
+            }
+            sum += norm > 0.0 ? std::sqrt(diff / norm) : std::sqrt(diff);
+        }
+        worst = std::max(worst, sum / ref.size());
+    }
+    return worst;
+}
+
+class Evaluator {
+public:
+    Evaluator(const Model& model, const std::string& input_name, const std::vector<ncnn::Mat>& inputs)
+        : model_(model),
+          input_name_(input_name),
+          inputs_(inputs),
+          outputs_(output_blobs(model))
+    {
+    }
+
+    bool reference()
+    {
+        std::vector<QuantLayer> none;
+        return run(none, false, reference_);
+    }
+
+    // Error of the model with the int8 candidates in `quant`; HUGE_VAL when it cannot run.
+    double error(const std::vector<QuantLayer>& quant)
+    {
+        std::vector<std::vector<ncnn::Mat>> out;
+        if (!run(quant, true, out))
+            return HUGE_VAL;
+        return output_error(reference_, out);
+    }
+
+private:
+    bool run(const std::vector<QuantLayer>& quant, bool int8, std::vector<std::vector<ncnn::Mat>>& results) const
+    {
+        std::string param;
+        std::vector<unsigned char> bin;
+        build_model(model_, quant, param, bin);
+        ncnn::Net net;
+        measurement_options(net.opt, int8);
+        if (net.load_param_mem(param.c_str()) != 0 || net.load_model(bin.data()) == 0)
+            return false;
+        results.resize(inputs_.size());
+        for (size_t i = 0; i < inputs_.size(); i++)
+        {
+            if (!run_outputs(net, input_name_, inputs_[i], outputs_, results[i]))
+                return false;
+        }
+        return true;
+    }
+
+    const Model& model_;
+    std::string input_name_;
+    const std::vector<ncnn::Mat>& inputs_;
+    std::vector<std::string> outputs_;
+    std::vector<std::vector<ncnn::Mat>> reference_;
+};
+
+bool write_file(const std::string& path, const void* data, size_t size)
+{
+    std::FILE* fp = std::fopen(path.c_str(), "wb");
+    if (!fp)
+        return false;
+    const bool ok = std::fwrite(data, 1, size, fp) == size;
+    return std::fclose(fp) == 0 && ok;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 4)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    const std::string param_path = argv[1];
+    const std::string bin_path = argv[2];
+    const std::string image_dir = argv[3];
+
+    std::string out_param = "yolo26-int8.param";
+    std::string out_bin = "yolo26-int8.bin";
+    std::string table_path = "yolo26-int8.table";
+    std::string report_path = "yolo26-int8-report.txt";
+    std::string input_name = "in0";
+    std::string method = "kl";
+    std::vector<std::string> fp32_layers;
+    int width = 640;
+    int height = 640;
+    int max_images = 0;
+    int head_depth = 3;
+    int sensitivity_images = 8;
+    float fp32_error = 0.f;
+    bool raw_bgr = false;
+    int argi = 4;
+    while (argi < argc)
+    {
+        const std::string arg = argv[argi++];
+        if (arg == "--out-param" && argi < argc)
+            out_param = argv[argi++];
+        else if (arg == "--out-bin" && argi < argc)
+            out_bin = argv[argi++];
+        else if (arg == "--table" && argi < argc)
+            table_path = argv[argi++];
+        else if (arg == "--report" && argi < argc)
+            report_path = argv[argi++];
+        else if (arg == "--input-name" && argi < argc)
+            input_name = argv[argi++];
+        else if (arg == "--raw-bgr")
+            raw_bgr = true;
+        else if (arg == "--method" && argi < argc)
+        {
+            method = argv[argi++];
+            if (method != "kl" && method != "minmax")
+                return (print_usage(argv[0]), 1);
+        }
+        else if (arg == "--fp32-layers" && argi < argc)
+        {
+            std::stringstream ss(argv[argi++]);
+            std::string item;
+            while (std::getline(ss, item, ','))
+            {
+                if (!item.empty())
+                    fp32_layers.push_back(item);
+            }
+        }
+        else if (arg == "--width" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], width) || width <= 0)
+                return (print_usage(argv[0]), 1);
+        }
+        else if (arg == "--height" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], height) || height <= 0)
+                return (print_usage(argv[0]), 1);
+        }
+        else if (arg == "--max-images" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], max_images) || max_images < 0)
+                return (print_usage(argv[0]), 1);
+        }
+        else if (arg == "--fp32-head-depth" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], head_depth) || head_depth < 0)
+                return (print_usage(argv[0]), 1);
+        }
+        else if (arg == "--sensitivity-images" && argi < argc)
+        {
+            if (!yolo26_cli::parse_int(argv[argi++], sensitivity_images) || sensitivity_images < 0)
+                return (print_usage(argv[0]), 1);
+        }
+        else if (arg == "--fp32-error" && argi < argc)
+        {
+            if (!yolo26_cli::parse_float(argv[argi++], fp32_error))
+                return (print_usage(argv[0]), 1);
+        }
+        else
+        {
+            return (print_usage(argv[0]), 1);
+        }
+    }
+
+    Model model;
+    if (!read_model(param_path, bin_path, model))
+    {
+        std::fprintf(stderr, "Failed to read model: %s %s\n", param_path.c_str(), bin_path.c_str());
+        return 1;
+    }
+
+    std::vector<QuantLayer> quant;
+    for (int i = 0; i < (int)model.layers.size(); i++)
+    {
+        QuantLayer q;
+        if (quant_candidate(model, i, q))
+            quant.push_back(q);
+    }
+    compute_head_depth(model, quant);
+    if (quant.empty())
+    {
+        std::fprintf(stderr, "No layer to quantize\n");
+        return 1;
+    }
+
+    std::vector<cv::String> found;
+    cv::glob(image_dir + "/*", found, false);
+    std::vector<std::string> files(found.begin(), found.end());
+    std::sort(files.begin(), files.end());
+    if (max_images > 0 && (int)files.size() > max_images)
+        files.resize((size_t)max_images);
+    if (files.empty())
+    {
+        std::fprintf(stderr, "No calibration images in %s\n", image_dir.c_str());
+        return 1;
+    }
+    Inputs inputs(files, width, height, raw_bgr);
+
+    ncnn::Net net;
+    measurement_options(net.opt, false);
+    if (net.load_param(param_path.c_str()) != 0 || net.load_model(model.bin->data()) == 0)
+    {
+        std::fprintf(stderr, "Failed to load model: %s %s\n", param_path.c_str(), bin_path.c_str());
+        return 1;
+    }
+
+    // Activation ranges of every quantized layer's input: max |x| first, then a histogram of |x|
+    // over [0, max] for the KL search.
+    const int bins = 2048;
+    struct BlobStats {
+        float absmax = 0.f;
+        std::vector<double> hist;
+    };
+    std::map<std::string, BlobStats> blobs;
+    for (const QuantLayer& q : quant)
+        blobs[q.bottom].hist.assign(bins, 0.0);
+
+    std::vector<ncnn::Mat> sensitivity_inputs;
+    size_t used = 0;
+    for (int pass = 0; pass < (method == "kl" ? 2 : 1); pass++)
+    {
+        used = 0;
+        for (size_t i = 0; i < inputs.size(); i++)
+        {
+            ncnn::Mat in;
+            if (!inputs.get(i, in))
+            {
+                if (pass == 0)
+                    std::fprintf(stderr, "Skipping unreadable image: %s\n", files[i].c_str());
+                continue;
+            }
+            if (pass == 0 && (int)sensitivity_inputs.size() < sensitivity_images)
+                sensitivity_inputs.push_back(in);
+
+            ncnn::Extractor ex = net.create_extractor();
+            if (!yolo26::ncnn_input_image(ex, input_name, in))
+            {
+                std::fprintf(stderr, "Input blob not found: %s\n", input_name.c_str());
+                return 1;
+            }
+            for (std::map<std::string, BlobStats>::iterator it = blobs.begin(); it != blobs.end(); ++it)
+            {
+                ncnn::Mat x;
+                if (ex.extract(it->first.c_str(), x) != 0)
+                    return 1;
+                BlobStats& b = it->second;
+                if (pass == 0)
+                {
+                    for_each_value(x, [&b](float v) { b.absmax = std::max(b.absmax, std::fabs(v)); });
+                }
+                else if (b.absmax > 0.f)
+                {
+                    const float per_bin = bins / b.absmax;
+                    for_each_value(x, [&b, per_bin, bins](float v) {
+                        if (v != 0.f)
+                            b.hist[std::min(bins - 1, (int)(std::fabs(v) * per_bin))] += 1.0;
+                    });
+                }
+            }
+            used++;
+        }
+        std::fprintf(stderr, "calibration pass %d: %d images\n", pass + 1, (int)used);
+    }
+    if (used == 0)
+    {
+        std::fprintf(stderr, "No readable calibration image\n");
+        return 1;
+    }
+
+    for (QuantLayer& q : quant)
+    {
+        const BlobStats& b = blobs[q.bottom];
+        float threshold = b.absmax;
+        if (method == "kl" && b.absmax > 0.f)
+            threshold = (kl_threshold_bins(b.hist, 128) + 0.5f) * b.absmax / bins;
+        q.bottom_scale = threshold > 0.f ? 127.f / threshold : 1.f;
+    }
+
+    // Sensitivity: each layer quantized on its own, everything else fp32.
+    Evaluator evaluator(model, input_name, sensitivity_inputs);
+    const bool measure = !sensitivity_inputs.empty();
+    if (measure && !evaluator.reference())
+    {
+        std::fprintf(stderr, "fp32 reference run failed\n");
+        return 1;
+    }
+    for (size_t i = 0; measure && i < quant.size(); i++)
+    {
+        std::vector<QuantLayer> one = quant;
+        for (size_t j = 0; j < one.size(); j++)
+            one[j].int8 = j == i;
+        quant[i].error = evaluator.error(one);
+    }
+
+    for (QuantLayer& q : quant)
+    {
+        const std::string& name = model.layers[q.index].name;
+        q.int8 = q.head_depth > head_depth && std::find(fp32_layers.begin(), fp32_layers.end(), name) == fp32_layers.end()
+                 && !(fp32_error > 0.f && q.error > fp32_error);
+    }
+    const double final_error = measure ? evaluator.error(quant) : -1.0;
+
+    std::string param;
+    std::vector<unsigned char> bin;
+    build_model(model, quant, param, bin);
+    if (!write_file(out_param, param.data(), param.size()) || !write_file(out_bin, bin.data(), bin.size()))
+    {
+        std::fprintf(stderr, "Failed to write %s / %s\n", out_param.c_str(), out_bin.c_str());
+        return 1;
+    }
+
+    std::ostringstream table;
+    for (const QuantLayer& q : quant)
+    {
+        if (!q.int8)
+            continue;
+        table << model.layers[q.index].name << "_param_0";
+        for (float s : q.weight_scales)
+            table << " " << s;
+        table << "\n";
+    }
+    for (const QuantLayer& q : quant)
+    {
+        if (q.int8)
+            table << model.layers[q.index].name << " " << q.bottom_scale << "\n";
+    }
+    const std::string table_text = table.str();
+    if (!write_file(table_path, table_text.data(), table_text.size()))
+    {
+        std::fprintf(stderr, "Failed to write %s\n", table_path.c_str());
+        return 1;
+    }
+
+    // Report: most sensitive layers first.
+    std::vector<const QuantLayer*> order;
+    int int8_layers = 0;
+    for (const QuantLayer& q : quant)
+    {
+        order.push_back(&q);
+        int8_layers += q.int8 ? 1 : 0;
+    }
+    std::stable_sort(order.begin(), order.end(), [](const QuantLayer* a, const QuantLayer* b) { return a->error > b->error; });
+
+    std::ostringstream report;
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-24s %-22s %-6s %-6s %-12s %s\n", "layer", "type", "head", "int8", "error", "input_scale");
+    report << line;
+    for (const QuantLayer* q : order)
+    {
+        const ParamLayer& l = model.layers[q->index];
+        char head[16];
+        if (q->head_depth == INT_MAX)
+            std::snprintf(head, sizeof(head), "-");
+        else
+            std::snprintf(head, sizeof(head), "%d", q->head_depth);
+        char error[32];
+        if (q->error < 0.0)
+            std::snprintf(error, sizeof(error), "-");
+        else
+            std::snprintf(error, sizeof(error), "%.6f", q->error);
+        std::snprintf(line,
+                      sizeof(line),
+                      "%-24s %-22s %-6s %-6s %-12s %.4f\n",
+                      l.name.c_str(),
+                      l.type.c_str(),
+                      head,
+                      q->int8 ? "yes" : "no",
+                      error,
+                      q->bottom_scale);
+        report << line;
+    }
+    std::snprintf(line,
+                  sizeof(line),
+                  "int8 layers %d / %d, method %s, %d calibration images; final output error %s\n",
+                  int8_layers,
+                  (int)quant.size(),
+                  method.c_str(),
+                  (int)used,
+                  final_error < 0.0 ? "-" : std::to_string(final_error).c_str());
+    report << line;
+    const std::string report_text = report.str();
+    std::fputs(report_text.c_str(), stdout);
+    if (!write_file(report_path, report_text.data(), report_text.size()))
+    {
+        std::fprintf(stderr, "Failed to write %s\n", report_path.c_str());
+        return 1;
+    }
+    std::fprintf(stderr, "Wrote %s, %s, %s and %s\n", out_param.c_str(), out_bin.c_str(), table_path.c_str(), report_path.c_str());
+    return 0;
+}
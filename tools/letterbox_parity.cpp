@@ -0,0 +1,197 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "yolo26_preprocess.h"
+
+static void print_usage(const char* prog)
+{
+    std::fprintf(stderr,
+                 "Usage: %s <img_w> <img_h> <input_w> <input_h> <scaleup:0|1> <center:0|1> <seed> <out_dir> [format]\n"
+                 "  format: bgr (default) | rgb | bgra | rgba | gray | nv12 | nv21 | i420 | roi | raw\n",
+                 prog);
+}
+
+static bool write_f32(const std::string& path, const ncnn::Mat& m)
+{
+    std::FILE* fp = std::fopen(path.c_str(), "wb");
+    if (!fp)
+        return false;
+    bool ok = true;
+    for (int c = 0; c < m.c && ok; c++)
+    {
+        const float* p = m.channel(c);
+        const size_t count = (size_t)m.w * (size_t)m.h;
+        ok = std::fwrite(p, sizeof(float), count, fp) == count;
+    }
+    std::fclose(fp);
+    return ok;
+}
+
+static bool write_info(const std::string& path, const yolo26::LetterBoxInfo& lb)
+{
+    std::ofstream ofs(path.c_str(), std::ios::out);
+    if (!ofs.is_open())
+        return false;
+    ofs << lb.gain << " " << lb.pad_x << " " << lb.pad_y << " " << lb.resized_w << " " << lb.resized_h << " "
+        << lb.input_w << " " << lb.input_h << "\n";
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 9 && argc != 10)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    const int img_w = std::atoi(argv[1]);
+    const int img_h = std::atoi(argv[2]);
+    const int input_w = std::atoi(argv[3]);
+    const int input_h = std::atoi(argv[4]);
+    const bool scaleup = std::atoi(argv[5]) != 0;
+    const bool center = std::atoi(argv[6]) != 0;
+    const uint32_t seed = (uint32_t)std::strtoul(argv[7], 0, 10);
+    const std::string out_dir = argv[8];
+    const std::string format = argc == 10 ? argv[9] : "bgr";
+
+    if (img_w <= 0 || img_h <= 0 || input_w <= 0 || input_h <= 0)
+        return 2;
+    const bool is_yuv = format == "nv12" || format == "nv21" || format == "i420";
+    if (is_yuv && (img_w % 2 != 0 || img_h % 2 != 0))
+        return 2;
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> dist(0, 255);
+
+    // Random source in the requested format, plus the BGR image the reference path sees.
+    cv::Mat src;
+    cv::Mat bgr;
+    Yolo26Image view;
+    if (is_yuv)
+    {
+        src = cv::Mat(img_h * 3 / 2, img_w, CV_8UC1);
+        for (int y = 0; y < src.rows; y++)
+        {
+            unsigned char* p = src.ptr<unsigned char>(y);
+            for (int x = 0; x < img_w; x++)
+                p[x] = (unsigned char)dist(rng);
+        }
+        int code = cv::COLOR_YUV2BGR_NV12;
+        view.format = Yolo26PixelFormat::NV12;
+        if (format == "nv21")
+        {
+            code = cv::COLOR_YUV2BGR_NV21;
+            view.format = Yolo26PixelFormat::NV21;
+        }
+        else if (format == "i420")
+        {
+            code = cv::COLOR_YUV2BGR_I420;
+            view.format = Yolo26PixelFormat::I420;
+        }
+        cv::cvtColor(src, bgr, code);
+        view.data = src.data;
+        view.width = img_w;
+        view.height = img_h;
+    }
+    else
+    {
+        // "roi" letterboxes a strided view into a larger frame.
+        const int border = format == "roi" ? 9 : 0;
+        cv::Mat frame(img_h + border * 2, img_w + border * 3, CV_8UC3);
+        for (int y = 0; y < frame.rows; y++)
+        {
+            unsigned char* p = frame.ptr<unsigned char>(y);
+            for (int x = 0; x < frame.cols * 3; x++)
+                p[x] = (unsigned char)dist(rng);
+        }
+        const cv::Mat roi = frame(cv::Rect(border, border, img_w, img_h));
+        bgr = roi.clone();
+
+        if (format == "bgr" || format == "roi" || format == "raw")
+        {
+            src = roi;
+        }
+        else if (format == "rgb")
+        {
+            cv::cvtColor(bgr, src, cv::COLOR_BGR2RGB);
+        }
+        else if (format == "bgra")
+        {
+            cv::cvtColor(bgr, src, cv::COLOR_BGR2BGRA);
+        }
+        else if (format == "rgba")
+        {
+            cv::cvtColor(bgr, src, cv::COLOR_BGR2RGBA);
+        }
+        else if (format == "gray")
+        {
+            cv::cvtColor(bgr, src, cv::COLOR_BGR2GRAY);
+            cv::cvtColor(src, bgr, cv::COLOR_GRAY2BGR);
+        }
+        else
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        view = yolo26_image_from_mat(src);
+        if (format == "rgb")
+            view.format = Yolo26PixelFormat::RGB;
+        else if (format == "rgba")
+            view.format = Yolo26PixelFormat::RGBA;
+    }
+
+    yolo26::LetterBoxInfo lb_ref;
+    ncnn::Mat ref;
+    if (!yolo26::letterbox(bgr, input_w, input_h, 114, scaleup, center, ref, lb_ref))
+        return 3;
+    yolo26::normalize_01_inplace(ref);
+
+    Yolo26Image resolved;
+    if (!yolo26::resolve_image(view, resolved))
+        return 4;
+    yolo26::LetterBoxPlan plan(img_w, img_h, input_w, input_h, scaleup, center);
+    if (!plan.valid())
+        return 4;
+    ncnn::Mat fused(input_w, input_h, 3);
+    std::vector<float> rows(plan.rows_size());
+    // "raw" runs the --fold-preprocess path (BGR, 0..255) and maps it back for the comparison.
+    const bool raw_bgr = format == "raw";
+    plan.run(resolved, 114, fused, rows.data(), raw_bgr);
+    const yolo26::LetterBoxInfo lb_fused = plan.info();
+    if (raw_bgr)
+    {
+        ncnn::Mat rgb(input_w, input_h, 3);
+        for (int c = 0; c < 3; c++)
+        {
+            const float* s = fused.channel(2 - c);
+            float* d = rgb.channel(c);
+            for (int i = 0; i < input_w * input_h; i++)
+                d[i] = s[i] * (1 / 255.f);
+        }
+        fused = rgb;
+    }
+
+    if (ref.w != fused.w || ref.h != fused.h || ref.c != fused.c)
+        return 5;
+
+    if (!write_f32(out_dir + "/ref.bin", ref))
+        return 6;
+    if (!write_f32(out_dir + "/fused.bin", fused))
+        return 7;
+    if (!write_info(out_dir + "/ref_info.txt", lb_ref))
+        return 8;
+    if (!write_info(out_dir + "/fused_info.txt", lb_fused))
+        return 9;
+
+    return 0;
+}
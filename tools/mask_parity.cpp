@@ -116,17 +116,31 @@ int main(int argc, char** argv)
         boxes_orig_f32[(size_t)i * 4 + 3] = b0.y2;
     }
 
-    std::vector<cv::Mat> masks_proc;
-    if (!yolo26::process_mask(protos, masks_in, boxes_in, in_h, in_w, true, masks_proc))
-        return 3;
-
-    std::vector<cv::Mat> masks_scaled;
-    if (!yolo26::scale_masks(masks_proc, orig_h, orig_w, masks_scaled, true))
-        return 4;
-
-    std::vector<cv::Mat> masks_native;
-    if (!yolo26::process_mask_native(protos, masks_in, boxes_orig, orig_h, orig_w, masks_native))
-        return 5;
+    // Yolo26Seg's per-instance path, one MaskScratch reused across all of them. process_mask(upsample)
+    // is instance_mask() at the network input size; an empty mask is all zeros, as in Ultralytics.
+    yolo26::MaskScratch scratch;
+    std::vector<unsigned char> masks_proc((size_t)n * (size_t)in_h * (size_t)in_w, 0);
+    std::vector<unsigned char> masks_scaled((size_t)n * (size_t)orig_h * (size_t)orig_w, 0);
+    std::vector<unsigned char> masks_native((size_t)n * (size_t)orig_h * (size_t)orig_w, 0);
+    cv::Mat mask;
+    for (int i = 0; i < n; i++)
+    {
+        const float* coeffs = masks_in.row(i);
+        bool empty = false;
+        if (!yolo26::instance_mask(protos, coeffs, boxes_in[i], in_h, in_w, in_h, in_w, scratch, mask, empty))
+            return 3;
+        if (!empty)
+            std::copy(mask.data, mask.data + (size_t)in_h * (size_t)in_w, masks_proc.data() + (size_t)i * in_h * in_w);
+
+        if (!yolo26::instance_mask(protos, coeffs, boxes_in[i], in_h, in_w, orig_h, orig_w, scratch, mask, empty))
+            return 4;
+        if (!empty)
+            std::copy(mask.data, mask.data + (size_t)orig_h * (size_t)orig_w, masks_scaled.data() + (size_t)i * orig_h * orig_w);
+
+        if (!yolo26::instance_mask_native(protos, coeffs, boxes_orig[i], orig_h, orig_w, scratch, mask, empty))
+            return 5;
+        std::copy(mask.data, mask.data + (size_t)orig_h * (size_t)orig_w, masks_native.data() + (size_t)i * orig_h * orig_w);
+    }
 
     const std::string protos_path = out_dir + "/protos.bin";
     const std::string masks_in_path = out_dir + "/masks_in.bin";
@@ -145,47 +159,12 @@ int main(int argc, char** argv)
     if (!write_f32(boxes_orig_path, boxes_orig_f32.data(), boxes_orig_f32.size()))
         return 9;
 
-    {
-        std::vector<unsigned char> buf((size_t)n * (size_t)in_h * (size_t)in_w);
-        size_t offset = 0;
-        for (const auto& m : masks_proc)
-        {
-            if (m.empty() || m.type() != CV_8UC1 || m.rows != in_h || m.cols != in_w || !m.isContinuous())
-                return 10;
-            std::copy(m.data, m.data + (size_t)in_h * (size_t)in_w, buf.data() + offset);
-            offset += (size_t)in_h * (size_t)in_w;
-        }
-        if (!write_u8(masks_proc_path, buf.data(), buf.size()))
-            return 11;
-    }
-
-    {
-        std::vector<unsigned char> buf((size_t)n * (size_t)orig_h * (size_t)orig_w);
-        size_t offset = 0;
-        for (const auto& m : masks_scaled)
-        {
-            if (m.empty() || m.type() != CV_8UC1 || m.rows != orig_h || m.cols != orig_w || !m.isContinuous())
-                return 12;
-            std::copy(m.data, m.data + (size_t)orig_h * (size_t)orig_w, buf.data() + offset);
-            offset += (size_t)orig_h * (size_t)orig_w;
-        }
-        if (!write_u8(masks_scaled_path, buf.data(), buf.size()))
-            return 13;
-    }
-
-    {
-        std::vector<unsigned char> buf((size_t)n * (size_t)orig_h * (size_t)orig_w);
-        size_t offset = 0;
-        for (const auto& m : masks_native)
-        {
-            if (m.empty() || m.type() != CV_8UC1 || m.rows != orig_h || m.cols != orig_w || !m.isContinuous())
-                return 14;
-            std::copy(m.data, m.data + (size_t)orig_h * (size_t)orig_w, buf.data() + offset);
-            offset += (size_t)orig_h * (size_t)orig_w;
-        }
-        if (!write_u8(masks_native_path, buf.data(), buf.size()))
-            return 15;
-    }
+    if (!write_u8(masks_proc_path, masks_proc.data(), masks_proc.size()))
+        return 11;
+    if (!write_u8(masks_scaled_path, masks_scaled.data(), masks_scaled.size()))
+        return 13;
+    if (!write_u8(masks_native_path, masks_native.data(), masks_native.size()))
+        return 15;
 
     return 0;
 }
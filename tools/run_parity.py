@@ -16,6 +16,7 @@ def main():
     topk_bin = build_dir / "yolo26_topk_parity"
     nms_bin = build_dir / "yolo26_nms_parity"
     mask_bin = build_dir / "yolo26_mask_parity"
+    letterbox_bin = build_dir / "yolo26_letterbox_parity"
 
     py = sys.executable or "python"
     subprocess.check_call(
@@ -36,6 +37,16 @@ def main():
     subprocess.check_call(
         [py, str(root / "tools/test_mask_parity.py"), "--bin", str(mask_bin), "--seeds", *map(str, args.seeds)]
     )
+    subprocess.check_call(
+        [
+            py,
+            str(root / "tools/test_letterbox_parity.py"),
+            "--bin",
+            str(letterbox_bin),
+            "--seeds",
+            *map(str, args.seeds),
+        ]
+    )
 
 
 if __name__ == "__main__":
@@ -0,0 +1,87 @@
+import argparse
+import subprocess
+import tempfile
+from pathlib import Path
+import numpy as np
+
+
+# (img_w, img_h, input_w, input_h, scaleup, center)
+CASES = [
+    (1920, 1080, 640, 640, 1, 1),
+    (1280, 720, 640, 640, 1, 0),
+    (640, 480, 640, 640, 1, 1),
+    (640, 640, 640, 640, 1, 1),
+    (333, 517, 640, 640, 1, 1),
+    (333, 517, 640, 640, 0, 1),
+    (17, 3, 64, 64, 1, 1),
+]
+
+# (format, img_w, img_h) for the non-BGR sources; all at 640x640 / scaleup / center.
+FORMAT_CASES = [
+    ("rgb", 1280, 720),
+    ("bgra", 1280, 720),
+    ("rgba", 333, 517),
+    ("gray", 1280, 720),
+    ("roi", 1280, 720),
+    ("roi", 333, 517),
+    ("nv12", 1920, 1080),
+    ("nv21", 640, 480),
+    ("i420", 1280, 720),
+    ("raw", 1280, 720),
+    ("raw", 333, 517),
+]
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--bin", required=True, help="Path to yolo26_letterbox_parity binary")
+    ap.add_argument("--seeds", type=int, nargs="*", default=[0, 1, 2])
+    # ncnn's resize uses 11-bit fixed point and rounds to uint8; the fused kernel stays in float.
+    ap.add_argument("--atol", type=float, default=2.0 / 255.0)
+    args = ap.parse_args()
+
+    bin_path = Path(args.bin)
+    if not bin_path.exists():
+        raise SystemExit(f"Binary not found: {bin_path}")
+
+    cases = [(img_w, img_h, input_w, input_h, scaleup, center, "bgr") for img_w, img_h, input_w, input_h, scaleup, center in CASES]
+    cases += [(img_w, img_h, 640, 640, 1, 1, fmt) for fmt, img_w, img_h in FORMAT_CASES]
+
+    for seed in args.seeds:
+        for img_w, img_h, input_w, input_h, scaleup, center, fmt in cases:
+            tag = f"seed={seed} {fmt} {img_w}x{img_h}->{input_w}x{input_h} scaleup={scaleup} center={center}"
+            # OpenCV's YUV conversion is fixed point too; allow one more level of rounding.
+            atol = args.atol + (1.0 / 255.0 if fmt in ("nv12", "nv21", "i420") else 0.0)
+            with tempfile.TemporaryDirectory() as td:
+                td = Path(td)
+                subprocess.check_call(
+                    [
+                        str(bin_path),
+                        str(img_w),
+                        str(img_h),
+                        str(input_w),
+                        str(input_h),
+                        str(scaleup),
+                        str(center),
+                        str(seed),
+                        str(td),
+                        fmt,
+                    ]
+                )
+
+                ref_info = (td / "ref_info.txt").read_text().split()
+                got_info = (td / "fused_info.txt").read_text().split()
+                if ref_info != got_info:
+                    raise SystemExit(f"{tag}: LetterBoxInfo mismatch expected={ref_info} got={got_info}")
+
+                ref = np.fromfile(td / "ref.bin", dtype=np.float32).reshape(3, input_h, input_w)
+                got = np.fromfile(td / "fused.bin", dtype=np.float32).reshape(3, input_h, input_w)
+                diff = float(np.abs(ref - got).max())
+                if diff > atol:
+                    raise SystemExit(f"{tag}: max abs diff {diff:.6f} > {atol:.6f}")
+
+    print("OK")
+
+
+if __name__ == "__main__":
+    main()